@@ -0,0 +1,104 @@
+/*
+ * battery.c
+ *
+ * Battery voltage monitoring with ADC14, see battery.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "battery.h"
+#include "clock.h"
+#include "events.h"
+
+#define BATT_TIMER_TICKS (CLOCK_ACLK_HZ / BATT_SAMPLE_HZ)
+#define BATT_COUNT_TO_MV(count) ((uint16_t)(((uint32_t)(count) * BATT_VREF_MV * (BATT_DIVIDER_TOP + BATT_DIVIDER_BOTTOM)) / \
+                                            (16384UL * BATT_DIVIDER_BOTTOM)))
+
+#define BATT_MEMS (0xFFFFFFFFUL >> (32 - BATT_AVG_SAMPLES))//ADC_MEMx of the sequence
+#define BATT_MEM_LAST ((BATT_MEMS >> 1) + 1)
+#define BATT_INT_LAST ((uint_fast64_t)BATT_MEM_LAST)//ADC_INTx of the last memory, same bit as its ADC_MEMx
+
+static volatile uint16_t battMv = 0;
+static volatile battAlarm_t battAlarmState = BATT_OK;
+
+void batteryInit(void)//starts the background conversions, call after clockInit(), pinInit() and dmaTableInit()
+{
+    //ADC14, A0 into the next memory of the sequence on every TA3_C1 rising edge, compared against the alarm window
+    MAP_ADC14_enableModule();
+    MAP_ADC14_initModule(ADC_CLOCKSOURCE_SMCLK, ADC_PREDIVIDER_1, ADC_DIVIDER_1, ADC_NOROUTE);
+    MAP_ADC14_setResolution(ADC_14BIT);
+    MAP_ADC14_configureMultiSequenceMode(ADC_MEM0, BATT_MEM_LAST, true);//repeat, one trigger per conversion
+    MAP_ADC14_configureConversionMemory(BATT_MEMS, ADC_VREFPOS_AVCC_VREFNEG_VSS, ADC_INPUT_A0, false);
+    MAP_ADC14_setSampleHoldTime(ADC_PULSE_WIDTH_96, ADC_PULSE_WIDTH_96);//4 us, divider source impedance
+    MAP_ADC14_setSampleHoldTrigger(ADC_TRIGGER_SOURCE7, false);//TA3_C1
+    MAP_ADC14_enableSampleTimer(ADC_MANUAL_ITERATION);
+    MAP_ADC14_setComparatorWindowValue(ADC_COMP_WINDOW0, BATT_MV_TO_COUNT(BATT_LOW_MV), BATT_MV_TO_COUNT(BATT_HIGH_MV));
+    MAP_ADC14_enableComparatorWindow(BATT_MEMS, ADC_COMP_WINDOW0);
+    MAP_ADC14_clearInterruptFlag(ADC_LO_INT | ADC_HI_INT | ADC_IN_INT | BATT_INT_LAST);
+    MAP_ADC14_enableInterrupt(ADC_LO_INT | ADC_HI_INT | BATT_INT_LAST);
+    MAP_Interrupt_enableInterrupt(INT_ADC14);
+
+    MAP_ADC14_enableConversion();
+
+    batteryTimerStart();
+}
+
+void batteryTimerStart(void)//(re)starts the TIMER_A3 conversion trigger, also used when the HIL test (hil.h) hands TIMER_A3 back
+{
+    //TIMER_A3, up mode from ACLK, CCR1 reset/set gives one rising edge per period
+    TIMER_A3->CTL = TIMER_A_CTL_SSEL__ACLK | TIMER_A_CTL_CLR;
+    TIMER_A3->EX0 = TIMER_A_EX0_IDEX__1;
+    TIMER_A3->CCR[0] = BATT_TIMER_TICKS - 1;
+    TIMER_A3->CCR[1] = BATT_TIMER_TICKS / 2;
+    TIMER_A3->CCTL[1] = TIMER_A_CCTLN_OUTMOD_7;
+    TIMER_A3->CTL |= TIMER_A_CTL_MC__UP;
+}
+
+uint16_t batteryMillivolts(void)//latest average, 0 until the first BATT_AVG_SAMPLES conversions are in
+{
+    return battMv;
+}
+
+battAlarm_t batteryAlarm(void)
+{
+    return battAlarmState;
+}
+
+static void battAverage(void)//straight from the conversion memories, the first of the next sequence is a sample period away
+{
+    uint32_t sum = 0;
+    uint8_t k;
+
+    for(k = 0; k < BATT_AVG_SAMPLES; k++)
+    {
+        sum += ADC14->MEM[k] & 0x3FFF;
+    }
+    battMv = BATT_COUNT_TO_MV(sum / BATT_AVG_SAMPLES);
+}
+
+void ADC14_IRQHandler(void)//Last memory of the sequence converted, or the window comparator saw a single conversion leave or re-enter the window
+{
+    uint_fast64_t status = MAP_ADC14_getEnabledInterruptStatus();
+
+    MAP_ADC14_clearInterruptFlag(status);
+    if(status & BATT_INT_LAST)
+    {
+        battAverage();
+    }
+    if(status & (ADC_LO_INT | ADC_HI_INT))//alarm, now wait for the voltage to come back instead of interrupting every conversion
+    {
+        battAlarmState = (status & ADC_LO_INT) ? BATT_LOW : BATT_HIGH;
+        MAP_ADC14_disableInterrupt(ADC_LO_INT | ADC_HI_INT);
+        MAP_ADC14_clearInterruptFlag(ADC_IN_INT);
+        MAP_ADC14_enableInterrupt(ADC_IN_INT);
+        eventPost(EVENT_BATTERY);
+    }
+    else if(status & ADC_IN_INT)//back inside the window
+    {
+        battAlarmState = BATT_OK;
+        MAP_ADC14_disableInterrupt(ADC_IN_INT);
+        MAP_ADC14_clearInterruptFlag(ADC_LO_INT | ADC_HI_INT);
+        MAP_ADC14_enableInterrupt(ADC_LO_INT | ADC_HI_INT);
+        eventPost(EVENT_BATTERY);
+    }
+}
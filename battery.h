@@ -0,0 +1,46 @@
+/*
+ * battery.h
+ *
+ * Battery voltage on P5.5 (A0) through the board divider, measured with no CPU in steady state.
+ * TIMER_A3 runs from ACLK in up mode and its CCR1 output triggers ADC14 at BATT_SAMPLE_HZ, ADC14
+ * is in repeat sequence mode over MEM0 to MEM(BATT_AVG_SAMPLES - 1) of the same input so every
+ * trigger is one conversion into the next memory, and the ADC14 conversion memories are the
+ * averaging buffer. The interrupt of the last memory only runs once per BATT_AVG_SAMPLES
+ * conversions to average them, the next sequence takes a whole sample period to reach MEM0 again.
+ * No DMA channel is used, channel 7 belongs to the ECU link (ecu.h).
+ * The ADC14 window comparator checks every single conversion against the low / high limits, so
+ * a low voltage warning fires on the first bad sample instead of waiting for an average.
+ */
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Battery settings
+#define BATT_SAMPLE_HZ 128          //conversions per second
+#define BATT_AVG_SAMPLES 16         //conversions per average, power of 2, at most the 32 ADC14 memories
+#define BATT_VREF_MV 3300           //AVCC reference
+#define BATT_DIVIDER_TOP 10000      //ohms, battery to A0
+#define BATT_DIVIDER_BOTTOM 2000    //ohms, A0 to ground
+#define BATT_LOW_MV 11800           //alarm below this
+#define BATT_HIGH_MV 15000          //alarm above this, charging fault
+
+//ADC counts for a battery voltage, 14 bit conversion
+#define BATT_MV_TO_COUNT(mv) ((uint16_t)(((uint32_t)(mv) * 16384 * BATT_DIVIDER_BOTTOM) / \
+                                         ((uint32_t)BATT_VREF_MV * (BATT_DIVIDER_TOP + BATT_DIVIDER_BOTTOM))))
+
+typedef enum
+{
+    BATT_OK,
+    BATT_LOW,
+    BATT_HIGH
+} battAlarm_t;
+
+void batteryInit(void);
+void batteryTimerStart(void);
+uint16_t batteryMillivolts(void);
+battAlarm_t batteryAlarm(void);
+
+#endif /* BATTERY_H_ */
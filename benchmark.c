@@ -0,0 +1,195 @@
+/*
+ * benchmark.c
+ *
+ * Timing regression workloads and their report, see benchmark.h.
+ * Everything here runs in the main loop.
+ */
+
+#include "msp.h"
+#include "benchmark.h"
+
+#ifdef BENCH_ENABLE
+
+#include "lightstrip.h"
+#include "meter.h"
+#include "tach.h"
+#include "tach_filter.h"
+#include "fram.h"
+#include "serial.h"
+#include "memstat.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    uint32_t budget;
+    uint32_t (*run)(uint8_t run);   //one run, returns its cycles
+} benchDef_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total;
+} benchStats_t;
+
+static uint32_t benchRender(uint8_t run);
+static uint32_t benchBar(uint8_t run);
+static uint32_t benchRpm(uint8_t run);
+static uint32_t benchFilter(uint8_t run);
+static uint32_t benchFram(uint8_t run);
+static uint32_t benchUart(uint8_t run);
+
+static const benchDef_t benchDefs[BENCH_CASES] =
+{
+    {"render", BENCH_RENDER_BUDGET, benchRender},
+    {"bar", BENCH_BAR_BUDGET, benchBar},
+    {"rpm", BENCH_RPM_BUDGET, benchRpm},
+    {"filter", BENCH_FILTER_BUDGET, benchFilter},
+    {"fram", BENCH_FRAM_BUDGET, benchFram},
+    {"uart", BENCH_UART_BUDGET, benchUart}
+};
+static const uint16_t benchRpms[] = {1000, 3000, 6000, 9000, 11000, 13000};
+extern uint8_t benchTextSize, benchConstSize;//SIZE() of .text and .const, msp432p401r.cmd, only ever take & of them
+
+static benchStats_t benchStats[BENCH_CASES];
+static uint8_t benchBlock[FRAM_HEADER_BYTES + BENCH_FRAM_BYTES];//framWriteBlock() header room, then the data
+static uint8_t benchLine[BENCH_UART_BYTES];
+static tachSample_t benchSample;
+static volatile uint32_t benchSink;//keeps the results of the pure cases from being optimized away
+
+static uint32_t benchRender(uint8_t run)
+{
+    uint8_t lit = (run & 1) ? NUM_LEDS : 0;
+    uint32_t start;
+    uint8_t k;
+
+    while(!lsQuiet());
+    start = DWT->CYCCNT;
+    for(k = 0; k < NUM_LEDS; k++)
+    {
+        lsSetPacked(k, (k < lit) ? meterPalette[k] : LS_LED_OFF);
+    }
+    lsShow();
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t benchBar(uint8_t run)
+{
+    uint32_t start;
+
+    while(!lsQuiet());
+    start = DWT->CYCCNT;
+    lsShowBar((run & 1) ? NUM_LEDS : 0);
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t benchRpm(uint8_t run)
+{
+    uint32_t count = TACH_RPM_TO_COUNT(benchRpms[run % (sizeof(benchRpms) / sizeof(benchRpms[0]))]);
+    uint32_t start = DWT->CYCCNT;
+
+    benchSink = meterLeds(count) + tachCountToRPM(count);
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t benchFilter(uint8_t run)
+{
+    uint32_t start;
+
+    benchSample.period = TACH_RPM_TO_COUNT(6000) + ((run & 3) * 20);//a few counts of ignition jitter
+    benchSample.timestamp += benchSample.period;
+    start = DWT->CYCCNT;
+    benchSink = tachFilter(&benchSample);
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t benchFram(uint8_t run)
+{
+    volatile bool done = 0;
+    uint32_t start;
+
+    memset(&benchBlock[FRAM_HEADER_BYTES], run, BENCH_FRAM_BYTES);
+    while(framBusy());//the queue to ourselves, and the FRAM awake after the first run
+    start = DWT->CYCCNT;
+    framWriteBlock(BENCH_FRAM_BASE, benchBlock, BENCH_FRAM_BYTES, &done);
+    while(!done);
+    return DWT->CYCCNT - start;
+}
+
+static uint32_t benchUart(uint8_t run)
+{
+    uint32_t start;
+
+    (void)run;
+    while(serialBusy());
+    start = DWT->CYCCNT;
+    serialSend(benchLine, BENCH_UART_BYTES);
+    while(serialBusy());
+    return DWT->CYCCNT - start;
+}
+
+void benchRun(void)//runs every case BENCH_RUNS times, blocking, call from the main loop with the download idle
+{
+    benchStats_t *stats;
+    uint32_t cycles;
+    uint8_t k;
+    uint8_t run;
+
+    memset(benchLine, '#', BENCH_UART_BYTES - 1);
+    benchLine[BENCH_UART_BYTES - 1] = '\n';
+    benchSample.timestamp = tachNow();
+    for(k = 0; k < BENCH_CASES; k++)
+    {
+        stats = &benchStats[k];
+        stats->count = 0;
+        stats->min = 0xFFFFFFFF;
+        stats->max = 0;
+        stats->total = 0;
+        for(run = 0; run < BENCH_RUNS; run++)
+        {
+            cycles = benchDefs[k].run(run);
+            stats->count++;
+            stats->total += cycles;
+            if(cycles < stats->min)
+            {
+                stats->min = cycles;
+            }
+            if(cycles > stats->max)
+            {
+                stats->max = cycles;
+            }
+        }
+    }
+    tachFilterReset();//the benchmark pulse train is not the engine
+}
+
+int benchFormat(uint8_t line, char *text, int size)//"BENCH <name> <runs> <min> <max> <mean> <budget> <0|1 mean within budget>\n" for a case, "BENCH size <text> <const> <ramfunc>\n" for BENCH_CASES, returns the length
+{
+    const benchStats_t *stats = &benchStats[(line < BENCH_CASES) ? line : 0];
+    benchCase_t bench = (benchCase_t)line;
+    uint32_t mean = stats->count ? (stats->total / stats->count) : 0;
+    int n;
+
+    if(line >= BENCH_CASES)
+    {
+        n = snprintf(text, size, "BENCH size %lu %lu %lu", (unsigned long)(uintptr_t)&benchTextSize,
+                     (unsigned long)(uintptr_t)&benchConstSize, (unsigned long)memStatUsed(MEMSTAT_CODE));
+    }
+    else
+    {
+        n = snprintf(text, size, "BENCH %s %lu %lu %lu %lu %lu %u", benchDefs[bench].name, (unsigned long)stats->count,
+                     (unsigned long)(stats->count ? stats->min : 0), (unsigned long)stats->max, (unsigned long)mean,
+                     (unsigned long)benchDefs[bench].budget, (unsigned)(stats->count && (mean <= benchDefs[bench].budget)));
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * benchmark.h
+ *
+ * On-target timing regression suite. Runs a fixed set of workloads on the hot paths BENCH_RUNS
+ * times each and counts every run with the DWT cycle counter (MCLK cycles, 20.8 ns), so two
+ * firmware revisions built in the Benchmark configuration can be compared line by line against
+ * the budgets below:
+ *      render      meter bar drawn into the back buffer and lsShow(), full and empty in turn
+ *      bar         precomputed bar frame through lsShowBar(), full and empty in turn
+ *      rpm         meterLeds() and tachCountToRPM() of one capture period, 1000 to 13000 RPM
+ *      filter      one tachFilter() step on a 6000 RPM pulse train with jitter
+ *      fram        BENCH_FRAM_BYTES framWriteBlock() to BENCH_FRAM_BASE, queued to done
+ *      uart        BENCH_UART_BYTES filler line through serialSend(), queued to serialBusy() clear
+ * The render and bar cases wait for the strips to be quiet and only count the CPU time up to
+ * the DMA start, the fram and uart cases count until the transfer has finished.
+ * The suite is started with the 'N' command of the log download (download.h) and blocks the
+ * main loop for ~20 ms, interrupts stay on so a max can include an ISR; the mean is compared
+ * with the budget. The uart case puts BENCH_RUNS filler lines of '#' on the line ahead of the
+ * report, the report is one "BENCH ..." line per case (benchFormat()) and a last "BENCH size"
+ * line with the flash and RAMFUNC code bytes of the build, so a change of compiler settings
+ * shows up in both. The filter restarts from the next live edge afterwards.
+ * The Benchmark configuration builds with the Release optimization settings, so the cycles are
+ * those of the shipping firmware.
+ * Only compiled in when BENCH_ENABLE is defined (Benchmark configuration).
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+
+//Benchmark settings, budgets are mean MCLK cycles per run
+#define BENCH_RUNS 16
+#define BENCH_FRAM_BASE 0x7FA0      //past the last FRAM region (fram.h), nothing is kept there
+#define BENCH_FRAM_BYTES 64
+#define BENCH_UART_BYTES 64
+#define BENCH_RENDER_BUDGET 4000
+#define BENCH_BAR_BUDGET 1000
+#define BENCH_RPM_BUDGET 300
+#define BENCH_FILTER_BUDGET 400
+#define BENCH_FRAM_BUDGET 4000      //~45 us on the wire at FRAM_SPI_HZ
+#define BENCH_UART_BUDGET 40000     //~700 us on the wire at SERIAL_BAUD
+
+typedef enum
+{
+    BENCH_RENDER,
+    BENCH_BAR,
+    BENCH_RPM,
+    BENCH_FILTER,
+    BENCH_FRAM,
+    BENCH_UART,
+    BENCH_CASES
+} benchCase_t;
+
+#define BENCH_LINES (BENCH_CASES + 1)//report lines, the cases and the code size
+
+#ifdef BENCH_ENABLE
+
+void benchRun(void);
+int benchFormat(uint8_t line, char *text, int size);
+
+#endif
+
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,158 @@
+/*
+ * bluetooth.c
+ *
+ * Bluetooth live telemetry, see bluetooth.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "bluetooth.h"
+#include "timebase.h"
+#include "clock.h"
+
+#define BT_MAX_PAYLOAD 16
+
+//Baud rate generator, oversampling mode, N = SMCLK / BT_BAUD = 24 MHz / 115200 = 208.33
+//BRW = INT(N / 16) = 13, BRF = INT(((N / 16) - BRW) * 16) = 0, BRS = 0x25 for a fraction of 0.33 (users guide table 24-4)
+#define BT_BRW 13
+#define BT_BRF 0
+#define BT_BRS 0x25
+//On the idle SMCLK (clock.h) N = 12 MHz / 115200 = 104.17, BRW = 6, BRF = 8, BRS = 0x20 (users guide table 24-5)
+#define BT_IDLE_BRW 6
+#define BT_IDLE_BRF 8
+#define BT_IDLE_BRS 0x20
+
+static volatile uint8_t btRing[BT_RING_SIZE];
+static volatile uint8_t btHead = 0;//only written by the main loop
+static volatile uint8_t btTail = 0;//only written by EUSCIA3_IRQHandler
+static uint16_t btDropCount = 0;//frames lost to a full ring
+
+static void btRate(uint32_t smclk)//baud rate generator for BT_BAUD from smclk, eUSCI in reset
+{
+    bool idle = (smclk != CLOCK_SMCLK_HZ);
+
+    EUSCI_A3->BRW = idle ? BT_IDLE_BRW : BT_BRW;
+    EUSCI_A3->MCTLW = ((idle ? BT_IDLE_BRS : BT_BRS) << EUSCI_A_MCTLW_BRS_OFS) |
+            ((idle ? BT_IDLE_BRF : BT_BRF) << EUSCI_A_MCTLW_BRF_OFS) |
+            EUSCI_A_MCTLW_OS16;
+}
+
+void btInit(void)//sets up EUSCI_A3, call after clockInit() and pinInit()
+{
+    EUSCI_A3->CTLW0 |= EUSCI_A_CTLW0_SWRST; // Put eUSCI state machine in reset
+    EUSCI_A3->CTLW0 = EUSCI_A_CTLW0_SWRST | // Remain eUSCI state machine in reset
+            EUSCI_A_CTLW0_SSEL__SMCLK;      // SMCLK, UART 8N1 LSB first
+    btRate(clockSmclk());
+    EUSCI_A3->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;    // Initialize USCI state machine, TXIE is only set while the ring has data
+
+    NVIC->ISER[0] = 1 << ((EUSCIA3_IRQn) & 31);
+}
+
+static bool btFrame(uint8_t type, const uint8_t *payload, uint8_t length)//queues a whole frame or nothing
+{
+    uint8_t head = btHead;
+    uint8_t space = (btTail - head - 1) & (BT_RING_SIZE - 1);
+    uint8_t sum = type + length;
+    uint8_t k;
+
+    if(space < (length + 5))
+    {
+        btDropCount++;
+        return 0;
+    }
+    btRing[head] = BT_SYNC0;
+    head = (head + 1) & (BT_RING_SIZE - 1);
+    btRing[head] = BT_SYNC1;
+    head = (head + 1) & (BT_RING_SIZE - 1);
+    btRing[head] = type;
+    head = (head + 1) & (BT_RING_SIZE - 1);
+    btRing[head] = length;
+    head = (head + 1) & (BT_RING_SIZE - 1);
+    for(k = 0; k < length; k++)
+    {
+        btRing[head] = payload[k];
+        head = (head + 1) & (BT_RING_SIZE - 1);
+        sum += payload[k];
+    }
+    btRing[head] = -sum;
+    head = (head + 1) & (BT_RING_SIZE - 1);
+
+    btHead = head;//publish only after the frame is written
+    EUSCI_A3->IE |= EUSCI_A_IE_TXIE;//TXIFG is already set with TXBUF empty, so this starts the ISR
+    return 1;
+}
+
+static uint8_t btPut16(uint8_t *to, uint16_t value)
+{
+    to[0] = value;
+    to[1] = value >> 8;
+    return 2;
+}
+
+static uint8_t btPut32(uint8_t *to, uint32_t value)
+{
+    btPut16(to, value);
+    btPut16(to + 2, value >> 16);
+    return 4;
+}
+
+bool btSendStatus(uint16_t rpm, uint8_t gear, uint16_t batteryMv, uint8_t flags)//queues a status frame, returns 0 if it was dropped
+{
+    uint8_t payload[BT_MAX_PAYLOAD];
+    uint8_t n = 0;
+
+    n += btPut32(&payload[n], millis());
+    n += btPut16(&payload[n], rpm);
+    payload[n++] = gear;
+    n += btPut16(&payload[n], batteryMv);
+    payload[n++] = flags;
+    return btFrame(BT_FRAME_STATUS, payload, n);
+}
+
+bool btSendShift(const shiftRecord_t *shift)//queues a shift frame, returns 0 if it was dropped
+{
+    uint8_t payload[BT_MAX_PAYLOAD];
+    uint8_t n = 0;
+
+    n += btPut32(&payload[n], shift->timestamp);
+    n += btPut16(&payload[n], shift->rpm);
+    n += btPut16(&payload[n], shift->latencyUs);
+    payload[n++] = shift->gear;
+    payload[n++] = shift->dir;
+    payload[n++] = shift->retries;
+    payload[n++] = shift->faulted;
+    return btFrame(BT_FRAME_SHIFT, payload, n);
+}
+
+bool btBusy(void)//1 while the ring still has bytes for the module
+{
+    return btHead != btTail;
+}
+
+void btSetClock(uint32_t smclk)//keeps BT_BAUD on a new SMCLK, call with the ring empty (power.c)
+{
+    uint16_t ie = EUSCI_A3->IE;//the reset clears it
+
+    EUSCI_A3->CTLW0 |= EUSCI_A_CTLW0_SWRST;
+    btRate(smclk);
+    EUSCI_A3->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;
+    EUSCI_A3->IE = ie;
+}
+
+uint16_t btDropped(void)//frames dropped because the link could not keep up
+{
+    return btDropCount;
+}
+
+void EUSCIA3_IRQHandler(void)//Bluetooth TX, one byte per TXIFG
+{
+    uint8_t tail = btTail;
+
+    if(tail == btHead)//ring empty, stop until the next frame
+    {
+        EUSCI_A3->IE &= ~EUSCI_A_IE_TXIE;
+        return;
+    }
+    EUSCI_A3->TXBUF = btRing[tail];//clears TXIFG
+    btTail = (tail + 1) & (BT_RING_SIZE - 1);
+}
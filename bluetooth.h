@@ -0,0 +1,54 @@
+/*
+ * bluetooth.h
+ *
+ * Live telemetry to the pit over the Bluetooth module on EUSCI_A3 (P9.6 RX, P9.7 TX) at BT_BAUD, 8N1.
+ * Frames are packed into a TX ring by the main loop and drained one byte per TXIFG by the
+ * EUSCI_A3 interrupt, so queueing a frame is a few stores and never waits on the line. A frame that
+ * does not fit in the ring is dropped whole, the pit side never sees a partial frame.
+ *
+ * Frame layout, little endian, packed:
+ *      0   uint8   BT_SYNC0
+ *      1   uint8   BT_SYNC1
+ *      2   uint8   type, BT_FRAME_x
+ *      3   uint8   payload length
+ *      4   payload
+ *      n   uint8   checksum, all bytes from type to the end of the payload sum to 0 with it
+ *
+ * BT_FRAME_STATUS, every 1000 / BT_STATUS_HZ ms:
+ *      uint32 millis(), uint16 RPM, uint8 gear, uint16 battery mV, uint8 flags (BT_STATUS_x)
+ * BT_FRAME_SHIFT, once per finished shift:
+ *      uint32 millis() at the paddle, uint16 RPM, uint16 paddle to hall latency us, uint8 gear,
+ *      uint8 direction (0 up, 1 down), uint8 retries, uint8 faulted
+ */
+
+#ifndef BLUETOOTH_H_
+#define BLUETOOTH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "shift.h"
+
+//Bluetooth settings
+#define BT_BAUD 115200
+#define BT_STATUS_HZ 10             //status frame rate
+#define BT_RING_SIZE 128            //bytes, power of 2
+
+#define BT_SYNC0 0xA5
+#define BT_SYNC1 0x5A
+#define BT_FRAME_STATUS 0x01
+#define BT_FRAME_SHIFT 0x02
+
+#define BT_STATUS_SHIFT_ZONE 0x01
+#define BT_STATUS_SHIFT_FAULT 0x02
+#define BT_STATUS_BATTERY_ALARM 0x04
+#define BT_STATUS_GEAR_MISMATCH 0x08    //wheel to engine ratio says another gear than gearIndex (wheel.h)
+#define BT_STATUS_ENGINE_ALARM 0x10     //coolant hot or oil pressure low (ecu.h)
+
+void btInit(void);
+bool btSendStatus(uint16_t rpm, uint8_t gear, uint16_t batteryMv, uint8_t flags);
+bool btSendShift(const shiftRecord_t *shift);
+uint16_t btDropped(void);
+bool btBusy(void);
+void btSetClock(uint32_t smclk);
+
+#endif /* BLUETOOTH_H_ */
@@ -0,0 +1,63 @@
+/*
+ * boot.c
+ *
+ * Boot milestone stamps, see boot.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "boot.h"
+#include <stdio.h>
+
+static uint32_t bootStamp[BOOT_MILESTONES];//us since bootInit()
+static uint32_t bootLastCycles = 0;
+static uint32_t bootLastMicros = 0;
+static uint32_t bootCyclesPerUs = 3;//default 3 MHz DCO until clockInit()
+static bool bootDoneFlag = 0;
+
+void bootInit(void)//starts the DWT cycle counter, call first in main()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    bootLastCycles = 0;
+    bootLastMicros = 0;
+    bootCyclesPerUs = SystemCoreClock / 1000000;
+}
+
+void bootMark(bootMilestone_t milestone)//stamps milestone, the cycles since the last mark run at the MCLK rate of the last mark
+{
+    uint32_t cycles = DWT->CYCCNT;
+
+    bootLastMicros += (cycles - bootLastCycles) / bootCyclesPerUs;
+    bootLastCycles = cycles;
+    bootCyclesPerUs = SystemCoreClock / 1000000;//clockInit() only switches MCLK at its very end
+    bootStamp[milestone] = bootLastMicros;
+    if(milestone == (BOOT_MILESTONES - 1))
+    {
+        bootDoneFlag = 1;
+    }
+}
+
+bool bootDone(void)//1 once the last background stage has finished
+{
+    return bootDoneFlag;
+}
+
+int bootFormat(char *text, int size)//"BOOT <us of each milestone>\n", returns the length
+{
+    int n;
+    uint8_t k;
+
+    n = snprintf(text, size, "BOOT");
+    for(k = 0; (k < BOOT_MILESTONES) && (n < size); k++)
+    {
+        n += snprintf(&text[n], size - n, " %lu", (unsigned long)bootStamp[k]);
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
@@ -0,0 +1,40 @@
+/*
+ * boot.h
+ *
+ * Boot milestones. The boot is staged so the driver has a gear and a live tach as early as
+ * possible: the gear is restored on the reset clocks, then the clocks, tach capture, paddles and
+ * lightstrip come up before the main loop starts. The rest (UART, bluetooth, battery ADC,
+ * 4-digit display, the ECU link and the FRAM log scans) runs one stage per main loop pass from a software
+ * timer, so tach edges and shifts are serviced in between.
+ * Each milestone is stamped with the DWT cycle counter, started by bootInit() at the top of
+ * main(), converted at the MCLK rate of the time, so the stamps are us since bootInit()
+ * including the crystal start; the C start up before main() is not counted.
+ * Read them with the 'B' command of the log download (download.h).
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    BOOT_GEAR,                      //gear restored and on the indicator, reset clocks
+    BOOT_CLOCK,                     //48 MHz, timebase running
+    BOOT_LIVE,                      //tach capture, paddles, shift control and lightstrip running
+    BOOT_SERIAL,                    //background stages from here
+    BOOT_BLUETOOTH,
+    BOOT_BATTERY,
+    BOOT_DIGITS,
+    BOOT_ECU,                       //CAN controller receiving, or found missing
+    BOOT_LOGS,                      //wall clock started, shift log and telemetry scanned, every module is up
+    BOOT_MILESTONES
+} bootMilestone_t;
+
+void bootInit(void);
+void bootMark(bootMilestone_t milestone);
+bool bootDone(void);
+int bootFormat(char *text, int size);
+
+#endif /* BOOT_H_ */
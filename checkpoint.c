@@ -0,0 +1,80 @@
+/*
+ * checkpoint.c
+ *
+ * Dash state checkpoints in the FRAM, see checkpoint.h.
+ */
+
+#include "checkpoint.h"
+#include "crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static checkpoint_t checkpointPending;//newest state not yet handed to the FRAM driver
+static bool checkpointDirty = 0;
+static uint16_t checkpointSequence = 0;//sequence number of the next save
+static uint8_t checkpointSlot = 0;//next slot to write
+
+static bool checkpointValid(const checkpoint_t *state)
+{
+    return (state->sequence != 0xFFFF) && (state->gear != 0xFF) && (crcBlock(state, offsetof(checkpoint_t, crc)) == state->crc);
+}
+
+bool checkpointRestore(checkpoint_t *state)//blocking read of the newest valid slot, returns 0 and leaves state alone if there is none
+{
+    checkpoint_t slot[CHECKPOINT_SLOTS];
+    uint8_t newest;
+
+    framRead(CHECKPOINT_BASE, (uint8_t *)&slot[0], sizeof(checkpoint_t));
+    framRead(CHECKPOINT_BASE + CHECKPOINT_SLOT_BYTES, (uint8_t *)&slot[1], sizeof(checkpoint_t));
+
+    if(checkpointValid(&slot[0]) && checkpointValid(&slot[1]))
+    {
+        newest = ((int16_t)(slot[1].sequence - slot[0].sequence) > 0) ? 1 : 0;
+    }
+    else if(checkpointValid(&slot[0]))
+    {
+        newest = 0;
+    }
+    else if(checkpointValid(&slot[1]))
+    {
+        newest = 1;
+    }
+    else
+    {
+        return 0;
+    }
+
+    memcpy(state, &slot[newest], sizeof(checkpoint_t));
+    checkpointSequence = state->sequence + 1;
+    checkpointSlot = newest ^ 1;//overwrite the older copy first
+    return 1;
+}
+
+void checkpointSave(const checkpoint_t *state)//latest state wins, only the newest pending save is written
+{
+    memcpy(&checkpointPending, state, sizeof(checkpoint_t));
+    checkpointDirty = 1;
+    checkpointService();
+}
+
+void checkpointService(void)//queues the pending save, call on EVENT_FRAM_DONE in case the FRAM queue was full
+{
+    if(!checkpointDirty)
+    {
+        return;
+    }
+    if(checkpointSequence == 0xFFFF)
+    {
+        checkpointSequence = 0;
+    }
+    checkpointPending.sequence = checkpointSequence;
+    checkpointPending.spare = 0;
+    checkpointPending.crc = crcBlock(&checkpointPending, offsetof(checkpoint_t, crc));
+    if(framWrite(CHECKPOINT_BASE + ((uint32_t)checkpointSlot * CHECKPOINT_SLOT_BYTES),
+                 (const uint8_t *)&checkpointPending, sizeof(checkpoint_t)))
+    {
+        checkpointDirty = 0;//framWrite() copied the state
+        checkpointSequence++;
+        checkpointSlot ^= 1;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * checkpoint.h
+ *
+ * Dash state that has to survive a reset or brownout: the gear on the indicator and the shift
+ * counters. The state is saved to the FRAM on every change, alternating between two slots so
+ * a write torn by a power loss still leaves the previous copy, each with a sequence number
+ * and a CRC32 (crc.h). Blank FRAM, all 0 or all 1s, never reads as a valid slot.
+ * checkpointRestore() only needs the FRAM SPI port (framPortInit()), so it runs before the
+ * clock bring-up and the gear is back on the indicator within a few ms of power returning.
+ * Saves are small framWrite()s, a save that finds the FRAM queue full is retried from
+ * checkpointService() on EVENT_FRAM_DONE, ahead of the other FRAM users.
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fram.h"
+
+//Checkpoint settings
+#define CHECKPOINT_BASE (FRAM_SIZE_BYTES - CHECKPOINT_BYTES)//last bytes of the FRAM, after the telemetry region
+#define CHECKPOINT_BYTES 0x100
+#define CHECKPOINT_SLOT_BYTES 20
+#define CHECKPOINT_SLOTS 2
+
+typedef struct
+{
+    uint16_t sequence;              //newest slot wins, compared with wrap around
+    uint8_t gear;                   //gearIndex
+    uint8_t spare;
+    uint32_t upshifts;              //finished shifts since the FRAM was blank
+    uint32_t downshifts;
+    uint32_t faults;                //shifts that gave up
+    uint32_t crc;                   //CRC32 of everything before it
+} checkpoint_t;
+
+bool checkpointRestore(checkpoint_t *state);
+void checkpointSave(const checkpoint_t *state);
+void checkpointService(void);
+
+#endif /* CHECKPOINT_H_ */
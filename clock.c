@@ -0,0 +1,81 @@
+/*
+ * clock.c
+ *
+ * 48 MHz clock system bring-up, see clock.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "clock.h"
+#include "timebase.h"
+
+static bool clockHFXTFlag = 0;
+static uint32_t clockSmclkHz = CLOCK_SMCLK_HZ;//follows clockSetIdle()
+
+void clockInit(void)//raises VCORE and flash wait states for 48 MHz, then switches every clock to its final source
+{
+    //HFXT crystal pins PJ.2 and PJ.3
+    MAP_GPIO_setAsPeripheralModuleFunctionOutputPin(GPIO_PORT_PJ, GPIO_PIN2 | GPIO_PIN3, GPIO_PRIMARY_MODULE_FUNCTION);
+    MAP_CS_setExternalClockSourceFrequency(CLOCK_LFXT_HZ, CLOCK_HFXT_HZ);
+
+    if((MAP_PCM_getCoreVoltageLevel() == PCM_VCORE1) && ((CS->CTL1 & CS_CTL1_SELM_MASK) == CS_CTL1_SELM__HFXTCLK) &&
+       !(MAP_CS_getInterruptStatus() & CS_HFXT_FAULT))//soft (watchdog) reset, the clock system kept running on the crystal
+    {
+        clockHFXTFlag = 1;
+        MAP_CS_initClockSignal(CS_MCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);//the reset may have hit while idle, VCORE0 takes the full path below
+        MAP_CS_initClockSignal(CS_HSMCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);
+        MAP_CS_initClockSignal(CS_SMCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_2);
+        SystemCoreClock = CLOCK_MCLK_HZ;
+        return;
+    }
+
+    MAP_PCM_setCoreVoltageLevel(PCM_VCORE1);//LDO VCORE1, mandatory above 24 MHz
+
+    MAP_FlashCtl_setWaitState(FLASH_BANK0, 1);//1 flash wait state (BANK0 VCORE1 max is 16 MHz, BANK1 VCORE1 max is 32 MHz)
+    MAP_FlashCtl_setWaitState(FLASH_BANK1, 1);
+    MAP_FlashCtl_enableReadBuffering(FLASH_BANK0, FLASH_DATA_READ);
+    MAP_FlashCtl_enableReadBuffering(FLASH_BANK0, FLASH_INSTRUCTION_FETCH);
+    MAP_FlashCtl_enableReadBuffering(FLASH_BANK1, FLASH_DATA_READ);
+    MAP_FlashCtl_enableReadBuffering(FLASH_BANK1, FLASH_INSTRUCTION_FETCH);
+
+    clockHFXTFlag = MAP_CS_startHFXTWithTimeout(false, CLOCK_HFXT_TIMEOUT);
+    if(clockHFXTFlag)
+    {
+        MAP_CS_initClockSignal(CS_MCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);
+        MAP_CS_initClockSignal(CS_HSMCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);
+        MAP_CS_initClockSignal(CS_SMCLK, CS_HFXTCLK_SELECT, CS_CLOCK_DIVIDER_2);
+    }
+    else//no crystal, same frequencies from the DCO
+    {
+        MAP_CS_setDCOCenteredFrequency(CS_DCO_FREQUENCY_48);
+        MAP_CS_initClockSignal(CS_MCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+        MAP_CS_initClockSignal(CS_HSMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+        MAP_CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_2);
+    }
+    MAP_CS_initClockSignal(CS_ACLK, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
+
+    SystemCoreClock = CLOCK_MCLK_HZ;
+}
+
+bool clockOnHFXT(void)//0 if the HFXT crystal did not start and the DCO is clocking the system
+{
+    return clockHFXTFlag;
+}
+
+void clockSetIdle(bool idle)//every clock at CLOCK_IDLE_MCLK_HZ (1) or full speed (0), SysTick follows so millis() and micros() keep time
+{                              //VCORE1 has to be up before going to full speed, power.c sequences it with the SMCLK modules
+    uint32_t mclk = idle ? CLOCK_IDLE_MCLK_HZ : CLOCK_MCLK_HZ;
+    uint32_t source = clockHFXTFlag ? CS_HFXTCLK_SELECT : CS_DCOCLK_SELECT;
+
+    MAP_CS_initClockSignal(CS_MCLK, source, idle ? CS_CLOCK_DIVIDER_4 : CS_CLOCK_DIVIDER_1);
+    MAP_CS_initClockSignal(CS_HSMCLK, source, idle ? CS_CLOCK_DIVIDER_4 : CS_CLOCK_DIVIDER_1);
+    MAP_CS_initClockSignal(CS_SMCLK, source, idle ? CS_CLOCK_DIVIDER_4 : CS_CLOCK_DIVIDER_2);
+    clockSmclkHz = idle ? CLOCK_IDLE_SMCLK_HZ : CLOCK_SMCLK_HZ;
+    timebaseSetClock(mclk);
+    SystemCoreClock = mclk;
+}
+
+uint32_t clockSmclk(void)//SMCLK now, CLOCK_SMCLK_HZ or CLOCK_IDLE_SMCLK_HZ
+{
+    return clockSmclkHz;
+}
@@ -0,0 +1,45 @@
+/*
+ * clock.h
+ *
+ * Clock tree for the dashboard. Every timing constant in the firmware is derived from the
+ * frequencies below, clockInit() is what makes them true.
+ *
+ *      MCLK   = HFXT 48 MHz       (DCO 48 MHz if the crystal fails to start)
+ *      HSMCLK = HFXT 48 MHz
+ *      SMCLK  = HFXT / 2 = 24 MHz (24 MHz is the SMCLK limit on the MSP432P401R)
+ *      ACLK   = REFO 32.768 kHz
+ *
+ * With the engine stalled the power manager (power.h) drops the core to VCORE0, which allows
+ * SMCLK 12 MHz at most, and clockSetIdle() runs MCLK, HSMCLK and SMCLK all at
+ * CLOCK_IDLE_MCLK_HZ. The constants below are the running values; the modules clocked from SMCLK
+ * are retimed for the idle clock by the power manager (xSetClock() with clockSmclk()) so their bit
+ * rates and TACH_COUNT_HZ do not change, and SysTick follows MCLK (timebase.h). ACLK stays put.
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Clock settings
+#define CLOCK_LFXT_HZ 32768
+#define CLOCK_HFXT_HZ 48000000
+#define CLOCK_MCLK_HZ 48000000
+#define CLOCK_HSMCLK_HZ 48000000
+#define CLOCK_SMCLK_HZ 24000000
+#define CLOCK_ACLK_HZ 32768
+#define CLOCK_HFXT_TIMEOUT 500000       //CS_startHFXTWithTimeout() loop count before falling back to the DCO
+#define CLOCK_IDLE_DIVIDER 4            //every HFXT clock at 12 MHz with the engine stalled
+#define CLOCK_IDLE_MCLK_HZ (CLOCK_HFXT_HZ / CLOCK_IDLE_DIVIDER)
+#define CLOCK_IDLE_SMCLK_HZ CLOCK_IDLE_MCLK_HZ
+
+#define CLOCK_MCLK_PER_MS (CLOCK_MCLK_HZ / 1000)
+#define CLOCK_SMCLK_PER_US (CLOCK_SMCLK_HZ / 1000000)
+
+void clockInit(void);
+bool clockOnHFXT(void);
+void clockSetIdle(bool idle);
+uint32_t clockSmclk(void);
+
+#endif /* CLOCK_H_ */
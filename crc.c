@@ -0,0 +1,68 @@
+/*
+ * crc.c
+ *
+ * DMA fed hardware CRC32, see crc.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "crc.h"
+
+static bool crcDmaReady = 0;//crcInit() has run
+
+void crcInit(void)//configures DMA CH5 for memory to CRC32DI transfers, call after dmaTableInit()
+{
+    MAP_DMA_assignChannel(DMA_CH5_RESERVED0);
+    MAP_DMA_disableChannelAttribute(DMA_CH5_RESERVED0, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH5_RESERVED0,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);//re-arbitrates every 4 bytes, the per byte peripheral channels get in between
+    crcDmaReady = 1;
+}
+
+void crcBegin(void)
+{
+    MAP_CRC32_setSeed(CRC_SEED, CRC32_MODE);
+}
+
+void crcFeed(const void *data, uint16_t length)//adds length bytes to the CRC in progress
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint16_t run;
+    uint16_t k;
+
+    while(length)
+    {
+        run = (length > CRC_DMA_MAX_BYTES) ? CRC_DMA_MAX_BYTES : length;
+        if(!crcDmaReady || (run < CRC_DMA_MIN_BYTES))
+        {
+            for(k = 0; k < run; k++)
+            {
+                MAP_CRC32_set8BitData(bytes[k], CRC32_MODE);
+            }
+        }
+        else
+        {
+            MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH5_RESERVED0, UDMA_MODE_AUTO, (void *)bytes,
+                                   (void *)&(CRC32->DI32), run);
+            MAP_DMA_enableChannel(CRC_DMA_CHANNEL);
+            MAP_DMA_requestSoftwareTransfer(CRC_DMA_CHANNEL);
+            while(MAP_DMA_isChannelEnabled(CRC_DMA_CHANNEL));//a byte per bus cycle, done in a few us
+            MAP_DMA_clearInterruptFlag(CRC_DMA_CHANNEL);//completion also shows up on DMA_INT0
+        }
+        bytes += run;
+        length -= run;
+    }
+}
+
+uint32_t crcEnd(void)
+{
+    return MAP_CRC32_getResult(CRC32_MODE);
+}
+
+uint32_t crcBlock(const void *data, uint16_t length)//CRC32 of one contiguous run
+{
+    crcBegin();
+    crcFeed(data, length);
+    return crcEnd();
+}
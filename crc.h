@@ -0,0 +1,30 @@
+/*
+ * crc.h
+ *
+ * CRC32 of FRAM blocks and records on the hardware CRC32 module. Runs of data are fed to CRC32DI
+ * by a software triggered auto mode DMA transfer on CH5, so a block costs one DMA request and
+ * a short poll instead of a driverlib call per byte; runs under CRC_DMA_MIN_BYTES are written
+ * by the CPU. A CRC is built with crcBegin(), any number of crcFeed()s and crcEnd(), so a record
+ * can skip its own CRC field.
+ * Only the main loop uses the CRC32 module (params.c shares it in CRC16 mode), so there is no
+ * locking. crcInit() goes after dmaTableInit(), the CPU path works before it.
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include <stdint.h>
+
+//CRC settings
+#define CRC_SEED 0xFFFFFFFF
+#define CRC_DMA_CHANNEL 5
+#define CRC_DMA_MIN_BYTES 16        //shorter runs are quicker from the CPU than setting up the DMA
+#define CRC_DMA_MAX_BYTES 1024      //uDMA transfer size limit
+
+void crcInit(void);
+void crcBegin(void);
+void crcFeed(const void *data, uint16_t length);
+uint32_t crcEnd(void);
+uint32_t crcBlock(const void *data, uint16_t length);
+
+#endif /* CRC_H_ */
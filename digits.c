@@ -0,0 +1,204 @@
+/*
+ * digits.c
+ *
+ * HT16K33 4-digit display driver, see digits.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "digits.h"
+#include "clock.h"
+
+#define DIGITS_CMD_OSC_ON 0x21          //system setup, oscillator on
+#define DIGITS_CMD_DISPLAY_ON 0x81      //display on, no blink
+#define DIGITS_CMD_DIM 0xE0             //| brightness
+#define DIGITS_RAM_BYTES 10             //digit 0, colon, digits 1-3 each take a 16 bit row, low byte used
+#define DIGITS_BLANK 10                 //font index of an empty digit
+#define DIGITS_DP 0x80                  //decimal point segment
+
+static const uint8_t digitsFont[11] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x00};//0-9, blank
+static const uint8_t digitsRow[4] = {0, 2, 6, 8};//RAM address of each digit, 4 is the colon
+
+static uint8_t digitsShown[DIGITS_RAM_BYTES];//display RAM as last written
+static uint8_t digitsTx[DIGITS_RAM_BYTES + 1];//RAM address then data of the write on the bus
+static volatile uint8_t digitsTxLength = 0;
+static volatile uint8_t digitsTxIndex = 0;
+static volatile bool digitsBusyFlag = 0;
+
+static void digitsCommand(uint8_t command)//blocking single byte write, only used from digitsInit()
+{
+    MAP_I2C_masterSendSingleByte(EUSCI_B2_BASE, command);
+    while(MAP_I2C_masterIsStopSent(EUSCI_B2_BASE) == EUSCI_B_I2C_SENDING_STOP);
+}
+
+static void digitsBlank(void)//turns the display on and blanks the whole RAM once so digitsShown matches the display
+{
+    uint8_t k;
+
+    digitsCommand(DIGITS_CMD_OSC_ON);
+    digitsCommand(DIGITS_CMD_DISPLAY_ON);
+    digitsCommand(DIGITS_CMD_DIM | DIGITS_BRIGHTNESS);
+
+    digitsTx[0] = 0;
+    for(k = 0; k < DIGITS_RAM_BYTES; k++)
+    {
+        digitsShown[k] = 0;
+        digitsTx[k + 1] = 0;
+    }
+    MAP_I2C_masterSendMultiByteStart(EUSCI_B2_BASE, digitsTx[0]);
+    for(k = 1; k < DIGITS_RAM_BYTES; k++)
+    {
+        MAP_I2C_masterSendMultiByteNext(EUSCI_B2_BASE, digitsTx[k]);
+    }
+    MAP_I2C_masterSendMultiByteFinish(EUSCI_B2_BASE, digitsTx[DIGITS_RAM_BYTES]);
+    while(MAP_I2C_masterIsStopSent(EUSCI_B2_BASE) == EUSCI_B_I2C_SENDING_STOP);
+}
+
+void digitsInit(bool warm)//sets up EUSCI_B2 as 400 kHz I2C master and turns the display on blank, warm skips the display setup, call after clockInit() and pinInit()
+{
+    const eUSCI_I2C_MasterConfig digitsConfig =
+    {
+        EUSCI_B_I2C_CLOCKSOURCE_SMCLK,
+        clockSmclk(),                       //the engine may have stalled and slowed SMCLK before this boot stage
+        EUSCI_B_I2C_SET_DATA_RATE_400KBPS,
+        0,
+        EUSCI_B_I2C_NO_AUTO_STOP
+    };
+    uint8_t k;
+
+    MAP_I2C_initMaster(EUSCI_B2_BASE, &digitsConfig);
+    MAP_I2C_setSlaveAddress(EUSCI_B2_BASE, DIGITS_ADDRESS);
+    MAP_I2C_setMode(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_MODE);
+    MAP_I2C_enableModule(EUSCI_B2_BASE);
+
+    if(warm)//display has its own supply and kept its setup through the reset, the first update rewrites every digit
+    {
+        for(k = 0; k < DIGITS_RAM_BYTES; k++)
+        {
+            digitsShown[k] = 0xFF;
+        }
+    }
+    else
+    {
+        digitsBlank();
+    }
+
+    MAP_I2C_clearInterruptFlag(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_INTERRUPT0 | EUSCI_B_I2C_NAK_INTERRUPT | EUSCI_B_I2C_STOP_INTERRUPT);
+    MAP_I2C_enableInterrupt(EUSCI_B2_BASE, EUSCI_B_I2C_NAK_INTERRUPT | EUSCI_B_I2C_STOP_INTERRUPT);
+    NVIC->ISER[0] = 1 << ((EUSCIB2_IRQn) & 31);
+}
+
+bool digitsShowRPM(uint16_t rpm)//writes the digits that changed, returns 0 if the last write is still on the bus
+{
+    uint8_t image[DIGITS_RAM_BYTES] = {0};
+    uint8_t font[4];
+    uint8_t first = DIGITS_RAM_BYTES;
+    uint8_t last = 0;
+    bool thousands = (rpm >= 10000);
+    uint8_t k;
+
+    if(digitsBusyFlag)
+    {
+        return 0;
+    }
+
+    if(!thousands)//"1230", leading zeros blank
+    {
+        rpm = rpm / 10;
+        font[3] = 0;
+        font[2] = rpm % 10;
+        font[1] = (rpm >= 10) ? ((rpm / 10) % 10) : DIGITS_BLANK;
+        font[0] = (rpm >= 100) ? (rpm / 100) : DIGITS_BLANK;
+    }
+    else//" 11.5" thousands
+    {
+        rpm = rpm / 100;
+        font[3] = rpm % 10;
+        font[2] = (rpm / 10) % 10;
+        font[1] = (rpm / 100) % 10;
+        font[0] = DIGITS_BLANK;
+    }
+    for(k = 0; k < 4; k++)
+    {
+        image[digitsRow[k]] = digitsFont[font[k]];
+    }
+    if(thousands)//decimal point after the thousands digit
+    {
+        image[digitsRow[2]] |= DIGITS_DP;
+    }
+
+    for(k = 0; k < DIGITS_RAM_BYTES; k++)//span of RAM that differs from the display
+    {
+        if(image[k] != digitsShown[k])
+        {
+            if(k < first)
+            {
+                first = k;
+            }
+            last = k;
+        }
+    }
+    if(first == DIGITS_RAM_BYTES)//nothing changed
+    {
+        return 1;
+    }
+
+    digitsTx[0] = first;
+    for(k = first; k <= last; k++)
+    {
+        digitsTx[k - first + 1] = image[k];
+        digitsShown[k] = image[k];
+    }
+    digitsTxLength = last - first + 2;
+    digitsTxIndex = 0;
+    digitsBusyFlag = 1;
+
+    MAP_I2C_masterSendStart(EUSCI_B2_BASE);//TXIFG0 follows the address, the ISR feeds the rest
+    MAP_I2C_enableInterrupt(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_INTERRUPT0);
+    return 1;
+}
+
+bool digitsBusy(void)
+{
+    return digitsBusyFlag;
+}
+
+void digitsSetClock(uint32_t smclk)//keeps 400 kHz on a new SMCLK, call with !digitsBusy() (power.c)
+{
+    uint16_t ie = EUSCI_B2->IE;//the reset clears it
+
+    EUSCI_B2->CTLW0 |= EUSCI_B_CTLW0_SWRST;
+    EUSCI_B2->BRW = (uint16_t)(smclk / EUSCI_B_I2C_SET_DATA_RATE_400KBPS);//as I2C_initMaster() works it out
+    EUSCI_B2->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;
+    EUSCI_B2->IE = ie;
+}
+
+void EUSCIB2_IRQHandler(void)//Display write, one byte per TXIFG0 then STOP
+{
+    uint_fast16_t status = MAP_I2C_getEnabledInterruptStatus(EUSCI_B2_BASE);
+
+    if(status & EUSCI_B_I2C_NAK_INTERRUPT)//display missing or not ready, give up on this write
+    {
+        MAP_I2C_clearInterruptFlag(EUSCI_B2_BASE, EUSCI_B_I2C_NAK_INTERRUPT);
+        MAP_I2C_disableInterrupt(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_INTERRUPT0);
+        EUSCI_B2->CTLW0 |= EUSCI_B_CTLW0_TXSTP;
+        digitsShown[0] = 0xFF;//unknown now, forces a rewrite from digit 0 next time
+    }
+    if(status & EUSCI_B_I2C_TRANSMIT_INTERRUPT0)
+    {
+        if(digitsTxIndex < digitsTxLength)
+        {
+            EUSCI_B2->TXBUF = digitsTx[digitsTxIndex++];//clears TXIFG0
+        }
+        else//last byte is in the shift register
+        {
+            MAP_I2C_disableInterrupt(EUSCI_B2_BASE, EUSCI_B_I2C_TRANSMIT_INTERRUPT0);
+            EUSCI_B2->CTLW0 |= EUSCI_B_CTLW0_TXSTP;
+        }
+    }
+    if(status & EUSCI_B_I2C_STOP_INTERRUPT)
+    {
+        MAP_I2C_clearInterruptFlag(EUSCI_B2_BASE, EUSCI_B_I2C_STOP_INTERRUPT);
+        digitsBusyFlag = 0;
+    }
+}
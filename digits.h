@@ -0,0 +1,29 @@
+/*
+ * digits.h
+ *
+ * 4-digit numeric RPM readout, HT16K33 7-segment backpack on EUSCI_B2 I2C (P3.6 SDA, P3.7 SCL).
+ * The display keeps its own RAM, so only the span of digits that changed since the last update is
+ * written, as a single multi-byte write fed one byte per TXIFG by the EUSCI_B2 interrupt.
+ * digitsShowRPM() returns straight away and skips an update while the last one is still on the bus,
+ * the next refresh picks up the new value.
+ * Below 10000 RPM the readout is in RPM with the last digit held at 0 so it does not flicker,
+ * from 10000 RPM up it is in thousands with one decimal ("11.5").
+ */
+
+#ifndef DIGITS_H_
+#define DIGITS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Display settings
+#define DIGITS_ADDRESS 0x70         //HT16K33 7 bit address, A0-A2 open
+#define DIGITS_BRIGHTNESS 15        //0-15
+#define DIGITS_REFRESH_HZ 10        //digitsShowRPM() rate from the main loop
+
+void digitsInit(bool warm);
+bool digitsShowRPM(uint16_t rpm);
+bool digitsBusy(void);
+void digitsSetClock(uint32_t smclk);
+
+#endif /* DIGITS_H_ */
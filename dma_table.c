@@ -0,0 +1,35 @@
+/*
+ * dma_table.c
+ *
+ * Shared uDMA control table, see dma_table.h for the channel map.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "dma_table.h"
+#include "ecu.h"
+#include "serial.h"
+
+//8 primary + 8 alternate control structures, the controller requires 1024 byte alignment
+#pragma DATA_ALIGN(dmaControlTable, 1024)
+static DMA_ControlTable dmaControlTable[16];
+
+void dmaTableInit(void)//enables the DMA controller and points it at the shared control table
+{
+    MAP_DMA_enableModule();
+    MAP_DMA_setControlBase(dmaControlTable);
+}
+
+void DMA_INT0_IRQHandler(void)//every channel without a DMA_INT1-3 of its own, the polled ones end up here too
+{
+    uint32_t flags = MAP_DMA_getInterruptStatus();
+
+    DMA_Channel->INT0_CLRFLG = flags;//CRC, FRAM RX and ECU TX completions need nothing more
+    if(flags & (1 << SERIAL_RX_DMA_CHANNEL))//ahead of the ECU, the ring half has the deadline
+    {
+        serialRxDone();
+    }
+    if(flags & (1 << ECU_RX_DMA_CHANNEL))
+    {
+        ecuRxDone();
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * dma_table.h
+ *
+ * Shared uDMA control table for every module that moves data with the DMA controller.
+ * The MSP432 only has one control table, so it lives here instead of in any one driver.
+ *
+ * DMA channel / interrupt use on the dashboard:
+ *      CH0 (EUSCI_A0 TX) -> USB UART transmit, DMA_INT3
+ *      CH1 (EUSCI_A0 RX) -> USB UART receive ring, ping-pong, DMA_INT0
+ *      CH2 (EUSCI_A1 TX) -> FRAM writes and read clocking, DMA_INT2
+ *      CH3 (EUSCI_A1 RX) -> FRAM reads, waited for in DMA_INT2
+ *      CH4 (EUSCI_A2 TX) -> Lightstrip frames, DMA_INT1
+ *      CH5 (software)    -> CRC32 data in (crc.h), polled
+ *      CH6 (EUSCI_B3 TX) -> ECU CAN controller read clocking (ecu.h)
+ *      CH7 (EUSCI_B3 RX) -> ECU CAN controller receive buffer reads, DMA_INT0
+ * DMA_INT0 is raised by every channel without a DMA_INT1-3 of its own, so the polled channels
+ * also set it; its handler here clears every flag and passes the ping-pong halves on to the
+ * serial driver and the finished receive buffer reads on to the ECU link.
+ * The battery averages in the ADC14 memories and the warning light strip is fed from its TX
+ * interrupt, which leaves channels 6 and 7 for EUSCI_B3.
+ */
+
+#ifndef DMA_TABLE_H_
+#define DMA_TABLE_H_
+
+void dmaTableInit(void);
+
+#endif /* DMA_TABLE_H_ */
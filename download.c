@@ -0,0 +1,535 @@
+/*
+ * download.c
+ *
+ * Log download command handling and FRAM to UART streaming, see download.h.
+ * Everything here runs in the main loop.
+ */
+
+#include "download.h"
+#include "serial.h"
+#include "events.h"
+#include "fram.h"
+#include "shiftlog.h"
+#include "telemetry.h"
+#include "profile.h"
+#include "boot.h"
+#include "hil.h"
+#include "shiftpoints.h"
+#include "params.h"
+#include "peak.h"
+#include "logcrypt.h"
+#include "frame.h"
+#include "stats.h"
+#include "memstat.h"
+#include "sched.h"
+#include "program.h"
+#include "rtc.h"
+#include "ecu.h"
+#include "benchmark.h"
+#include "memprotect.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t dlBuffer[2][DL_CHUNK_BYTES];
+static uint16_t dlLength[2] = {0, 0};//bytes waiting in each buffer, 0 = free
+static volatile bool dlReady[2] = {0, 0};//buffer filled, set by the FRAM driver when a dump read lands
+static bool dlCipher[2] = {0, 0};//buffer still has to be encrypted before it is sent
+static uint32_t dlOffset[2];//dump offset of the first byte of each buffer, for the cipher counter
+static uint16_t dlCiphered = 0;//bytes of dlCipherBuffer() encrypted so far
+static uint8_t dlFill = 0;//next buffer to fill
+static uint8_t dlSend = 0;//next buffer to send, buffers go out in the order they were filled
+static bool dlOnWire = 0;//dlBuffer[dlSend] is being sent
+static uint32_t dlAddress = 0;//next FRAM byte of the dump
+static uint32_t dlRemaining = 0;//FRAM bytes of the dump not read yet
+static uint32_t dlBase = 0;//dlAddress at the start of the dump
+static bool dlEncrypt = 0;//dump in progress is encrypted (logcrypt.h)
+static uint8_t dlUpload[LOGCRYPT_UPLOAD_BYTES];//'W', 'K', 'E', 'V' or 'Y' payload, 'E' is the largest
+static uint8_t dlUploadCount = 0;
+static uint8_t dlUploadLength = 0;//payload bytes expected, 0 when the bytes are commands
+static uint8_t dlUploadCommand = 0;
+static bool dlFramed = 0;//command in progress came as a frame, its replies go out framed
+static uint8_t dlFrameType = 0;//type of that frame
+static bool dlResync = 0;//dropping the rest of a bad frame, up to the next FRAME_SYNC or an idle line
+static uint8_t dlStats = DL_STATS_LINES;//next session summary line to send, DL_STATS_LINES when done
+static bool dlStatsLast = 0;//summary in progress is the last session
+static uint8_t dlTask = SCHED_MAX_TASKS;//next task to report, schedCount() or more when done
+#ifdef PROFILE_ENABLE
+static uint8_t dlProfile = PROF_COUNT;//next profile region to report, PROF_COUNT when done
+#endif
+#ifdef BENCH_ENABLE
+static uint8_t dlBench = BENCH_LINES;//next benchmark line to report, BENCH_LINES when done
+#endif
+
+static char *dlText(void)//where a text reply goes in the buffer being filled, after the room for a frame header
+{
+    return (char *)&dlBuffer[dlFill][dlFramed ? FRAME_HEADER_BYTES : 0];
+}
+
+static uint16_t dlTextRoom(void)
+{
+    return dlFramed ? (DL_CHUNK_BYTES - FRAME_OVERHEAD) : DL_CHUNK_BYTES;
+}
+
+static void dlSeal(int length)//queues the length bytes of text at dlText(), framed in place for a framed command
+{
+    if((length <= 0) || (length > dlTextRoom()))
+    {
+        return;
+    }
+    dlLength[dlFill] = dlFramed ? frameBuild(dlBuffer[dlFill], dlFrameType, length) : length;
+    dlReady[dlFill] = 1;
+    dlFill ^= 1;
+}
+
+static void dlReply(const char *text, int length)//queues a text reply through the same buffers as a dump
+{
+    if((length <= 0) || (length > dlTextRoom()))
+    {
+        return;
+    }
+    memcpy(dlText(), text, length);
+    dlSeal(length);
+}
+
+static int dlStatsLine(uint8_t line)//formats session summary line number line at dlText()
+{
+    switch(line)
+    {
+    case 0:
+        return statsFormat(dlStatsLast, dlText(), dlTextRoom());
+    case 1:
+        return statsFormatBins(dlStatsLast, dlText(), dlTextRoom());
+    case 2:
+        return statsFormatLatency(dlStatsLast, SHIFT_UP, dlText(), dlTextRoom());
+    default:
+        return statsFormatLatency(dlStatsLast, SHIFT_DOWN, dlText(), dlTextRoom());
+    }
+}
+
+static bool dlIdle(void)//no reply queued or in progress
+{
+    if((dlStats < DL_STATS_LINES) || (dlTask < schedCount()))
+    {
+        return 0;
+    }
+#ifdef PROFILE_ENABLE
+    if(dlProfile < PROF_COUNT)
+    {
+        return 0;
+    }
+#endif
+#ifdef BENCH_ENABLE
+    if(dlBench < BENCH_LINES)
+    {
+        return 0;
+    }
+#endif
+    return !dlRemaining && !dlLength[0] && !dlLength[1];
+}
+
+static void dlStart(uint32_t address, uint32_t length)
+{
+    char line[40];
+    uint32_t nonce;
+
+    dlEncrypt = logCryptEnabled();
+    if(!dlEncrypt)
+    {
+        dlReply(line, snprintf(line, sizeof(line), "DUMP %lu %lu\n", (unsigned long)address, (unsigned long)length));
+    }
+    else if(logCryptStart(address, &nonce))
+    {
+        dlReply(line, snprintf(line, sizeof(line), "EDUMP %lu %lu %lu\n", (unsigned long)address, (unsigned long)length,
+                               (unsigned long)nonce));
+    }
+    else
+    {
+        dlReply("DUMP BUSY\n", strlen("DUMP BUSY\n"));//FRAM queue full, the nonce could not be saved
+        return;
+    }
+    dlAddress = address;
+    dlBase = address;
+    dlRemaining = length;
+}
+
+static int dlGears(char *text, int size)//"GEARS <start> <shift> ...\n" for every gear, returns the length
+{
+    const meterShiftPoint_t *points = shiftPointsTable();
+    int n = snprintf(text, size, "GEARS");
+    uint8_t gear;
+
+    for(gear = 0; (gear < METER_GEARS) && (n < size); gear++)
+    {
+        n += snprintf(&text[n], size - n, " %u %u", points[gear].startRpm, points[gear].shiftRpm);
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+static uint8_t dlUploadBytes(uint8_t command)//payload that follows a command, 0 for none
+{
+    switch(command)
+    {
+    case 'W':
+        return SHIFTPOINT_TABLE_BYTES;
+    case 'K':
+        return PARAMS_VALUE_BYTES;
+    case 'E':
+        return LOGCRYPT_UPLOAD_BYTES;
+    case 'V':
+        return PROGRAM_SET_BYTES;
+    case 'Y':
+        return RTC_SET_BYTES;
+    default:
+        return 0;
+    }
+}
+
+static void dlUploaded(const uint8_t *payload)//payload of a 'W', 'K', 'E', 'V' or 'Y' command complete, little endian on both ends
+{
+    meterShiftPoint_t points[METER_GEARS];
+    paramValues_t values;
+    const char *reply;
+
+    if(dlUploadCommand == 'W')
+    {
+        memcpy(points, payload, sizeof(points));
+        reply = shiftPointsSet(points) ? "GEARS OK\n" : "GEARS BAD\n";
+    }
+    else if(dlUploadCommand == 'E')
+    {
+        reply = logCryptSetKey(payload, &payload[LOGCRYPT_KEY_BYTES]) ? "KEY OK\n" : "KEY BAD\n";
+        memset(dlUpload, 0, sizeof(dlUpload));//no copy of either key left in the buffer
+    }
+    else if(dlUploadCommand == 'V')
+    {
+        reply = programSet((program_t)payload[0], (uint16_t)(payload[1] | ((uint16_t)payload[2] << 8))) ? "PROGRAM OK\n" : "PROGRAM BAD\n";
+    }
+    else if(dlUploadCommand == 'Y')
+    {
+        reply = rtcSet(payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24)) ?
+                "CLOCK OK\n" : "CLOCK BAD\n";
+    }
+    else
+    {
+        memcpy(&values, payload, sizeof(values));
+        reply = paramsSet(&values) ? "CONFIG OK\n" : "CONFIG BAD\n";
+    }
+    dlReply(reply, strlen(reply));
+}
+
+static void dlUploadStart(uint8_t command)
+{
+    dlUploadCommand = command;
+    dlUploadCount = 0;
+    dlUploadLength = dlUploadBytes(command);
+}
+
+static void dlCommand(uint8_t command)
+{
+    const paramValues_t *values;
+    const peakRecord_t *peaks;
+    char line[96];
+
+    switch(command)
+    {
+    case 'I':
+        dlReply(line, snprintf(line, sizeof(line), "LRD %lu %lu %lu\n", (unsigned long)FRAM_SIZE_BYTES,
+                               (unsigned long)shiftLogCount(), (unsigned long)telemetryBlocks()));
+        break;
+    case 'D':
+        dlStart(0, FRAM_SIZE_BYTES);
+        break;
+    case 'S':
+        dlStart(SHIFTLOG_BASE, SHIFTLOG_BYTES);
+        break;
+    case 'T':
+        dlStart(TELEM_BASE, (uint32_t)TELEM_BLOCKS * TELEM_BLOCK_BYTES);
+        break;
+    case 'B':
+        dlReply(line, bootFormat(line, sizeof(line)));
+        break;
+    case 'G':
+        dlReply(line, dlGears(line, sizeof(line)));
+        break;
+    case 'W':
+        dlUploadStart(command);
+        break;
+    case 'C':
+        values = paramsGet();
+        dlReply(line, snprintf(line, sizeof(line), "CONFIG %u %u %u %u %u %u\n", PARAMS_VERSION, values->brightness,
+                               values->greenLeds, values->yellowLeds, values->redLeds, values->maxRpm));
+        break;
+    case 'K':
+        dlUploadStart(command);
+        break;
+    case 'E':
+        dlUploadStart(command);
+        break;
+    case 'V':
+        dlUploadStart(command);
+        break;
+    case 'Y':
+        dlUploadStart(command);
+        break;
+    case 'U':
+        dlReply(line, rtcFormat(line, sizeof(line)));
+        break;
+    case 'J':
+        dlReply(line, ecuFormat(line, sizeof(line)));
+        break;
+    case 'A':
+    case 'O':
+        dlStatsLast = (command == 'O');
+        dlStats = 0;
+        break;
+    case 'Q':
+        dlTask = 0;
+        break;
+    case 'M':
+        dlSeal(memStatFormat(dlText(), dlTextRoom()));
+        break;
+    case 'F':
+        dlReply(line, memProtectFormat(line, sizeof(line)));
+        break;
+    case 'R':
+        peaks = peakGet();
+        dlReply(line, snprintf(line, sizeof(line), "PEAK %u %u %u %lu\n", peaks->sessionRpm, peaks->lastSessionRpm,
+                               peaks->recordRpm, (unsigned long)peaks->overRevs));
+        break;
+#ifdef PROFILE_ENABLE
+    case 'P':
+        dlProfile = 0;
+        break;
+    case 'Z':
+        profileReset();
+        break;
+#endif
+#ifdef BENCH_ENABLE
+    case 'N':
+        benchRun();
+        dlBench = 0;
+        break;
+#endif
+#ifdef HIL_ENABLE
+    case 'H':
+        hilReset();
+        hilStart();
+        break;
+    case 'L':
+        dlReply(line, hilFormat(line, sizeof(line)));
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+static uint8_t dlCipherBuffer(void)//buffer encrypted next, the one after the buffer on the wire
+{
+    return dlOnWire ? (dlSend ^ 1) : dlSend;
+}
+
+static void dlTransmit(void)//starts the next filled buffer if the UART is free, cipher text only once downloadCrypt() is done with it
+{
+    uint8_t next;
+
+    if(!dlOnWire && dlReady[dlSend] && !dlCipher[dlSend] && serialSend(dlBuffer[dlSend], dlLength[dlSend]))
+    {
+        dlOnWire = 1;
+    }
+    next = dlCipherBuffer();
+    if(dlReady[next] && dlCipher[next])//the read has landed, encrypt it where it is while the other buffer is sent
+    {
+        eventPost(EVENT_CRYPT);
+    }
+}
+
+static void dlByte(uint8_t command)//single byte command
+{
+    if(command == 'X')
+    {
+        dlRemaining = 0;
+    }
+    else if(dlIdle())//one command at a time
+    {
+        dlFramed = 0;
+        dlCommand(command);
+    }
+}
+
+static void dlFrame(const frame_t *frame)//framed command, an upload carries its payload in the frame
+{
+    if(frame->type == 'X')
+    {
+        dlRemaining = 0;
+    }
+    else if(dlIdle() && (frame->length == dlUploadBytes(frame->type)))//one command at a time, whole payload or none
+    {
+        dlFramed = 1;
+        dlFrameType = frame->type;
+        if(frame->length)
+        {
+            dlUploadCommand = frame->type;
+            dlUploaded(frame->payload);//straight from the RX ring
+        }
+        else
+        {
+            dlCommand(frame->type);
+        }
+    }
+}
+
+void downloadCrypt(void)//encrypts the next DL_CRYPT_SLICE_BYTES of a dump chunk, call on EVENT_CRYPT
+{
+    uint8_t buffer = dlCipherBuffer();
+    uint16_t slice;
+
+    if(!dlReady[buffer] || !dlCipher[buffer])
+    {
+        return;
+    }
+    slice = ((dlLength[buffer] - dlCiphered) < DL_CRYPT_SLICE_BYTES) ? (dlLength[buffer] - dlCiphered) : DL_CRYPT_SLICE_BYTES;
+    logCryptApply(&dlBuffer[buffer][dlCiphered], slice, dlOffset[buffer] + dlCiphered);
+    dlCiphered += slice;
+    if(dlCiphered < dlLength[buffer])
+    {
+        eventPost(EVENT_CRYPT);//the rest on the next runs, the higher tasks get in between
+        return;
+    }
+    dlCiphered = 0;
+    dlCipher[buffer] = 0;
+    dlTransmit();
+}
+
+void downloadService(void)//call on EVENT_SERIAL_RX, EVENT_SERIAL_DONE and EVENT_FRAM_DONE
+{
+    const uint8_t *rx;
+    uint16_t count;
+    frame_t frame;
+    frameResult_t result;
+    uint16_t chunk;
+    uint16_t skip;
+    uint8_t k;
+
+    if(dlOnWire && !serialBusy())//last chunk handed to the UART, its buffer is free
+    {
+        dlOnWire = 0;
+        dlLength[dlSend] = 0;
+        dlReady[dlSend] = 0;
+        dlSend ^= 1;
+    }
+    dlTransmit();//keep the line busy before spending time on FRAM reads
+
+    while((count = serialPeek(&rx, FRAME_MAX_BYTES)))//parsed where the DMA put it
+    {
+        if(dlUploadLength)//raw, an 'X' in the payload is data
+        {
+            count = ((dlUploadLength - dlUploadCount) < count) ? (dlUploadLength - dlUploadCount) : count;
+            memcpy(&dlUpload[dlUploadCount], rx, count);
+            if(dlUploadCommand == 'E')//no copy of the key left in the RX ring
+            {
+                serialWipe(count);
+            }
+            else
+            {
+                serialSkip(count);
+            }
+            dlUploadCount += count;
+            if(dlUploadCount == dlUploadLength)
+            {
+                dlUploadLength = 0;
+                dlUploaded(dlUpload);
+            }
+            continue;
+        }
+        if(dlResync)//the rest of a bad frame, none of it is a command
+        {
+            for(skip = 0; (skip < count) && (rx[skip] != FRAME_SYNC); skip++);
+            if(skip)
+            {
+                serialSkip(skip);
+                continue;
+            }
+            dlResync = 0;
+        }
+        if(rx[0] != FRAME_SYNC)
+        {
+            serialSkip(1);
+            dlByte(rx[0]);
+            continue;
+        }
+        result = frameParse(rx, count, &frame);
+        if((result == FRAME_PARTIAL) && !serialIdle())//rest of the frame still coming
+        {
+            break;
+        }
+        if(result != FRAME_OK)//bad, or the line went quiet in the middle of it, drop up to the next sync
+        {
+            serialSkip(1);
+            dlResync = 1;
+            continue;
+        }
+        dlFrame(&frame);
+        if(frame.type == 'E')//no copy of the key left in the RX ring
+        {
+            serialWipe(frame.bytes);
+        }
+        else
+        {
+            serialSkip(frame.bytes);
+        }
+    }
+    if(dlResync && serialIdle())//the line went quiet, whatever comes next starts afresh
+    {
+        dlResync = 0;
+    }
+
+    while((dlStats < DL_STATS_LINES) && !dlLength[dlFill])//one line per free buffer
+    {
+        dlSeal(dlStatsLine(dlStats));
+        dlStats++;
+    }
+    while((dlTask < schedCount()) && !dlLength[dlFill])//one line per task
+    {
+        dlSeal(schedFormat(dlTask, dlText(), dlTextRoom()));
+        dlTask++;
+    }
+#ifdef PROFILE_ENABLE
+    while((dlProfile < PROF_COUNT) && !dlLength[dlFill])//one line per region
+    {
+        dlSeal(profileFormat((profRegion_t)dlProfile, dlText(), dlTextRoom()));
+        dlProfile++;
+    }
+#endif
+#ifdef BENCH_ENABLE
+    while((dlBench < BENCH_LINES) && !dlLength[dlFill])//one line per case, then the code size
+    {
+        dlSeal(benchFormat(dlBench, dlText(), dlTextRoom()));
+        dlBench++;
+    }
+#endif
+    for(k = 0; k < 2; k++)//read ahead while the other buffer is sent
+    {
+        if(!dlRemaining || dlLength[dlFill])
+        {
+            break;
+        }
+        chunk = (dlRemaining > DL_CHUNK_BYTES) ? DL_CHUNK_BYTES : dlRemaining;
+        if(!framReadStart(dlAddress, dlBuffer[dlFill], chunk, &dlReady[dlFill]))//queue full, EVENT_FRAM_DONE brings us back
+        {
+            break;
+        }
+        dlLength[dlFill] = chunk;
+        dlCipher[dlFill] = dlEncrypt;
+        dlOffset[dlFill] = dlAddress - dlBase;
+        dlFill ^= 1;
+        dlAddress += chunk;
+        dlRemaining -= chunk;
+    }
+    dlTransmit();
+}
@@ -0,0 +1,73 @@
+/*
+ * download.h
+ *
+ * Log download over the USB UART. The host sends single byte commands:
+ *      'I' -> "LRD <fram bytes> <shift records> <telemetry blocks>\n"
+ *      'D' -> "DUMP <address> <length>\n" followed by the whole FRAM, raw
+ *      'S' -> same, shift log region only (layout in shiftlog.h)
+ *      'T' -> same, telemetry region only (layout in telemetry.h)
+ *      'X' -> aborts a dump in progress, the reply just stops
+ *      'B' -> "BOOT <us> ...\n", boot milestone stamps in bootMilestone_t order (boot.h)
+ *      'G' -> "GEARS <start rpm> <shift rpm> ...\n", shift points of gears 0 to METER_GEARS - 1 (meter.h)
+ *      'W' -> followed by SHIFTPOINT_TABLE_BYTES of meterShiftPoint_t, little endian, replaces the
+ *             shift points and saves them (shiftpoints.h), "GEARS OK\n" or "GEARS BAD\n"
+ *      'C' -> "CONFIG <version> <brightness> <green> <yellow> <red> <max rpm>\n" (params.h)
+ *      'K' -> followed by PARAMS_VALUE_BYTES of paramValues_t, little endian, replaces the
+ *             parameters and saves them, "CONFIG OK\n" or "CONFIG BAD\n"
+ *      'E' -> followed by LOGCRYPT_UPLOAD_BYTES, the key in use (all zero if none) then the new key,
+ *             "KEY OK\n" or "KEY BAD\n"; an all zero new key turns encryption off (logcrypt.h)
+ *      'V' -> followed by PROGRAM_SET_BYTES, the display program and the launch target RPM, little
+ *             endian, "PROGRAM OK\n" or "PROGRAM BAD\n" (program.h)
+ *      'Y' -> followed by RTC_SET_BYTES, the Unix time in seconds UTC, little endian, sets the wall
+ *             clock as of the last byte, "CLOCK OK\n" or "CLOCK BAD\n" (rtc.h)
+ *      'U' -> "CLOCK <0|1 set> <unix s> <0|1 on the crystal>\n" (rtc.h)
+ *      'J' -> "ECU <0|1 present> <frames> <behind> <rpm> <tps> <map> <lambda> <battery> <air> <coolant>
+ *             <oil>\n", latest ECU values in the ecu.h units, -32768 for no data (ecu.h)
+ *      'A' -> "SESSION 0 <ms> <ms in each gear> <ms above shift> <up> <down> <faults> <mean latency us>\n"
+ *             then "BINS 0 <ms in each RPM bin>\n", then "LATENCY 0 <0 up|1 down> <mean us> <worst us>
+ *             <worst rpm> <worst gear> <shifts in each latency bin>\n" for each direction, the
+ *             running session (stats.h)
+ *      'O' -> same with 1 for the session before this power up
+ *      'M' -> "MEM <stack bytes> <stack peak> <used> <budget> ...\n", SRAM bytes used and budgeted
+ *             for each memStatRegion_t (memstat.h)
+ *      'F' -> "MPU <0|1 faulted before this reset> <address> <MMFSR> <faults since power up>\n", the
+ *             last MemManage fault (memprotect.h)
+ *      'Q' -> one "TASK <name> <runs> <overruns> <mean exec us> <max exec us> <max latency us>
+ *             <deadline us>\n" line per main loop task, highest priority first (sched.h)
+ *      'R' -> "PEAK <session rpm> <last session rpm> <record rpm> <over-revs>\n" (peak.h)
+ *      'P' -> one "PROF ..." line per profiled region (profile.h), Debug builds only
+ *      'Z' -> clears the profile statistics, Debug builds only
+ *      'H' -> clears the latency histogram and starts a tach sweep (hil.h), Debug builds only
+ *      'L' -> "HIL <frames> <min> <max> <mean> <buckets>\n", edge to frame latency in us, Debug builds only
+ *      'N' -> runs the timing benchmark, then one "BENCH <name> <runs> <min> <max> <mean> <budget>
+ *             <0|1 within>\n" line per case in cycles, then "BENCH size <text> <const> <ramfunc>\n"
+ *             in bytes (benchmark.h), Benchmark builds only
+ * Any other byte is ignored, so a terminal can be used to poke it.
+ * The same commands can also come as frames (frame.h) with the command as the type and an
+ * upload's payload in the frame, a frame with the wrong payload length for its command is
+ * ignored. Replies to a framed command are framed with the same type, a dump's data follows its
+ * framed DUMP line raw. A frame has to arrive in one burst, the line going idle for
+ * SERIAL_IDLE_MS ends a partial one.
+ * With a key set 'D', 'S' and 'T' reply "EDUMP <address> <length> <nonce>\n" and the data is
+ * AES-256 counter mode cipher text, or "DUMP BUSY\n" if the nonce could not be queued. A chunk is
+ * encrypted in the background, DL_CRYPT_SLICE_BYTES per scheduler run on EVENT_CRYPT
+ * (downloadCrypt()), while the chunk before it is on the wire, so the download handler never
+ * waits on the AES256 module and higher priority tasks get in between the slices.
+ *
+ * FRAM is read in DL_CHUNK_BYTES chunks into two buffers that alternate, one is read while the
+ * other is sent by DMA, so a dump moves at the UART line rate (32 KB in ~0.4 s at 921600 baud).
+ * FRAM reads wait for any log write on the wire, logging keeps running during a download.
+ */
+
+#ifndef DOWNLOAD_H_
+#define DOWNLOAD_H_
+
+//Download settings
+#define DL_CHUNK_BYTES 256
+#define DL_STATS_LINES 4            //lines in an 'A' or 'O' reply
+#define DL_CRYPT_SLICE_BYTES 64     //encrypted per downloadCrypt() run, a multiple of LOGCRYPT_BLOCK_BYTES
+
+void downloadService(void);
+void downloadCrypt(void);
+
+#endif /* DOWNLOAD_H_ */
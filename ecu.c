@@ -0,0 +1,360 @@
+/*
+ * ecu.c
+ *
+ * MCP2515 CAN controller driver and PE3 frame decoding, see ecu.h.
+ * The receive state is only touched by PORT5_IRQHandler and ecuRxDone() (DMA_INT0), both at
+ * PRIORITY_LOGGING, the main loop reads the channel table with that level masked.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "ecu.h"
+#include "events.h"
+#include "priority.h"
+#include "spi_rate.h"
+#include "clock.h"
+#include "timebase.h"
+#include <stdio.h>
+
+#define ECU_TX_DMA_CHANNEL 6
+#define ECU_CS BIT0             //P10.0
+#define ECU_INT BIT0            //P5.0, low while a receive buffer is full
+#define ECU_PE_MASK 0x1FFFF0FFUL//every PE3 frame, the frame number is ID bits 8-11
+#define ECU_FRAME_BYTES 13      //SIDH, SIDL, EID8, EID0, DLC and 8 data bytes, RXBnSIDH on
+#define ECU_RESET_LOOPS (CLOCK_MCLK_HZ / 1000000 * 100 / 4)//100 us for the MCP2515 oscillator, busy loop passes of at least 4 MCLK cycles
+
+#define MCP_RESET 0xC0
+#define MCP_WRITE 0x02
+#define MCP_READ 0x03
+#define MCP_READ_RX(buffer) (0x90 | ((buffer) << 2))//from RXBnSIDH, clears RXnIF at the end of the read
+#define MCP_READ_STATUS 0xA0
+#define MCP_STATUS_RX0IF 0x01
+#define MCP_STATUS_RX1IF 0x02
+#define MCP_RXF0 0x00           //RXF0-2 at 0x00, 0x04, 0x08, RXF3-5 at 0x10, 0x14, 0x18
+#define MCP_RXM0 0x20           //RXM1 at 0x24
+#define MCP_CANSTAT 0x0E
+#define MCP_CANCTRL 0x0F
+#define MCP_CNF3 0x28           //CNF2, CNF1 and CANINTE follow
+#define MCP_RXB0CTRL 0x60
+#define MCP_RXB1CTRL 0x70
+#define MCP_MODE_MASK 0xE0
+#define MCP_MODE_NORMAL 0x00
+#define MCP_MODE_LISTEN 0x60
+#define MCP_MODE_CONFIG 0x80
+#define MCP_CANINTE_RX 0x03     //RX0IE, RX1IE
+#define MCP_RXB0_ROLLOVER 0x04  //filters on, BUKT: a frame finding buffer 0 full goes to buffer 1
+
+typedef struct
+{
+    int16_t value;
+    uint32_t stamp;                 //millis() it was decoded
+} ecuValue_t;
+
+static volatile ecuValue_t ecuTable[ECU_CHANNELS];
+static volatile uint16_t ecuSeen = 0;//bit per channel, decoded at least once
+static volatile uint32_t ecuFrames = 0;
+static volatile uint32_t ecuBehind = 0;//reads that found both receive buffers full, the next frame would have been lost
+static volatile bool ecuBusyFlag = 0;//a receive buffer read is on the wire
+static volatile bool ecuAlertShown = 0;
+static uint8_t ecuRx[ECU_FRAME_BYTES];//DMA landing buffer, decoded in place
+static const uint8_t ecuDummy = 0;//clocked out during the DMA read
+static bool ecuPresent = 0;
+
+static inline void ecuSelect(void)
+{
+    P10OUT &= ~ECU_CS;
+}
+
+static inline void ecuDeselect(void)
+{
+    while(EUSCI_B3->STATW & EUSCI_B_STATW_SPI_BUSY);//last byte has to leave the shift register first
+    P10OUT |= ECU_CS;
+}
+
+static uint8_t ecuXfer(uint8_t data)//polled single byte exchange
+{
+    while(!(EUSCI_B3->IFG & EUSCI_B_IFG_TXIFG));
+    EUSCI_B3->TXBUF = data;
+    while(!(EUSCI_B3->IFG & EUSCI_B_IFG_RXIFG));
+    return EUSCI_B3->RXBUF;
+}
+
+static uint8_t ecuRead(uint8_t address)
+{
+    uint8_t data;
+
+    ecuSelect();
+    ecuXfer(MCP_READ);
+    ecuXfer(address);
+    data = ecuXfer(0);
+    ecuDeselect();
+    return data;
+}
+
+static void ecuWrite(uint8_t address, const uint8_t *data, uint8_t length)//consecutive registers from address
+{
+    ecuSelect();
+    ecuXfer(MCP_WRITE);
+    ecuXfer(address);
+    while(length--)
+    {
+        ecuXfer(*data++);
+    }
+    ecuDeselect();
+}
+
+static void ecuWriteId(uint8_t address, uint32_t id)//filter or mask register set, extended ID
+{
+    uint8_t regs[4];
+
+    regs[0] = id >> 21;
+    regs[1] = ((id >> 13) & 0xE0) | 0x08 | ((id >> 16) & 0x03);//EXIDE, ignored in a mask
+    regs[2] = id >> 8;
+    regs[3] = id;
+    ecuWrite(address, regs, sizeof(regs));
+}
+
+static bool ecuMode(uint8_t mode)//requests an operating mode, returns 0 if the controller did not take it
+{
+    uint16_t tries = 1000;
+
+    ecuWrite(MCP_CANCTRL, &mode, 1);//CLKOUT off, one shot off
+    while(tries--)
+    {
+        if((ecuRead(MCP_CANSTAT) & MCP_MODE_MASK) == mode)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void ecuStart(void)//reads the next full receive buffer, finished by ecuRxDone(), nothing if both are empty
+{
+    uint8_t status;
+    uint8_t buffer;
+
+    ecuSelect();
+    ecuXfer(MCP_READ_STATUS);
+    status = ecuXfer(0);
+    ecuDeselect();
+    if(!(status & (MCP_STATUS_RX0IF | MCP_STATUS_RX1IF)))
+    {
+        ecuBusyFlag = 0;
+        return;
+    }
+    if((status & (MCP_STATUS_RX0IF | MCP_STATUS_RX1IF)) == (MCP_STATUS_RX0IF | MCP_STATUS_RX1IF))
+    {
+        ecuBehind++;
+    }
+    buffer = (status & MCP_STATUS_RX0IF) ? 0 : 1;//buffer 0 first, it is the older frame with rollover
+    ecuBusyFlag = 1;
+
+    ecuSelect();
+    ecuXfer(MCP_READ_RX(buffer));//leaves RXIFG clear
+    MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH7_EUSCIB3RX0, UDMA_MODE_BASIC,
+                           (void *)&EUSCI_B3->RXBUF, ecuRx, ECU_FRAME_BYTES);
+    MAP_DMA_enableChannel(ECU_RX_DMA_CHANNEL);
+    MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH6_EUSCIB3TX0, UDMA_MODE_BASIC,
+                           (void *)&ecuDummy, (void *)&EUSCI_B3->TXBUF, ECU_FRAME_BYTES);
+    MAP_DMA_enableChannel(ECU_TX_DMA_CHANNEL);
+    EUSCI_B3->IFG &= ~EUSCI_B_IFG_TXIFG;//re-arm TXIFG so the DMA sees a new request for the first byte
+    EUSCI_B3->IFG |=  EUSCI_B_IFG_TXIFG;
+}
+
+static inline int16_t ecuLe16(const uint8_t *data)
+{
+    return (int16_t)(data[0] | ((uint16_t)data[1] << 8));
+}
+
+static inline void ecuSet(ecuChannel_t channel, const uint8_t *data, uint32_t now)
+{
+    ecuTable[channel].value = ecuLe16(data);
+    ecuTable[channel].stamp = now;
+    ecuSeen |= 1U << channel;
+}
+
+static void ecuDecode(void)//PE3 frame in ecuRx to the channel table
+{
+    const uint8_t *data = &ecuRx[5];
+    uint32_t now = millis();
+    uint8_t frame = ecuRx[2] & 0x0F;//PE1 is 0
+
+    if((ecuRx[4] & 0x0F) < 8)//every PE3 frame is 8 bytes
+    {
+        return;
+    }
+    switch(frame)
+    {
+    case 0://PE1
+        ecuSet(ECU_RPM, &data[0], now);
+        ecuSet(ECU_TPS, &data[2], now);
+        break;
+    case 1://PE2
+        ecuSet(ECU_MAP, &data[2], now);
+        ecuSet(ECU_LAMBDA, &data[4], now);
+        break;
+    case 5://PE6
+        ecuSet(ECU_BATTERY, &data[0], now);
+        ecuSet(ECU_AIR_TEMP, &data[2], now);
+        ecuSet(ECU_COOLANT, &data[4], now);
+        break;
+    default:
+        break;
+    }
+    if(frame == (2 + ((ECU_OIL_INPUT - 1) / 4)))//PE3 inputs 1-4, PE4 inputs 5-8
+    {
+        ecuSet(ECU_OIL, &data[2 * ((ECU_OIL_INPUT - 1) % 4)], now);
+    }
+    ecuFrames++;
+}
+
+bool ecuInit(void)//resets and sets up the MCP2515 and DMA channels 6 and 7 on EUSCI_B3, returns 0 without a controller, call after dmaTableInit()
+{
+    static const uint8_t timing[4] = {ECU_CAN_CNF3, ECU_CAN_CNF2, ECU_CAN_CNF1, MCP_CANINTE_RX};
+    static const uint8_t rollover = MCP_RXB0_ROLLOVER;
+    static const uint8_t filtered = 0x00;
+    volatile uint32_t wait = ECU_RESET_LOOPS;
+    uint8_t k;
+
+    P10OUT |= ECU_CS;
+
+    EUSCI_B3->CTLW0 |= EUSCI_B_CTLW0_SWRST; // Put eUSCI state machine in reset
+    EUSCI_B3->CTLW0 = EUSCI_B_CTLW0_SWRST | // Remain eUSCI state machine in reset
+            EUSCI_B_CTLW0_MST |             // Set as SPI master
+            EUSCI_B_CTLW0_SYNC |            // Set as synchronous mode
+            EUSCI_B_CTLW0_CKPH |            // SPI mode 0,0
+            EUSCI_B_CTLW0_MODE_0 |          // 3 wire, CS is a GPIO
+            EUSCI_B_CTLW0_MSB;              // MSB first
+
+    EUSCI_B3->CTLW0 |= EUSCI_B_CTLW0_SSEL__SMCLK; // SMCLK
+    EUSCI_B3->BRW = SPI_BRW(ECU_SPI_HZ);    // fBitClock = fBRCLK/UCBRx, ECU_SPI_HZ
+    EUSCI_B3->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;    // Initialize USCI state machine
+
+    ecuSelect();
+    ecuXfer(MCP_RESET);
+    ecuDeselect();
+    while(wait--);
+    if((ecuRead(MCP_CANSTAT) & MCP_MODE_MASK) != MCP_MODE_CONFIG)//nothing answering, MISO floats or reads 0
+    {
+        return 0;
+    }
+
+    ecuWrite(MCP_CNF3, timing, sizeof(timing));
+    ecuWriteId(MCP_RXM0, ECU_PE_MASK);
+    ecuWriteId(MCP_RXM0 + 4, ECU_PE_MASK);
+    for(k = 0; k < 6; k++)
+    {
+        ecuWriteId(MCP_RXF0 + ((k < 3) ? (k * 4) : (0x10 + ((k - 3) * 4))), ECU_PE_ID);
+    }
+    ecuWrite(MCP_RXB0CTRL, &rollover, 1);
+    ecuWrite(MCP_RXB1CTRL, &filtered, 1);
+    if(!ecuMode(ECU_LISTEN_ONLY ? MCP_MODE_LISTEN : MCP_MODE_NORMAL))
+    {
+        return 0;
+    }
+
+    MAP_DMA_assignChannel(DMA_CH6_EUSCIB3TX0);
+    MAP_DMA_disableChannelAttribute(DMA_CH6_EUSCIB3TX0, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH6_EUSCIB3TX0,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_NONE | UDMA_ARB_1);//the same 0 for every byte
+    MAP_DMA_assignChannel(DMA_CH7_EUSCIB3RX0);
+    MAP_DMA_disableChannelAttribute(DMA_CH7_EUSCIB3RX0, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST | UDMA_ATTR_REQMASK);
+    MAP_DMA_enableChannelAttribute(DMA_CH7_EUSCIB3RX0, UDMA_ATTR_HIGH_PRIORITY);//RX ahead of TX so RXBUF never overruns
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH7_EUSCIB3RX0,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1);//one byte per RXIFG
+    MAP_DMA_clearInterruptFlag(ECU_RX_DMA_CHANNEL);//DMA_INT0, shared (dma_table.c)
+    MAP_Interrupt_enableInterrupt(INT_DMA_INT0);
+
+    ecuPresent = 1;
+    P5IES |= ECU_INT;//falling edge
+    P5IFG &= ~ECU_INT;
+    P5IE |= ECU_INT;
+    MAP_Interrupt_enableInterrupt(INT_PORT5);
+    if(!(P5IN & ECU_INT))//a frame came in before the edge was armed
+    {
+        P5IFG |= ECU_INT;
+    }
+    return 1;
+}
+
+void ecuSetClock(uint32_t smclk)//keeps ECU_SPI_HZ on a new SMCLK, call with no read on the wire (power.c)
+{
+    EUSCI_B3->CTLW0 |= EUSCI_B_CTLW0_SWRST;
+    EUSCI_B3->BRW = SPI_BRW_AT(smclk, ECU_SPI_HZ);
+    EUSCI_B3->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;//TX and RX are polled or fed by the DMA, no IE to restore
+}
+
+bool ecuBusy(void)
+{
+    return ecuBusyFlag;
+}
+
+int16_t ecuGet(ecuChannel_t channel)//latest value in the ecu.h unit, ECU_NO_DATA if not heard for ECU_STALE_MS
+{
+    uint8_t mask = criticalEnter(PRIORITY_LOGGING);
+    int16_t value = ecuTable[channel].value;
+    uint32_t stamp = ecuTable[channel].stamp;
+    bool seen = ecuSeen & (1U << channel);
+
+    criticalExit(mask);
+    return (seen && ((millis() - stamp) <= ECU_STALE_MS)) ? value : ECU_NO_DATA;
+}
+
+bool ecuAlert(void)//coolant hot, or oil pressure low with the engine turning
+{
+    int16_t coolant = ecuGet(ECU_COOLANT);
+    int16_t oil = ecuGet(ECU_OIL);
+    int16_t rpm = ecuGet(ECU_RPM);
+
+    return ((coolant != ECU_NO_DATA) && (coolant > ECU_COOLANT_HOT)) ||
+           ((oil != ECU_NO_DATA) && (rpm != ECU_NO_DATA) && (rpm > ECU_OIL_RPM) && (oil < ECU_OIL_LOW_MV));
+}
+
+int ecuFormat(char *text, int size)//"ECU <0|1 present> <frames> <behind> <rpm> <tps> <map> <lambda> <battery> <air> <coolant> <oil>\n", returns the length
+{
+    int n;
+
+    n = snprintf(text, size, "ECU %u %lu %lu %d %d %d %d %d %d %d %d", ecuPresent, (unsigned long)ecuFrames, (unsigned long)ecuBehind,
+                 ecuGet(ECU_RPM), ecuGet(ECU_TPS), ecuGet(ECU_MAP), ecuGet(ECU_LAMBDA),
+                 ecuGet(ECU_BATTERY), ecuGet(ECU_AIR_TEMP), ecuGet(ECU_COOLANT), ecuGet(ECU_OIL));
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+void ecuRxDone(void)//receive buffer read finished, from DMA_INT0 (dma_table.c)
+{
+    bool alert;
+
+    ecuDeselect();//RXnIF clears, INT releases unless the other buffer is full
+    ecuDecode();
+    alert = ecuAlert();
+    if(alert != ecuAlertShown)
+    {
+        ecuAlertShown = alert;
+        eventPost(EVENT_ECU);
+    }
+    P5IFG &= ~ECU_INT;//an edge from here on runs PORT5_IRQHandler
+    if(!(P5IN & ECU_INT))//the other buffer filled meanwhile
+    {
+        ecuStart();
+    }
+    else
+    {
+        ecuBusyFlag = 0;
+    }
+}
+
+void PORT5_IRQHandler(void)//MCP2515 INT fell, a receive buffer is full
+{
+    P5IFG &= ~ECU_INT;
+    if(!ecuBusyFlag)//otherwise ecuRxDone() picks it up
+    {
+        ecuStart();
+    }
+}
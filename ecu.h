@@ -0,0 +1,74 @@
+/*
+ * ecu.h
+ *
+ * ECU data from the PE3's CAN broadcast through an MCP2515 CAN controller on EUSCI_B3 (P10.1 CLK,
+ * P10.2 SIMO, P10.3 SOMI, CS on P10.0, INT on P5.0). The MCP2515 filters the bus down to the PE3
+ * frames and pulls INT low while one of its two receive buffers is full; the PORT5 interrupt reads
+ * READ STATUS polled (2 bytes) and then the whole buffer, ID to the last data byte, by DMA (RX on
+ * channel 7 with the TX channel 6 clocking), so a frame costs two short ISRs and ~16 us of bus
+ * time however fast the ECU sends. The DMA completion (DMA_INT0, dma_table.c) decodes the frame
+ * in place from the DMA landing buffer straight into the channel table and starts the next
+ * buffer if INT is still low, so both buffers are drained back to back and nothing is copied.
+ * Both run at PRIORITY_LOGGING and never preempt each other.
+ *
+ * Every PE3 value is a little endian int16 at a fixed scale (PE3 CAN protocol, frames PE1-PE16 on
+ * extended IDs ECU_PE_ID + ((n - 1) << 8)); the channel table keeps the latest of each with its
+ * millis() stamp, ecuGet() reads ECU_NO_DATA for a channel not heard for ECU_STALE_MS. Units:
+ *      ECU_RPM         1 RPM                       PE1 bytes 0-1
+ *      ECU_TPS         0.1 %                       PE1 bytes 2-3
+ *      ECU_MAP         0.01 kPa or psi (PE2 byte 6) PE2 bytes 2-3
+ *      ECU_LAMBDA      0.01                        PE2 bytes 4-5
+ *      ECU_BATTERY     0.01 V                      PE6 bytes 0-1
+ *      ECU_AIR_TEMP    0.1 deg C or F (PE6 byte 6) PE6 bytes 2-3
+ *      ECU_COOLANT     0.1 deg, as ECU_AIR_TEMP    PE6 bytes 4-5
+ *      ECU_OIL         1 mV, oil pressure sender on analog input ECU_OIL_INPUT, PE3 / PE4
+ * A hot coolant or, with the engine turning, low oil pressure raises the engine alert
+ * (ecuAlert(), overlay.h), changes post EVENT_ECU. The values go into the telemetry keyframes
+ * (telemetry.h) and are read over the download port ('J', download.h).
+ * Without a controller on the bus ecuInit() finds no MCP2515 and the link stays off.
+ */
+
+#ifndef ECU_H_
+#define ECU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//ECU settings
+#define ECU_SPI_HZ 8000000          //EUSCI_B3 bit rate, up to SPI_MAX_HZ (spi_rate.h), the MCP2515 takes 10 MHz
+#define ECU_CAN_CNF1 0x41           //250 kbit/s from a 16 MHz MCP2515 crystal: 250 ns TQ, SJW 2 TQ
+#define ECU_CAN_CNF2 0xF1           //propagation 2 TQ, phase 1 7 TQ, 3 samples
+#define ECU_CAN_CNF3 0x85           //phase 2 6 TQ, 16 TQ a bit
+#define ECU_LISTEN_ONLY 0           //1 never drives the bus, only for a bus that has another node acknowledging
+#define ECU_PE_ID 0x0CFFF048UL      //PE1, the 29 bit ID of the first PE3 frame
+#define ECU_STALE_MS 500            //a channel not heard for this long reads ECU_NO_DATA
+#define ECU_OIL_INPUT 5             //PE3 analog input 1-8 the oil pressure sender is wired to
+#define ECU_COOLANT_HOT 1050        //engine alert above this, 0.1 deg in the ECU's unit
+#define ECU_OIL_LOW_MV 500          //engine alert below this sender output while above ECU_OIL_RPM
+#define ECU_OIL_RPM 2000
+#define ECU_RX_DMA_CHANNEL 7
+
+#define ECU_NO_DATA INT16_MIN
+
+typedef enum
+{
+    ECU_RPM,
+    ECU_TPS,
+    ECU_MAP,
+    ECU_LAMBDA,
+    ECU_BATTERY,
+    ECU_AIR_TEMP,
+    ECU_COOLANT,
+    ECU_OIL,
+    ECU_CHANNELS
+} ecuChannel_t;
+
+bool ecuInit(void);
+int16_t ecuGet(ecuChannel_t channel);
+bool ecuAlert(void);
+bool ecuBusy(void);
+void ecuSetClock(uint32_t smclk);
+void ecuRxDone(void);
+int ecuFormat(char *text, int size);
+
+#endif /* ECU_H_ */
@@ -0,0 +1,54 @@
+/*
+ * engine.c
+ *
+ * Stalled / cranking / running state machine, see engine.h.
+ */
+
+#include "engine.h"
+
+static engineState_t engineNow = ENGINE_STALLED;
+
+engineState_t engineState(void)
+{
+    return engineNow;
+}
+
+bool engineUpdate(uint16_t rpm)//RPM after new tach edges (0 for the first edge after a stall), returns 1 if the state changed
+{
+    engineState_t next = engineNow;
+
+    switch(engineNow)
+    {
+    case ENGINE_STALLED:
+        next = ENGINE_CRANKING;//any edge, even without a period yet
+        break;
+    case ENGINE_CRANKING:
+        if(rpm > ENGINE_RUNNING_RPM)
+        {
+            next = ENGINE_RUNNING;
+        }
+        break;
+    default://ENGINE_RUNNING
+        if(rpm < ENGINE_CRANKING_RPM)
+        {
+            next = ENGINE_CRANKING;
+        }
+        break;
+    }
+    if(next == engineNow)
+    {
+        return 0;
+    }
+    engineNow = next;
+    return 1;
+}
+
+bool engineStall(void)//EVENT_STALL, returns 1 if the engine was not already stalled
+{
+    if(engineNow == ENGINE_STALLED)
+    {
+        return 0;
+    }
+    engineNow = ENGINE_STALLED;
+    return 1;
+}
@@ -0,0 +1,35 @@
+/*
+ * engine.h
+ *
+ * Engine state from the tach signal. The tach ISRs only measure edges, so without this nothing
+ * notices the edges stopping: the TIMER_A0 overflow posts EVENT_STALL once no edge has come for
+ * a TACH_MIN_RPM period (tach.h), which zeroes the RPM and drops the dash into idle, VCORE0 with
+ * the clocks divided down (power.h) and the numeric readout refreshed slowly. The first edge after a
+ * stall posts EVENT_TACH even though it carries no period, so full speed is back before the
+ * second edge is measured. Cranking and running are told apart by RPM with hysteresis.
+ * No hardware access, the reactions to a state change are in main().
+ */
+
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Engine settings
+#define ENGINE_RUNNING_RPM 700      //cranking until the RPM gets above this
+#define ENGINE_CRANKING_RPM 400     //back to cranking below this, e.g. a stall coming
+#define ENGINE_IDLE_DIGITS_HZ 4     //numeric readout refresh while stalled, well inside the watchdog timeout
+
+typedef enum
+{
+    ENGINE_STALLED,                 //no tach edges, power up state
+    ENGINE_CRANKING,
+    ENGINE_RUNNING
+} engineState_t;
+
+engineState_t engineState(void);
+bool engineUpdate(uint16_t rpm);
+bool engineStall(void);
+
+#endif /* ENGINE_H_ */
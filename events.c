@@ -0,0 +1,70 @@
+/*
+ * events.c
+ *
+ * ISR to main loop event flags and LPM0 idle, see events.h.
+ */
+
+#include "hal.h"
+#include "events.h"
+#include "tach.h"
+#include "ramfunc.h"
+
+static volatile bool eventFlags[EVENT_COUNT];
+static volatile uint32_t eventStamps[EVENT_COUNT];//tachNow() of the first post since the last take
+
+RAMFUNC void eventPost(event_t event)//marks event pending, callable from any ISR
+{
+    if(!eventFlags[event])//a post racing the take of the last one only moves the stamp a little
+    {
+        eventStamps[event] = tachNow();
+    }
+    eventFlags[event] = 1;
+}
+
+bool eventTake(event_t event)//returns 1 and clears the event if it was pending
+{
+    if(!eventFlags[event])
+    {
+        return 0;
+    }
+    eventFlags[event] = 0;
+    return 1;
+}
+
+uint32_t eventPending(void)//EVENT_BIT()s of the pending events, nothing taken
+{
+    uint32_t pending = 0;
+    uint8_t k;
+
+    for(k = 0; k < EVENT_COUNT; k++)
+    {
+        if(eventFlags[k])
+        {
+            pending |= EVENT_BIT(k);
+        }
+    }
+    return pending;
+}
+
+uint32_t eventStamp(event_t event)//tachNow() when a pending event was first posted
+{
+    return eventStamps[event];
+}
+
+void eventWait(void)//sleeps in LPM0 until an event is pending, returns immediately if one already is
+{
+    uint8_t k;
+
+    __disable_irq();//an ISR posting between the check and WFI still wakes the core, it stays pending until enabled
+                    //PRIMASK rather than BASEPRI on purpose, WFI does not wake for an interrupt masked by BASEPRI
+    for(k = 0; k < EVENT_COUNT; k++)
+    {
+        if(eventFlags[k])
+        {
+            __enable_irq();
+            return;
+        }
+    }
+    MAP_PCM_gotoLPM0();//WFI, wakes on any enabled interrupt
+    __enable_irq();//pending ISR runs here and posts its event
+}
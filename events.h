@@ -0,0 +1,46 @@
+/*
+ * events.h
+ *
+ * Events posted by ISRs to the main loop. The main loop sleeps in LPM0 in eventWait() until
+ * at least one event is pending, so the core only runs when there is work to do.
+ * Each event is its own byte so posting and taking are single stores, safe from any ISR.
+ * The first post of a pending event is stamped with tachNow(), the release time the scheduler
+ * (sched.h) measures task latency from.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENT_BIT(event) (1UL << (event))//event masks, EVENT_COUNT <= 32
+
+typedef enum
+{
+    EVENT_TACH,                     //new samples in the tach ring
+    EVENT_LS_DONE,                  //lightstrip frame finished sending
+    EVENT_UPSHIFT,                  //up hall effect confirmed a shift
+    EVENT_DOWNSHIFT,                //down hall effect confirmed a shift
+    EVENT_FLASH,                    //shift light flash state toggled
+    EVENT_TIMER,                    //a software timer expired, run swTimerService()
+    EVENT_SHIFT_DONE,               //a shift finished, records waiting in shiftPop()
+    EVENT_FRAM_DONE,                //FRAM write finished
+    EVENT_SERIAL_RX,                //bytes waiting in serialRead()
+    EVENT_SERIAL_DONE,              //UART transmission handed off
+    EVENT_BATTERY,                  //battery alarm state changed
+    EVENT_ECU,                      //engine alert from the ECU data changed (ecu.h)
+    EVENT_STALL,                    //tach edges stopped (engine.h)
+    EVENT_RENDER,                   //lightstrip frame wanted, posted from the main loop
+    EVENT_CRYPT,                    //dump chunk waiting for its key stream, posted from the main loop (download.h)
+    EVENT_SCHED,                    //a task was released from the main loop (sched.h)
+    EVENT_COUNT
+} event_t;
+
+void eventPost(event_t event);
+bool eventTake(event_t event);
+uint32_t eventPending(void);
+uint32_t eventStamp(event_t event);
+void eventWait(void);
+
+#endif /* EVENTS_H_ */
@@ -0,0 +1,296 @@
+/*
+ * fram.c
+ *
+ * SPI FRAM driver, see fram.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "fram.h"
+#include "spi_rate.h"
+#include "clock.h"
+#include "timebase.h"
+#include <string.h>
+
+#define FRAM_DMA_CHANNEL 2
+#define FRAM_RX_DMA_CHANNEL 3
+#define FRAM_CS BIT4            //P7.4
+#define FRAM_OP_WREN 0x06
+#define FRAM_OP_WRITE 0x02
+#define FRAM_OP_READ 0x03
+#define FRAM_OP_SLEEP 0xB9
+#define FRAM_WAKE_LOOPS (CLOCK_MCLK_HZ / 1000000 * FRAM_WAKE_US / 4)//busy loop passes, each at least 4 MCLK cycles
+
+typedef struct
+{
+    uint32_t address;
+    uint8_t *data;                  //write: FRAM_HEADER_BYTES free in front of the data, read: destination
+    uint16_t length;
+    bool read;
+    volatile bool *done;            //set once the transaction has finished, may be 0
+} framTransaction_t;
+
+static framTransaction_t framQueue[FRAM_QUEUE_SIZE];
+static uint8_t framCopies[FRAM_QUEUE_SIZE][FRAM_HEADER_BYTES + FRAM_MAX_WRITE];//framWrite() data, same index as its transaction
+static volatile uint8_t framHead = 0;//only written by the main loop
+static volatile uint8_t framTail = 0;//transaction on the wire, only advanced by DMA_INT2_IRQHandler
+static volatile bool framBusyFlag = 0;//framQueue[framTail] is on the wire
+static const uint8_t framDummy = 0;//clocked out during DMA reads
+static bool framAsleep = 0;
+static swTimer_t framSleepTimer;
+static void (*framCallback)(void) = 0;
+
+static inline void framSelect(void)
+{
+    P7OUT &= ~FRAM_CS;
+}
+
+static inline void framDeselect(void)
+{
+    while(EUSCI_A1->STATW & EUSCI_A_STATW_BUSY);//last byte has to leave the shift register first
+    P7OUT |= FRAM_CS;
+}
+
+static uint8_t framXfer(uint8_t data)//polled single byte exchange
+{
+    while(!(EUSCI_A1->IFG & EUSCI_A_IFG_TXIFG));
+    EUSCI_A1->TXBUF = data;
+    while(!(EUSCI_A1->IFG & EUSCI_A_IFG_RXIFG));
+    return EUSCI_A1->RXBUF;
+}
+
+static void framAddress(uint8_t *to, uint32_t address)//MSB first
+{
+    uint8_t i;
+
+    for(i = 0; i < FRAM_ADDR_BYTES; i++)
+    {
+        to[i] = address >> (8 * (FRAM_ADDR_BYTES - 1 - i));
+    }
+}
+
+void framWake(void)//CS pulse and tREC wait, the FRAM takes no command while asleep; also after a warm reset that may have left it asleep
+{
+    volatile uint32_t wait = FRAM_WAKE_LOOPS;
+
+    framSelect();
+    framDeselect();
+    while(wait--);
+    framAsleep = 0;
+}
+
+static void framSleep(void)//software timer callback, FRAM_SLEEP_MS after the last transaction was queued
+{
+    if(framBusyFlag || (framHead != framTail))//still working, try again later
+    {
+        swTimerStart(&framSleepTimer, FRAM_SLEEP_MS, 0, framSleep);
+        return;
+    }
+    framSelect();
+    framXfer(FRAM_OP_SLEEP);
+    framDeselect();
+    framAsleep = 1;
+}
+
+void framPortInit(void)//EUSCI_A1 SPI master for polled reads, runs on the reset clocks so the FRAM can be read before clockInit()
+{
+    P7OUT |= FRAM_CS;
+
+    EUSCI_A1->CTLW0 |= EUSCI_A_CTLW0_SWRST; // Put eUSCI state machine in reset
+    EUSCI_A1->CTLW0 = EUSCI_A_CTLW0_SWRST | // Remain eUSCI state machine in reset
+            EUSCI_A_CTLW0_MST |             // Set as SPI master
+            EUSCI_A_CTLW0_SYNC |            // Set as synchronous mode
+            EUSCI_A_CTLW0_CKPL |            // Set clock polarity high
+            EUSCI_A_CTLW0_MODE_2 |          // command select low
+            EUSCI_A_CTLW0_MSB;              // MSB first
+
+    EUSCI_A1->CTLW0 |= EUSCI_A_CTLW0_SSEL__SMCLK; // SMCLK, FRAM_SPI_HZ after clockInit(), the same divider from the 3 MHz reset SMCLK
+    EUSCI_A1->BRW = SPI_BRW(FRAM_SPI_HZ);   // fBitClock = fBRCLK/UCBRx
+    EUSCI_A1->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;    // Initialize USCI state machine
+}
+
+void framSetClock(uint32_t smclk)//keeps FRAM_SPI_HZ on a new SMCLK, call with the driver idle (power.c)
+{
+    EUSCI_A1->CTLW0 |= EUSCI_A_CTLW0_SWRST;
+    EUSCI_A1->BRW = SPI_BRW_AT(smclk, FRAM_SPI_HZ);
+    EUSCI_A1->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;//TX and RX are fed by the DMA, no IE to restore
+}
+
+void framInit(void)//sets up DMA channels 2 and 3 on EUSCI_A1 TX and RX, call after framPortInit() and dmaTableInit()
+{
+    MAP_DMA_assignChannel(DMA_CH2_EUSCIA1TX);
+    MAP_DMA_disableChannelAttribute(DMA_CH2_EUSCIA1TX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    MAP_DMA_assignChannel(DMA_CH3_EUSCIA1RX);
+    MAP_DMA_disableChannelAttribute(DMA_CH3_EUSCIA1RX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST | UDMA_ATTR_REQMASK);
+    MAP_DMA_enableChannelAttribute(DMA_CH3_EUSCIA1RX, UDMA_ATTR_HIGH_PRIORITY);//RX ahead of TX so RXBUF never overruns
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH3_EUSCIA1RX,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1);//one byte per RXIFG
+
+    MAP_DMA_assignInterrupt(DMA_INT2, FRAM_DMA_CHANNEL);//TX done for reads and writes, a read then waits out the last RX bytes
+    MAP_DMA_clearInterruptFlag(FRAM_DMA_CHANNEL);
+    MAP_Interrupt_enableInterrupt(DMA_INT2);
+}
+
+void framRead(uint32_t address, uint8_t *data, uint16_t length)//blocking polled read, waits for the queue to drain first
+{
+    uint8_t header[FRAM_ADDR_BYTES];
+    uint8_t i;
+
+    while(framBusyFlag);//DMA_INT2 works through the queue
+    if(framAsleep)
+    {
+        framWake();
+        swTimerStart(&framSleepTimer, FRAM_SLEEP_MS, 0, framSleep);
+    }
+    framAddress(header, address);
+    (void)EUSCI_A1->RXBUF;//clear anything left over from a DMA write
+    framSelect();
+    framXfer(FRAM_OP_READ);
+    for(i = 0; i < FRAM_ADDR_BYTES; i++)
+    {
+        framXfer(header[i]);
+    }
+    while(length--)
+    {
+        *data++ = framXfer(0);
+    }
+    framDeselect();
+}
+
+static void framStart(void)//puts framQueue[framTail] on the wire, FRAM awake and not busy
+{
+    framTransaction_t *t = &framQueue[framTail];
+    uint8_t header[FRAM_ADDR_BYTES];
+    uint8_t i;
+
+    framBusyFlag = 1;
+    if(t->read)
+    {
+        framAddress(header, t->address);
+        (void)EUSCI_A1->RXBUF;
+        framSelect();//opcode and address polled, then the data both ways by DMA
+        framXfer(FRAM_OP_READ);
+        for(i = 0; i < FRAM_ADDR_BYTES; i++)
+        {
+            framXfer(header[i]);
+        }
+        MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH3_EUSCIA1RX, UDMA_MODE_BASIC,
+                               (void *)MAP_SPI_getReceiveBufferAddressForDMA(EUSCI_A1_BASE), t->data, t->length);
+        MAP_DMA_enableChannel(FRAM_RX_DMA_CHANNEL);
+        MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH2_EUSCIA1TX,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_NONE | UDMA_ARB_1);//the same 0 for every byte
+        MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH2_EUSCIA1TX, UDMA_MODE_BASIC, (void *)&framDummy,
+                               (void *)MAP_SPI_getTransmitBufferAddressForDMA(EUSCI_A1_BASE), t->length);
+    }
+    else
+    {
+        t->data[0] = FRAM_OP_WRITE;
+        framAddress(&t->data[1], t->address);
+
+        framSelect();//write enable latch, one byte so it is not worth a DMA transfer, the FRAM clears it after every write
+        framXfer(FRAM_OP_WREN);
+        framDeselect();
+
+        framSelect();
+        MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH2_EUSCIA1TX,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_1);//one byte per TXIFG
+        MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH2_EUSCIA1TX, UDMA_MODE_BASIC, t->data,
+                               (void *)MAP_SPI_getTransmitBufferAddressForDMA(EUSCI_A1_BASE), FRAM_HEADER_BYTES + t->length);
+    }
+    MAP_DMA_enableChannel(FRAM_DMA_CHANNEL);
+    EUSCI_A1->IFG &= ~EUSCI_A_IFG_TXIFG;//re-arm TXIFG so the DMA sees a new request for the first byte
+    EUSCI_A1->IFG |=  EUSCI_A_IFG_TXIFG;
+}
+
+static bool framQueueAdd(uint32_t address, uint8_t *data, uint16_t length, bool read, volatile bool *done)//main loop only
+{
+    uint8_t head = framHead;
+    uint8_t next = (head + 1) & (FRAM_QUEUE_SIZE - 1);
+    framTransaction_t *t = &framQueue[head];
+
+    if((next == framTail) || (length == 0))
+    {
+        return 0;
+    }
+    t->address = address;
+    t->data = data;
+    t->length = length;
+    t->read = read;
+    t->done = done;
+    if(done)
+    {
+        *done = 0;
+    }
+    framHead = next;//publish, from here DMA_INT2 may start it
+    if(!framBusyFlag)//idle, nothing will chain to it
+    {
+        if(framAsleep)
+        {
+            framWake();
+        }
+        framStart();
+    }
+    swTimerStart(&framSleepTimer, FRAM_SLEEP_MS, 0, framSleep);
+    return 1;
+}
+
+bool framWrite(uint32_t address, const uint8_t *data, uint16_t length)//copies data and queues a DMA write, returns 0 if the queue is full
+{
+    if(length > FRAM_MAX_WRITE)
+    {
+        return 0;
+    }
+    memcpy(&framCopies[framHead][FRAM_HEADER_BYTES], data, length);//slot is free while the queue has room
+    return framQueueAdd(address, framCopies[framHead], length, 0, 0);
+}
+
+bool framWriteBlock(uint32_t address, uint8_t *block, uint16_t length, volatile bool *done)//queues a DMA write of length bytes from block + FRAM_HEADER_BYTES in place, block must not change until *done
+{
+    return framQueueAdd(address, block, length, 0, done);
+}
+
+bool framReadStart(uint32_t address, uint8_t *data, uint16_t length, volatile bool *done)//queues a DMA read into data, *done is set when the last byte is in
+{
+    return framQueueAdd(address, data, length, 1, done);
+}
+
+bool framBusy(void)//1 while anything is queued or on the wire
+{
+    return framBusyFlag || (framHead != framTail);
+}
+
+void framSetCallback(void (*callback)(void))//callback is run from the DMA interrupt after every transaction
+{
+    framCallback = callback;
+}
+
+void DMA_INT2_IRQHandler(void)//Interrupt when the last FRAM byte has been loaded into EUSCI_A1, starts the next queued transaction
+{
+    framTransaction_t *t = &framQueue[framTail];
+
+    MAP_DMA_clearInterruptFlag(FRAM_DMA_CHANNEL);
+    if(t->read)
+    {
+        while(MAP_DMA_isChannelEnabled(FRAM_RX_DMA_CHANNEL));//last bytes still coming in, ~2 us at 12 MHz
+    }
+    framDeselect();//waits out the last byte, ~1 us at 12 MHz
+    (void)EUSCI_A1->RXBUF;//RX is ignored during writes, drop the overrun
+    if(t->done)
+    {
+        *t->done = 1;
+    }
+    framTail = (framTail + 1) & (FRAM_QUEUE_SIZE - 1);
+    if(framTail != framHead)//queued behind it, no gap on the bus
+    {
+        framStart();
+    }
+    else
+    {
+        framBusyFlag = 0;
+    }
+    if(framCallback)
+    {
+        framCallback();
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ * fram.h
+ *
+ * SPI FRAM driver on EUSCI_A1 (P2.1-2.3, CS on P7.4), FM25V02A.
+ * Every client (shift log, telemetry, checkpoints, parameters, log download) queues
+ * transactions and returns at once; the DMA_INT2 handler finishes one and starts the next, so
+ * the bus has no gaps and no client waits for another's burst. CS, the write enable latch
+ * (cleared by the FRAM after every write, so one per write) and the opcode and address are
+ * handled by the driver.
+ *      framWrite()      copies up to FRAM_MAX_WRITE bytes into a queue slot
+ *      framWriteBlock() sends a block in place, the caller leaves FRAM_HEADER_BYTES free in
+ *                       front of the data so the whole block is one DMA burst
+ *      framReadStart()  DMA read of any length, RX on channel 3 with the TX channel clocking
+ *      framRead()       polled, for start up, waits for the queue to drain
+ * Optional done flags are set as each transaction finishes, framSetCallback() runs after every
+ * one. FRAM_SLEEP_MS after the last transaction the FRAM is put to sleep (~8 uA instead of
+ * ~150 uA standby), the next transaction wakes it and waits out FRAM_WAKE_US.
+ * FRAM writes complete at bus speed, there is no page or erase handling.
+ *
+ * FRAM map:
+ *      0x0000 - 0x0FFF -> Shift log (shiftlog.h)
+ *      0x1000 - 0x7CFF -> RPM telemetry blocks (telemetry.h)
+ *      0x7D00 - 0x7EFF -> Running and last session summaries (stats.h)
+ *      0x7F00 - 0x7F27 -> Gear and shift counter checkpoints (checkpoint.h)
+ *      0x7F28 - 0x7F4B -> Per gear shift points (shiftpoints.h)
+ *      0x7F4C - 0x7F57 -> Dashboard parameters (params.h)
+ *      0x7F58 - 0x7F67 -> Peak RPM and over-rev count (peak.h)
+ *      0x7F68 - 0x7F9B -> Log encryption key and nonces (logcrypt.h)
+ *      0x7FA0 - 0x7FDF -> Benchmark write target, Benchmark builds only (benchmark.h)
+ */
+
+#ifndef FRAM_H_
+#define FRAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//FRAM settings
+#define FRAM_SIZE_BYTES 32768       //256 Kbit part
+#define FRAM_SPI_HZ 12000000        //EUSCI_A1 bit rate after clockInit(), up to SPI_MAX_HZ (spi_rate.h)
+#define FRAM_ADDR_BYTES 2           //address bytes after the opcode
+#define FRAM_MAX_WRITE 32           //largest single framWrite()
+#define FRAM_QUEUE_SIZE 8           //transactions queued or on the wire, power of 2
+#define FRAM_SLEEP_MS 20            //idle time before the FRAM is put to sleep
+#define FRAM_WAKE_US 450            //tREC, sleep to first command
+#define FRAM_HEADER_BYTES (1 + FRAM_ADDR_BYTES)
+
+void framPortInit(void);
+void framInit(void);
+void framWake(void);
+void framRead(uint32_t address, uint8_t *data, uint16_t length);
+bool framWrite(uint32_t address, const uint8_t *data, uint16_t length);
+bool framWriteBlock(uint32_t address, uint8_t *block, uint16_t length, volatile bool *done);
+bool framReadStart(uint32_t address, uint8_t *data, uint16_t length, volatile bool *done);
+bool framBusy(void);
+void framSetClock(uint32_t smclk);
+void framSetCallback(void (*callback)(void));
+
+#endif /* FRAM_H_ */
@@ -0,0 +1,58 @@
+/*
+ * frame.c
+ *
+ * In place command frame parser and builder, see frame.h.
+ */
+
+#include "frame.h"
+#include "crc.h"
+
+static uint16_t frameCrc(const uint8_t *from, uint16_t length)//length and type bytes through the end of the payload
+{
+    return (uint16_t)crcBlock(from, length);
+}
+
+frameResult_t frameParse(const uint8_t *data, uint16_t available, frame_t *frame)//checks the bytes at data, available of them received so far
+{
+    uint16_t bytes;
+
+    if(!available || (data[0] != FRAME_SYNC))
+    {
+        return FRAME_BAD;
+    }
+    if(available < 2)
+    {
+        return FRAME_PARTIAL;
+    }
+    if(data[1] > FRAME_MAX_PAYLOAD)
+    {
+        return FRAME_BAD;
+    }
+    bytes = data[1] + FRAME_OVERHEAD;
+    if(available < bytes)
+    {
+        return FRAME_PARTIAL;
+    }
+    if(frameCrc(&data[1], bytes - 3) != (data[bytes - 2] | ((uint16_t)data[bytes - 1] << 8)))
+    {
+        return FRAME_BAD;
+    }
+    frame->type = data[2];
+    frame->length = data[1];
+    frame->payload = &data[FRAME_HEADER_BYTES];
+    frame->bytes = bytes;
+    return FRAME_OK;
+}
+
+uint16_t frameBuild(uint8_t *to, uint8_t type, uint8_t length)//frames the length payload bytes already at to + FRAME_HEADER_BYTES, returns the frame size
+{
+    uint16_t crc;
+
+    to[0] = FRAME_SYNC;
+    to[1] = length;
+    to[2] = type;
+    crc = frameCrc(&to[1], length + 2);
+    to[FRAME_HEADER_BYTES + length] = (uint8_t)crc;
+    to[FRAME_HEADER_BYTES + length + 1] = (uint8_t)(crc >> 8);
+    return length + FRAME_OVERHEAD;
+}
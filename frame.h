@@ -0,0 +1,48 @@
+/*
+ * frame.h
+ *
+ * Length prefixed, CRC checked command frames on the download port (download.h), parsed in
+ * place on the serial RX ring (serial.h) and built in place in the reply buffer, so neither
+ * side copies a payload. Frame layout, little endian:
+ *      0   uint8   FRAME_SYNC
+ *      1   uint8   payload length, up to FRAME_MAX_PAYLOAD
+ *      2   uint8   type, the download command byte
+ *      3   payload
+ *      n   uint16  low half of the CRC32 (crc.h) of the length, type and payload
+ * FRAME_SYNC is never a command byte, so frames and single byte commands mix on one port. A
+ * frame with a bad length or CRC is dropped up to the next sync byte or the line going idle, none
+ * of its bytes run as single byte commands; the parser picks up again at that sync.
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Frame settings
+#define FRAME_SYNC 0x7E
+#define FRAME_MAX_PAYLOAD 64        //largest payload, the 'E' key upload
+#define FRAME_HEADER_BYTES 3
+#define FRAME_OVERHEAD (FRAME_HEADER_BYTES + 2)
+#define FRAME_MAX_BYTES (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+typedef enum
+{
+    FRAME_OK,                       //frame_t filled in
+    FRAME_PARTIAL,                  //could still become a frame, wait for more bytes
+    FRAME_BAD                       //no frame starts here, skip a byte
+} frameResult_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t length;
+    const uint8_t *payload;         //points into the parsed bytes
+    uint16_t bytes;                 //whole frame, to release
+} frame_t;
+
+frameResult_t frameParse(const uint8_t *data, uint16_t available, frame_t *frame);
+uint16_t frameBuild(uint8_t *to, uint8_t type, uint8_t length);
+
+#endif /* FRAME_H_ */
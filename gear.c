@@ -0,0 +1,28 @@
+/*
+ * gear.c
+ *
+ * 7-segment gear indicator, see gear.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "gear.h"
+
+//Segment bits on P4: b 0x01, a 0x02, c 0x04, e 0x10, d 0x20, f 0x40, g 0x80
+static const uint8_t gearSegments[GEAR_GLYPHS] = {0x77, 0x05, 0xB3, 0xA7, 0xC5, 0xE6, 0xF6, 0x07, 0xF7, 0xE7,//0-9
+                                                  0x94, 0xF2, 0x00};//n, E, blank
+static uint8_t gearShown = GEAR_BLANK;//pinInit() leaves every segment off
+
+void gearShow(uint8_t glyph)//shows a digit or one of the GEAR_ glyphs, no port write if it is already shown
+{
+    if(glyph >= GEAR_GLYPHS)
+    {
+        glyph = GEAR_FAULT;
+    }
+    if(glyph == gearShown)
+    {
+        return;
+    }
+    gearShown = glyph;
+    P4OUT = gearSegments[glyph];//whole pattern in one byte store
+}
@@ -0,0 +1,22 @@
+/*
+ * gear.h
+ *
+ * Single digit 7-segment gear indicator on P4.0-P4.7 (whole port, one pin per segment).
+ * Every glyph is one full byte pattern written to P4OUT in a single store, so the display never
+ * passes through a mix of the old and new gear, and the port is only written when the glyph changes.
+ */
+
+#ifndef GEAR_H_
+#define GEAR_H_
+
+#include <stdint.h>
+
+//Glyphs past the digits 0-9
+#define GEAR_NEUTRAL 10             //"n"
+#define GEAR_FAULT 11               //"E", shift gave up
+#define GEAR_BLANK 12
+#define GEAR_GLYPHS 13
+
+void gearShow(uint8_t glyph);
+
+#endif /* GEAR_H_ */
@@ -0,0 +1,20 @@
+/*
+ * hal.h
+ *
+ * Hardware access for the modules that also build into the host simulation (sim/).
+ * On the target this is just driverlib and the MSP432 register definitions. With SIM_HOST
+ * defined the same names come from sim/sim_hal.h, where the registers are plain memory the
+ * simulation drives and the few driverlib calls are stubs, so the module sources are shared.
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#ifdef SIM_HOST
+#include "sim_hal.h"
+#else
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#endif
+
+#endif /* HAL_H_ */
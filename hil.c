@@ -0,0 +1,213 @@
+/*
+ * hil.c
+ *
+ * Tach pulse generator and edge to lightstrip latency histogram, see hil.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "hil.h"
+
+#ifdef HIL_ENABLE
+
+#include "battery.h"
+#include "clock.h"
+#include "tach.h"
+#include "timebase.h"
+#include "ramfunc.h"
+#include <stdio.h>
+
+#define HIL_OUT BIT2                //P8.2, TA3.2
+#define HIL_RPM_TO_COUNT(rpm) ((uint16_t)(((uint32_t)HIL_TIMER_HZ * 60) / ((uint32_t)(rpm) * TACH_PULSES_PER_REV)))
+
+typedef struct
+{
+    uint16_t startRpm;
+    uint16_t endRpm;
+    uint16_t ms;                    //linear ramp from startRpm to endRpm over this long
+} hilSegment_t;
+
+static const hilSegment_t hilProfile[] =
+{
+    {1000, 1000, 1000},             //idle
+    {1000, 12000, 6000},            //full pull into the shift zone
+    {12000, 12000, 1000},
+    {12000, 3000, 3000},            //braking
+    {3000, 9000, 0},                //step, worst case for the filter and the meter
+    {9000, 9000, 1000},
+    {9000, 11000, 500},             //short blips around the shift lights
+    {11000, 9000, 500},
+    {9000, 11000, 500},
+    {11000, 1000, 2000}
+};
+#define HIL_SEGMENTS (sizeof(hilProfile) / sizeof(hilProfile[0]))
+
+static swTimer_t hilTimer;
+static uint8_t hilSegment = 0;
+static uint16_t hilElapsed = 0;//ms into the segment
+static volatile uint16_t hilPeriod = 0;//TIMER_A3 counts per pulse, loaded at the next period start
+static volatile uint32_t hilEdgeUs = 0;//micros() of the newest generated edge
+static uint32_t hilFrameEdgeUs = 0;//edge the frame on the wire was built after
+static volatile bool hilFramePending = 0;
+static bool hilActiveFlag = 0;
+
+static uint32_t hilCount = 0;
+static uint32_t hilMin = 0xFFFFFFFF;
+static uint32_t hilMax = 0;
+static uint32_t hilTotal = 0;
+static uint32_t hilHistogram[HIL_BUCKETS];
+
+static void hilStep(void)//software timer callback, moves the sweep on by HIL_STEP_MS
+{
+    const hilSegment_t *segment;
+    int32_t rpm;
+
+    while((hilSegment < HIL_SEGMENTS) && (hilElapsed >= hilProfile[hilSegment].ms))
+    {
+        hilElapsed -= hilProfile[hilSegment].ms;
+        hilSegment++;
+    }
+    if(hilSegment >= HIL_SEGMENTS)
+    {
+        hilStop();
+        return;
+    }
+    segment = &hilProfile[hilSegment];
+    rpm = segment->startRpm + (((int32_t)segment->endRpm - segment->startRpm) * hilElapsed) / segment->ms;
+    if(rpm < HIL_MIN_RPM)
+    {
+        rpm = HIL_MIN_RPM;
+    }
+    hilPeriod = HIL_RPM_TO_COUNT(rpm);
+    hilElapsed += HIL_STEP_MS;
+}
+
+void hilStart(void)//takes TIMER_A3 from the battery monitor and starts the sweep from the top of the profile
+{
+    hilSegment = 0;
+    hilElapsed = 0;
+    hilFramePending = 0;
+    hilStep();
+
+    P8SEL0 |=  HIL_OUT;//TA3.2 output
+    P8SEL1 &= ~HIL_OUT;
+    P8DIR  |=  HIL_OUT;
+
+    TIMER_A3->CTL = TIMER_A_CTL_SSEL__SMCLK | TIMER_A_CTL_ID__8 | TIMER_A_CTL_CLR;
+    TIMER_A3->EX0 = TIMER_A_EX0_IDEX__1;
+    TIMER_A3->CCR[0] = hilPeriod - 1;
+    TIMER_A3->CCR[2] = hilPeriod / 2;
+    TIMER_A3->CCTL[1] = 0;//no ADC triggers while the timer runs at tach rate
+    TIMER_A3->CCTL[2] = TIMER_A_CCTLN_OUTMOD_7;//reset at CCR2, set at CCR0, rising edge at every period start
+    TIMER_A3->CCTL[0] = TIMER_A_CCTLN_CCIE;
+    TIMER_A3->CTL |= TIMER_A_CTL_MC__UP;
+    MAP_Interrupt_enableInterrupt(INT_TA3_0);
+
+    hilActiveFlag = 1;
+    swTimerStart(&hilTimer, HIL_STEP_MS, HIL_STEP_MS, hilStep);
+}
+
+void hilStop(void)//ends the sweep and gives TIMER_A3 back to the battery monitor
+{
+    swTimerStop(&hilTimer);
+    MAP_Interrupt_disableInterrupt(INT_TA3_0);
+    TIMER_A3->CTL = 0;
+    TIMER_A3->CCTL[0] = 0;
+    TIMER_A3->CCTL[2] = 0;
+
+    P8SEL0 &= ~HIL_OUT;//back to an idle low GPIO
+    P8OUT  &= ~HIL_OUT;
+
+    hilActiveFlag = 0;
+    batteryTimerStart();
+}
+
+bool hilActive(void)
+{
+    return hilActiveFlag;
+}
+
+void hilFrameStarted(void)//main loop, a new lightstrip frame was just handed to the DMA
+{
+    if(hilActiveFlag)
+    {
+        hilFrameEdgeUs = hilEdgeUs;
+        hilFramePending = 1;
+    }
+}
+
+RAMFUNC void hilFrameDone(void)//lightstrip DMA interrupt, the frame has been loaded into EUSCI_A2
+{
+    uint32_t latency;
+    uint8_t bucket = 0;
+    uint32_t above;
+
+    if(!hilFramePending)
+    {
+        return;
+    }
+    hilFramePending = 0;
+    latency = micros() - hilFrameEdgeUs;
+
+    above = latency >> 5;
+    while(above && (bucket < (HIL_BUCKETS - 1)))
+    {
+        bucket++;
+        above >>= 1;
+    }
+    hilHistogram[bucket]++;
+    hilCount++;
+    hilTotal += latency;
+    if(latency < hilMin)
+    {
+        hilMin = latency;
+    }
+    if(latency > hilMax)
+    {
+        hilMax = latency;
+    }
+}
+
+void hilReset(void)
+{
+    uint8_t b;
+
+    hilCount = 0;
+    hilMin = 0xFFFFFFFF;
+    hilMax = 0;
+    hilTotal = 0;
+    for(b = 0; b < HIL_BUCKETS; b++)
+    {
+        hilHistogram[b] = 0;
+    }
+}
+
+int hilFormat(char *text, int size)//"HIL <frames> <min> <max> <mean> <bucket 0> ... <bucket n>\n" in us, returns the length
+{
+    uint32_t mean = hilCount ? (hilTotal / hilCount) : 0;
+    int n;
+    uint8_t b;
+
+    n = snprintf(text, size, "HIL %lu %lu %lu %lu", (unsigned long)hilCount, (unsigned long)(hilCount ? hilMin : 0),
+                 (unsigned long)hilMax, (unsigned long)mean);
+    for(b = 0; (b < HIL_BUCKETS) && (n < size); b++)
+    {
+        n += snprintf(&text[n], size - n, " %lu", (unsigned long)hilHistogram[b]);
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+RAMFUNC void TA3_0_IRQHandler(void)//TIMER_A3 period start, the generated tach edge
+{
+    TIMER_A3->CCTL[0] &= ~TIMER_A_CCTLN_CCIFG;
+    hilEdgeUs = micros();
+    TIMER_A3->CCR[0] = hilPeriod - 1;//takes effect from the period that just started
+    TIMER_A3->CCR[2] = hilPeriod / 2;
+}
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * hil.h
+ *
+ * Hardware in the loop latency test. TIMER_A3 generates tach pulses on TA3.2 (P8.2), which is
+ * wired back to the tach input P7.3 (P7.5 with TACH_COMP_ENABLE) in place of the ECU, sweeping RPM through the profile table
+ * in hil.c. The TA3_0 interrupt stamps every generated edge, and when the lightstrip frame built
+ * after that edge has been loaded into EUSCI_A2 the edge to frame latency goes into a log2
+ * histogram. Start a sweep with the 'H' command of the log download and read the histogram with
+ * 'L' (download.h).
+ * TIMER_A3 is borrowed from the battery monitor, battery readings hold their last value during
+ * a sweep and the ADC trigger is restored when it ends.
+ * Only compiled in when HIL_ENABLE is defined (Debug configuration).
+ */
+
+#ifndef HIL_H_
+#define HIL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Test settings
+#define HIL_TIMER_HZ (CLOCK_SMCLK_HZ / 8)   //TIMER_A3 count rate, 16 bit periods reach down to ~350 RPM
+#define HIL_MIN_RPM 400
+#define HIL_STEP_MS 10                      //RPM update rate of the sweep
+#define HIL_BUCKETS 12                      //bucket 0 < 32 us, bucket k < 2^(k + 5) us, last bucket everything above
+
+#ifdef HIL_ENABLE
+
+void hilStart(void);
+void hilStop(void);
+bool hilActive(void);
+void hilFrameStarted(void);
+void hilFrameDone(void);
+void hilReset(void);
+int hilFormat(char *text, int size);
+
+#define HIL_FRAME_BEGIN() bool hilWasBusy = lsBusy()
+#define HIL_FRAME_END() do { if(!hilWasBusy && lsBusy()) { hilFrameStarted(); } } while(0)
+#define HIL_FRAME_DONE() hilFrameDone()
+
+#else
+
+#define HIL_FRAME_BEGIN() ((void)0)
+#define HIL_FRAME_END() ((void)0)
+#define HIL_FRAME_DONE() ((void)0)
+
+#endif
+
+#endif /* HIL_H_ */
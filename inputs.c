@@ -0,0 +1,129 @@
+/*
+ * inputs.c
+ *
+ * P6 edge qualification and lockout debouncing, see inputs.h.
+ * The P6 pins themselves are configured in pinInit() in main.c.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "inputs.h"
+#include "wheel.h"
+#include "tach.h"
+#include "clock.h"
+#include "profile.h"
+#include "ramfunc.h"
+
+#define INPUT_PINS ((1 << INPUT_UP_PADDLE) | (1 << INPUT_DOWN_PADDLE) | (1 << INPUT_UP_HALL) | (1 << INPUT_DOWN_HALL))
+#define INPUT_WHEEL_PINS ((1 << INPUT_FRONT_WHEEL) | (1 << INPUT_REAR_WHEEL))
+#define INPUT_SAMPLE_TICKS (CLOCK_ACLK_HZ / 1000)//TIMER_A1 runs from ACLK, ~1 ms between samples
+
+static const uint8_t inputLockoutSamples[8] =
+{
+    INPUT_PADDLE_LOCKOUT_MS,//P6.0 up paddle
+    INPUT_PADDLE_LOCKOUT_MS,//P6.1 down paddle
+    0,
+    0,
+    INPUT_HALL_LOCKOUT_MS,  //P6.4 up hall effect
+    INPUT_HALL_LOCKOUT_MS,  //P6.5 down hall effect
+    0,
+    0
+};
+
+static volatile uint8_t inputLockout[8];//samples left in each pin's lockout window
+static volatile uint8_t inputLocked = 0;//pins with their interrupt disabled
+static void (*inputHandler)(uint8_t pin, uint32_t timestamp) = 0;
+
+void inputsInit(void)//starts TIMER_A1 from ACLK and enables PORT6 and the TA1_N sampler in the NVIC, call after clockInit()
+{
+    TIMER_A1->CCTL[1] = 0;//sampler only runs while a pin is locked out
+    TIMER_A1->CTL = TIMER_A_CTL_SSEL__ACLK |   //ACLK, continuous mode, CCR0 is the shift light cadence (spiInit() in main.c)
+                TIMER_A_CTL_MC__CONTINUOUS;
+
+    P6IFG &= ~(INPUT_PINS | INPUT_WHEEL_PINS);
+    NVIC->ISER[0] = 1 << ((TA1_N_IRQn) & 31);//re-arms the pins after their lockout
+    NVIC->ISER[1] = 1 << ((PORT6_IRQn) & 31);
+}
+
+void inputsSetHandler(void (*handler)(uint8_t pin, uint32_t timestamp))//handler runs in the PORT6 interrupt for every qualified edge
+{
+    inputHandler = handler;
+}
+
+RAMFUNC void PORT6_IRQHandler(void)//Interrupt on falling edge of paddles, hall effect sensors and wheel speed sensors
+{
+    PROFILE_BEGIN(PROF_INPUT_ISR);
+    uint32_t timestamp = tachNow();//edge time for the shift latency, before anything else
+    uint16_t iv;
+    uint8_t pin;
+    uint8_t mask;
+
+    while((iv = P6IV) != 0)//reading P6IV clears the highest priority flag, loop until every pin is handled
+    {
+        pin = (iv >> 1) - 1;
+        mask = 1 << pin;
+        if(INPUT_WHEEL_PINS & mask)//wheel tooth, timestamped and left armed
+        {
+            wheelEdge((pin == INPUT_FRONT_WHEEL) ? WHEEL_FRONT : WHEEL_REAR);
+            continue;
+        }
+        if(!(INPUT_PINS & mask))//not a debounced input
+        {
+            continue;
+        }
+
+        P6IE &= ~mask;//ignore bounce until the lockout window is over
+        inputLockout[pin] = inputLockoutSamples[pin];
+        if(!inputLocked)//start sampling
+        {
+            TIMER_A1->CCR[1] = TIMER_A1->R + INPUT_SAMPLE_TICKS;
+            TIMER_A1->CCTL[1] = TIMER_A_CCTLN_CCIE;
+        }
+        inputLocked |= mask;
+
+        if(inputHandler)
+        {
+            inputHandler(pin, timestamp);
+        }
+    }
+    PROFILE_END(PROF_INPUT_ISR);
+}
+
+RAMFUNC void TA1_N_IRQHandler(void)//TIMER_A1 CCR1 input sampler
+{
+    uint8_t pin;
+    uint8_t mask;
+
+    switch(TIMER_A1->IV)//reading IV clears the flag
+    {
+    case 0x02://CCR1
+        TIMER_A1->CCR[1] += INPUT_SAMPLE_TICKS;
+        for(pin = 0; pin < 8; pin++)
+        {
+            mask = 1 << pin;
+            if(!(inputLocked & mask))
+            {
+                continue;
+            }
+            if(inputLockout[pin])//still inside the lockout window
+            {
+                inputLockout[pin]--;
+                continue;
+            }
+            if(!(P6IN & mask))//still held low, stay locked until released
+            {
+                continue;
+            }
+            P6IFG &= ~mask;//released, re-arm the falling edge interrupt
+            P6IE |= mask;
+            inputLocked &= ~mask;
+        }
+        if(!inputLocked)
+        {
+            TIMER_A1->CCTL[1] = 0;//nothing locked, stop sampling
+        }
+        break;
+    default:
+        break;
+    }
+}
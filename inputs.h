@@ -0,0 +1,36 @@
+/*
+ * inputs.h
+ *
+ * Debounced paddle and hall-effect inputs on P6 (falling edge active).
+ * The first falling edge on a pin is acted on immediately for the lowest shift latency, then the
+ * pin interrupt is disabled for its lockout window so contact bounce never reaches the ISR.
+ * TIMER_A1 CCR1 samples the locked pins every ~1 ms (ACLK) and re-arms a pin once the window
+ * has passed and the input has been released, so holding a paddle never retriggers.
+ * Every pending flag is handled through P6IV, so simultaneous edges are never dropped.
+ * The handler gets the tachNow() stamp (tach.h) taken on entry to the PORT6 interrupt, so the
+ * shift latency (shift.h) is measured edge to edge at 83 ns resolution.
+ * The wheel speed inputs share the port but are not debounced, every edge goes to wheelEdge()
+ * (wheel.h), which rejects noise by period.
+ */
+
+#ifndef INPUTS_H_
+#define INPUTS_H_
+
+#include <stdint.h>
+
+//P6 pin numbers
+#define INPUT_UP_PADDLE 0
+#define INPUT_DOWN_PADDLE 1
+#define INPUT_UP_HALL 4
+#define INPUT_DOWN_HALL 5
+#define INPUT_FRONT_WHEEL 2
+#define INPUT_REAR_WHEEL 6
+
+//Lockout settings
+#define INPUT_PADDLE_LOCKOUT_MS 50  //paddle microswitch bounce
+#define INPUT_HALL_LOCKOUT_MS 10    //hall effect sensors only chatter while the barrel settles
+
+void inputsInit(void);
+void inputsSetHandler(void (*handler)(uint8_t pin, uint32_t timestamp));
+
+#endif /* INPUTS_H_ */
@@ -0,0 +1,388 @@
+/*
+ * lightstrip.c
+ *
+ * SK9822 lightstrip frame buffer and DMA / interrupt transmission, see lightstrip.h.
+ * EUSCI_A2 and EUSCI_B0 themselves are configured in spiInit() in main.c.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "lightstrip.h"
+#include "ramfunc.h"
+#include "spi_rate.h"
+#include "memprotect.h"
+#include <string.h>
+
+#define LS_FRAME_WORDS ((LS_FRAME_BYTES + 3) / 4)
+#define LS_NO_BAR 0xFF
+
+typedef struct
+{
+    uint8_t strip;
+    uint8_t first;                  //led on the strip that is index 0 of the segment
+    uint8_t leds;
+} lsSegmentMap_t;
+
+typedef struct
+{
+    uint32_t spiBase;               //EUSCI module the strip hangs off
+    uint32_t dmaMapping;            //DMA_CHn_ channel and trigger, main strip only
+    uint8_t dmaChannel;
+    uint8_t leds;                   //leds on the strip, its segments end here
+} lsPort_t;
+
+typedef struct
+{
+    uint32_t frame[2][LS_FRAME_WORDS];//start frame, led frames, end frame exactly as they go out on the wire, word aligned for lsSetPacked()
+    uint8_t *front;                 //last frame handed to the DMA, never written while it may be on the wire
+    uint8_t *back;                  //frame being drawn
+    const uint8_t *onWire;          //whichever frame was sent last, its led frames are what the strip shows
+    bool known;                     //0 until one whole frame has been sent, the strip may hold anything after a reset
+    DMA_ControlTable tasks[2];      //scatter gather: start + led frames from the frame buffer, then the end frame
+} lsStrip_t;
+
+static const lsSegmentMap_t lsSegments[LS_SEGMENTS] = {{LS_STRIP_MAIN, 0, NUM_LEDS}, {LS_STRIP_AUX, 0, LS_WARN_LEDS}};
+static const lsPort_t lsPorts[LS_STRIPS] = {{EUSCI_A2_BASE, DMA_CH4_EUSCIA2TX, 4, NUM_LEDS},
+                                            {EUSCI_B0_BASE, 0, 0, LS_WARN_LEDS}};//TX interrupt fed
+static lsStrip_t lsStrips[LS_STRIPS];
+static uint32_t lsFlashWords[LS_FRAME_WORDS];//precomputed all red shift light frame of the main strip
+#pragma DATA_SECTION(lsBarWords, ".display.cache")
+static uint32_t lsBarWords[NUM_LEDS + 1][LS_FRAME_WORDS];//read only to the MPU outside lsSetBars() (memprotect.h), precomputed meter frames, bar k lights leds 0 to k - 1 from the palette, bar 0 is all off
+static uint8_t *const lsFlashFrame = (uint8_t *)lsFlashWords;
+static uint8_t *const lsOffFrame = (uint8_t *)lsBarWords[0];
+static const uint8_t lsEndFrame[LS_END_BYTES] = {0};//reset frame and latch clocks, sent after the last changed led
+static volatile bool lsBusyFlag = 0;//main strip, cleared by its DMA interrupt
+static volatile bool lsAuxBusyFlag = 0;//aux strip, cleared by the EUSCI_B0 interrupt after the last byte
+static const uint8_t *lsAuxNext;//next aux strip byte for TXBUF
+static volatile uint16_t lsAuxLeft = 0;//frame bytes still to load
+static uint8_t lsAuxEndLeft = 0;//end frame bytes after them
+static void (*lsCallback)(void) = 0;
+static uint8_t lsBrightness = BRIGHTNESS;//global brightness of lsSetLED()
+
+static void lsClearStrip(uint8_t *frame)//all leds off, start and end frames 0s
+{
+    uint16_t k;
+
+    memset(frame, 0, LS_FRAME_BYTES);
+    for(k = 0; k < LS_STRIP_MAX_LEDS; k++)
+    {
+        frame[LS_START_BYTES + (k * LS_LED_BYTES)] = 224;//led frame header, 0 brightness
+    }
+}
+
+static void lsBuildFlash(void)//draws the shift flash frame of the meter segment
+{
+    uint8_t *frame = lsStrips[LS_STRIP_MAIN].back;
+    uint8_t k;
+
+    lsClearStrip(frame);
+    for(k = 0; k < NUM_LEDS; k++)
+    {
+        lsSetLED(k, 255, 0, 0);
+    }
+    memcpy(lsFlashFrame, frame, LS_FRAME_BYTES);
+    lsClearStrip(frame);
+}
+
+void lsInit(void)//sets up DMA channel 4 to feed EUSCI_A2 TX and the EUSCI_B0 TX interrupt, call after spiInit() and dmaTableInit()
+{
+    lsStrip_t *strip;
+    uint8_t s;
+
+    for(s = 0; s < LS_STRIPS; s++)
+    {
+        strip = &lsStrips[s];
+        strip->front = (uint8_t *)strip->frame[0];
+        strip->back = (uint8_t *)strip->frame[1];
+        lsClearStrip(strip->front);
+        lsClearStrip(strip->back);
+        strip->onWire = strip->front;
+        strip->known = 0;
+    }
+    lsBuildFlash();
+
+    MAP_DMA_assignChannel(lsPorts[LS_STRIP_MAIN].dmaMapping);
+    MAP_DMA_disableChannelAttribute(lsPorts[LS_STRIP_MAIN].dmaMapping, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);//transfers are set up per frame by lsStart(), one byte per TXIFG
+    MAP_DMA_assignInterrupt(DMA_INT1, lsPorts[LS_STRIP_MAIN].dmaChannel);
+    MAP_DMA_clearInterruptFlag(lsPorts[LS_STRIP_MAIN].dmaChannel);
+    MAP_Interrupt_enableInterrupt(DMA_INT1);
+
+    EUSCI_B0->IE &= ~EUSCI_B_IE_TXIE0;//only set while an aux frame is loading
+    MAP_Interrupt_enableInterrupt(INT_EUSCIB0);
+}
+
+void lsSetBrightness(uint8_t brightness)//SK9822 global brightness 0-31 for every led drawn from now on, main loop only
+{
+    uint8_t s;
+
+    lsBrightness = brightness & 0x1F;
+    lsBuildFlash();//a flash frame on the wire right now goes out with mixed brightness once
+    for(s = 0; s < LS_STRIPS; s++)
+    {
+        lsStrips[s].known = 0;//the strips still show the old brightness, next frames go out whole
+    }
+}
+
+void lsSetBars(const uint32_t *palette)//rebuilds the NUM_LEDS + 1 meter bar frames from the LS_PACK() frame of each led when lit, main loop only
+{
+    uint32_t *leds;
+    uint8_t bar;
+    uint8_t k;
+
+    while(lsBusy());//the DMA may be sending one of these frames, a rewrite under it latches torn
+    memProtectCache(1);
+    for(bar = 0; bar <= NUM_LEDS; bar++)
+    {
+        lsClearStrip((uint8_t *)lsBarWords[bar]);
+        leds = (uint32_t *)&((uint8_t *)lsBarWords[bar])[LS_START_BYTES];
+        for(k = 0; k < bar; k++)
+        {
+            leds[k] = palette[k];
+        }
+    }
+    memProtectCache(0);
+    lsStrips[LS_STRIP_MAIN].known = 0;//a bar frame on the strip may no longer match its buffer, next frame goes out whole
+}
+
+RAMFUNC void lsSegmentSet(lsSegment_t segment, uint8_t index, uint32_t led)//writes a whole LS_PACK() led frame to a segment of the back buffers in one store
+{
+    const lsSegmentMap_t *map = &lsSegments[segment];
+
+    ((uint32_t *)&lsStrips[map->strip].back[LS_START_BYTES])[map->first + index] = led;
+}
+
+RAMFUNC void lsSetLED(uint8_t index, uint8_t red, uint8_t green, uint8_t blue)//led frame format for lightstrip as detailed in SK9822 datasheet, written to the meter segment back buffer
+{
+    lsSegmentSet(LS_SEG_METER, index, LS_PACK(lsBrightness, red, green, blue));
+}
+
+RAMFUNC void lsSetPacked(uint8_t index, uint32_t led)//writes a whole LS_PACK() led frame to the meter segment in one store
+{
+    lsSegmentSet(LS_SEG_METER, index, led);
+}
+
+void lsClearFrame(void)//turns all leds in every back buffer off
+{
+    uint8_t s;
+
+    for(s = 0; s < LS_STRIPS; s++)
+    {
+        lsClearStrip(lsStrips[s].back);
+    }
+}
+
+static RAMFUNC bool lsStripBusy(uint8_t s)
+{
+    return (s == LS_STRIP_MAIN) ? lsBusyFlag : lsAuxBusyFlag;
+}
+
+static RAMFUNC uint8_t lsChanged(uint8_t s, const uint8_t *frame)//leds up to and including the last one that differs from the strip, 0 if none
+{
+    const uint32_t *next = (const uint32_t *)&frame[LS_START_BYTES];
+    const uint32_t *shown = (const uint32_t *)&lsStrips[s].onWire[LS_START_BYTES];
+    uint8_t leds = lsPorts[s].leds;
+
+    if(!lsStrips[s].known)
+    {
+        return leds;
+    }
+    while(leds && (next[leds - 1] == shown[leds - 1]))
+    {
+        leds--;
+    }
+    return leds;
+}
+
+static RAMFUNC void lsStart(uint8_t s, const uint8_t *frame, uint8_t leds)//sends the start frame, the first leds led frames and an end frame sized for them, strip must not be busy
+{
+    lsStrip_t *strip = &lsStrips[s];
+    const lsPort_t *port = &lsPorts[s];
+    uint16_t dataBytes = LS_START_BYTES + ((uint16_t)leds * LS_LED_BYTES);
+    uint16_t endBytes = 4 + ((leds + 15) / 16);//the leds past these never see the data and keep what they show
+    void *txBuffer = (void *)MAP_SPI_getTransmitBufferAddressForDMA(port->spiBase);
+
+    strip->onWire = frame;
+    strip->known = 1;
+    if(s != LS_STRIP_MAIN)//TXIFG is set with TXBUF empty, so enabling TXIE starts the ISR
+    {
+        lsAuxNext = frame;
+        lsAuxLeft = dataBytes;
+        lsAuxEndLeft = endBytes;
+        lsAuxBusyFlag = 1;
+        EUSCI_B0->IE |= EUSCI_B_IE_TXIE0;
+        return;
+    }
+    lsBusyFlag = 1;
+    strip->tasks[0] = (DMA_ControlTable)DMA_TaskStructEntry(dataBytes, UDMA_SIZE_8, UDMA_SRC_INC_8, frame,
+                                                            UDMA_DST_INC_NONE, txBuffer, UDMA_ARB_1, UDMA_MODE_PER_SCATTER_GATHER);
+    strip->tasks[1] = (DMA_ControlTable)DMA_TaskStructEntry(endBytes, UDMA_SIZE_8, UDMA_SRC_INC_8, lsEndFrame,
+                                                            UDMA_DST_INC_NONE, txBuffer, UDMA_ARB_1, UDMA_MODE_BASIC);
+    MAP_DMA_setChannelScatterGather(port->dmaMapping, 2, strip->tasks, 1);
+    MAP_DMA_enableChannel(port->dmaChannel);
+
+    EUSCI_A2->IFG &= ~EUSCI_A_IFG_TXIFG;//re-arm TXIFG so the DMA sees a new request for the first byte
+    EUSCI_A2->IFG |=  EUSCI_A_IFG_TXIFG;
+}
+
+static RAMFUNC bool lsShowStrip(uint8_t s)//swaps the back buffer to the front and DMAs the changed prefix, returns 0 if the last frame is still sending
+{
+    lsStrip_t *strip = &lsStrips[s];
+    uint8_t *drawn;
+    uint8_t leds;
+
+    if(lsStripBusy(s))
+    {
+        return 0;
+    }
+    leds = lsChanged(s, strip->back);
+    if(!leds)//nothing changed since the last frame, skip sending it
+    {
+        return 1;
+    }
+
+    drawn = strip->back;//swap buffers, the DMA only ever reads the front buffer
+    strip->back = strip->front;
+    strip->front = drawn;
+    memcpy(strip->back, strip->front, LS_FRAME_BYTES);//next frame starts drawing from what is on the strip
+
+    lsStart(s, strip->front, leds);
+    return 1;
+}
+
+static RAMFUNC bool lsShowAux(void)//every strip but the main one
+{
+    bool sent = 1;
+    uint8_t s;
+
+    for(s = LS_STRIP_MAIN + 1; s < LS_STRIPS; s++)
+    {
+        sent &= lsShowStrip(s);
+    }
+    return sent;
+}
+
+RAMFUNC bool lsShow(void)//sends every strip that changed, returns 0 if one of them was still sending its last frame
+{
+    bool sent = lsShowAux();
+
+    return lsShowStrip(LS_STRIP_MAIN) && sent;
+}
+
+static RAMFUNC uint8_t lsBarShown(void)//bar the main strip shows straight from the cache, LS_NO_BAR if it shows any other frame
+{
+    const uint8_t *shown = lsStrips[LS_STRIP_MAIN].onWire;
+
+    if(!lsStrips[LS_STRIP_MAIN].known || (shown < (const uint8_t *)lsBarWords[0]) ||
+       (shown >= (const uint8_t *)lsBarWords[NUM_LEDS + 1]))
+    {
+        return LS_NO_BAR;
+    }
+    return (shown - (const uint8_t *)lsBarWords[0]) / sizeof(lsBarWords[0]);
+}
+
+static RAMFUNC bool lsShowFrame(const uint8_t *frame, uint8_t leds)//sends a precomputed meter frame whose first leds leds are not already on the strip, and the other strips as drawn
+{
+    lsStrip_t *strip = &lsStrips[LS_STRIP_MAIN];
+    bool sent = lsShowAux();
+
+    if(lsBusyFlag)
+    {
+        return 0;
+    }
+    if(frame != strip->onWire)
+    {
+        if(leds)
+        {
+            lsStart(LS_STRIP_MAIN, frame, leds);
+        }
+        else
+        {
+            strip->onWire = frame;//already showing it
+        }
+    }
+    return sent;
+}
+
+RAMFUNC bool lsShowFlash(bool on)//sends the precomputed all red (on) or all off meter frame, only the part that is not already on the strip, and the other strips as drawn
+{
+    const uint8_t *frame = on ? lsFlashFrame : lsOffFrame;
+
+    return lsShowFrame(frame, lsChanged(LS_STRIP_MAIN, frame));
+}
+
+RAMFUNC bool lsShowBar(uint8_t lit)//sends the precomputed meter frame with the first lit leds on (lsSetBars()) and the other strips as drawn
+{
+    uint8_t shown = lsBarShown();
+    const uint8_t *frame = (const uint8_t *)lsBarWords[lit];
+
+    if(shown == LS_NO_BAR)
+    {
+        return lsShowFrame(frame, lsChanged(LS_STRIP_MAIN, frame));
+    }
+    return lsShowFrame(frame, (shown > lit) ? shown : lit);//two bars differ in the leds between their tops, no compare needed
+}
+
+bool lsBusy(void)//1 while a main strip frame is still being loaded into EUSCI_A2
+{
+    return lsBusyFlag;
+}
+
+bool lsQuiet(void)//1 when neither strip has a frame on its way
+{
+    uint8_t s;
+
+    for(s = 0; s < LS_STRIPS; s++)
+    {
+        if(lsStripBusy(s))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void lsSetClock(uint32_t smclk)//keeps LS_SPI_HZ on a new SMCLK, call with lsQuiet() (power.c)
+{
+    EUSCI_A2->CTLW0 |= EUSCI_A_CTLW0_SWRST;
+    EUSCI_A2->BRW = SPI_BRW_AT(smclk, LS_SPI_HZ);
+    EUSCI_A2->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;//fed by the DMA, no IE to restore
+    EUSCI_B0->CTLW0 |= EUSCI_B_CTLW0_SWRST;
+    EUSCI_B0->BRW = SPI_BRW_AT(smclk, LS_SPI_HZ);
+    EUSCI_B0->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;//with both quiet the aux TXIE is off, no IE to restore
+}
+
+void lsSetCallback(void (*callback)(void))//callback is run from the DMA interrupt when a main strip frame has been sent
+{
+    lsCallback = callback;
+}
+
+RAMFUNC void DMA_INT1_IRQHandler(void)//Interrupt when the last main strip byte has been loaded into EUSCI_A2
+{
+    MAP_DMA_clearInterruptFlag(lsPorts[LS_STRIP_MAIN].dmaChannel);
+    lsBusyFlag = 0;
+
+    if(lsCallback)
+    {
+        lsCallback();
+    }
+}
+
+RAMFUNC void EUSCIB0_IRQHandler(void)//TXIFG, loads the next aux strip byte, the end frame after the led frames
+{
+    if(lsAuxLeft)
+    {
+        EUSCI_B0->TXBUF = *lsAuxNext++;//clears TXIFG
+        lsAuxLeft--;
+    }
+    else
+    {
+        EUSCI_B0->TXBUF = 0;
+        lsAuxEndLeft--;
+    }
+    if(!lsAuxLeft && !lsAuxEndLeft)//last byte loaded, the strip latches it with the end frame
+    {
+        EUSCI_B0->IE &= ~EUSCI_B_IE_TXIE0;
+        lsAuxBusyFlag = 0;
+    }
+}
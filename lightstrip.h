@@ -0,0 +1,86 @@
+/*
+ * lightstrip.h
+ *
+ * Frame buffer driver for the SK9822 lightstrips: the RPM strip on EUSCI_A2 (P3.1 and P3.3,
+ * DMA channel 4) and the warning light strip on EUSCI_B0 (P1.5 and P1.6, TX interrupt).
+ * The display is drawn in logical segments (lsSegment_t) that map onto a range of leds of one
+ * strip, so a longer bar or another cluster of lights is a line in the segment and port tables
+ * of lightstrip.c. Each strip has its own start/LED/end frames in RAM. The meter strip is sent to
+ * its SPI transmit buffer by DMA with a DMA interrupt at the end (lsDone() callback), so the CPU
+ * is free while it is being refreshed. The warning strip is ~40 bytes and only changes with an
+ * alert, so it is loaded byte by byte from the EUSCI_B0 TX interrupt and leaves DMA channel 6 to
+ * the ECU link (ecu.h).
+ * Drawing goes to a back buffer, either as colours at the global brightness (lsSetLED()) or as
+ * led frames packed ahead of time with their own brightness (lsSetPacked() for the meter,
+ * lsSegmentSet() for any segment, LS_PACK()); lsShow()
+ * only swaps and sends it when it differs from the frame last sent, so unchanged frames cost no
+ * SPI traffic.
+ * Only the prefix of the strip up to the last changed led goes out, followed by an end frame
+ * sized for that prefix (DMA scatter gather from the frame buffer and a const end frame). The
+ * leds past the prefix never see new data and keep what they show, so a meter that moves by one
+ * led near the bottom costs a few bytes instead of a whole frame. The first frame after a reset
+ * is always sent whole.
+ * The shift light flash frames cover the whole meter strip, they are built at init and on a
+ * brightness change, and sent straight from their own buffers.
+ * The same goes for the plain meter bar: there are only NUM_LEDS + 1 of them, so each is kept as
+ * a finished frame built from the meter palette (lsSetBars(), on a palette change) and
+ * lsShowBar() only picks one and starts the DMA. The changed prefix between two bars is the
+ * higher of their tops, so a bar frame costs the same however long the strip is. A frame with a
+ * peak marker or an overlay on top is still drawn into the back buffer. The bar frames have a
+ * section of their own that the MPU keeps read only outside lsSetBars() (memprotect.h).
+ */
+
+#ifndef LIGHTSTRIP_H_
+#define LIGHTSTRIP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Lightstrip value settings, the brightness and colour zones are defaults for the parameter store (params.h)
+#define BRIGHTNESS 3                //SK9822 global brightness, 0-31
+#define NUM_GREEN_LEDS 18
+#define NUM_YELLOW_LEDS 6
+#define NUM_RED_LEDS 6
+#define NUM_LEDS (NUM_GREEN_LEDS + NUM_YELLOW_LEDS + NUM_RED_LEDS)//LEDs on the strip, fixes the frame size
+#define LS_WARN_LEDS 8              //warning lights on the second strip
+#define LS_SPI_HZ 12000000          //EUSCI_A2 and EUSCI_B0 bit rate, up to SPI_MAX_HZ (spi_rate.h), SK9822 clock and data are re-timed at every led
+
+#define LS_STRIPS 2
+#define LS_STRIP_MAIN 0             //EUSCI_A2, the meter
+#define LS_STRIP_AUX 1              //EUSCI_B0, warning lights
+#define LS_STRIP_MAX_LEDS ((NUM_LEDS > LS_WARN_LEDS) ? NUM_LEDS : LS_WARN_LEDS)//sizes every strip frame buffer
+
+//SK9822 frame layout as detailed in SK9822 datasheet
+#define LS_START_BYTES 4                                //32 bit start frame of 0s
+#define LS_LED_BYTES 4                                  //brightness, blue, green, red
+#define LS_END_BYTES (4 + ((LS_STRIP_MAX_LEDS + 15) / 16))  //32 bit reset frame + 1 clock per 2 leds to latch the last led
+#define LS_FRAME_BYTES (LS_START_BYTES + (LS_STRIP_MAX_LEDS * LS_LED_BYTES) + LS_END_BYTES)
+
+//led frame as one little endian word: 3 start bits and the 5 bit per led brightness, then blue, green, red
+#define LS_PACK(brightness, red, green, blue) ((uint32_t)(224 | ((brightness) & 0x1F)) | ((uint32_t)(blue) << 8) | \
+        ((uint32_t)(green) << 16) | ((uint32_t)(red) << 24))
+#define LS_LED_OFF LS_PACK(0, 0, 0, 0)
+
+typedef enum
+{
+    LS_SEG_METER,                   //NUM_LEDS, main strip
+    LS_SEG_WARNING,                 //LS_WARN_LEDS, aux strip
+    LS_SEGMENTS
+} lsSegment_t;
+
+void lsInit(void);
+void lsSetBrightness(uint8_t brightness);
+void lsSetBars(const uint32_t *palette);
+void lsSetLED(uint8_t index, uint8_t red, uint8_t green, uint8_t blue);
+void lsSetPacked(uint8_t index, uint32_t led);
+void lsSegmentSet(lsSegment_t segment, uint8_t index, uint32_t led);
+void lsClearFrame(void);
+bool lsShow(void);
+bool lsShowFlash(bool on);
+bool lsShowBar(uint8_t lit);
+bool lsBusy(void);
+bool lsQuiet(void);
+void lsSetClock(uint32_t smclk);
+void lsSetCallback(void (*callback)(void));
+
+#endif /* LIGHTSTRIP_H_ */
@@ -0,0 +1,130 @@
+/*
+ * logcrypt.c
+ *
+ * AES-256 counter mode encryption of log dumps, see logcrypt.h.
+ * Everything here runs in the main loop, the AES256 module has no other user.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "logcrypt.h"
+#include "fram.h"
+#include "crc.h"
+#include <string.h>
+
+static logCryptKey_t logCryptKey;//key in use, all zero for plain dumps
+static uint8_t logCryptBlock[FRAM_HEADER_BYTES + sizeof(logCryptKey_t)];//key record on its way to the FRAM
+static volatile bool logCryptKeyDone = 1;//logCryptBlock is free, set by the FRAM driver
+static bool logCryptKeyDirty = 0;//logCryptKey not written to the FRAM yet
+static uint32_t logCryptNonce = 0;//last nonce used
+static uint32_t logCryptAddress = 0;//start address of the dump being encrypted
+
+static bool logCryptNonceValid(const logCryptNonce_t *record)
+{
+    return crcBlock(&record->nonce, sizeof(record->nonce)) == record->crc;
+}
+
+void logCryptRestore(void)//blocking read of the key and the last nonce, call at start up
+{
+    logCryptNonce_t slot[2];
+
+    framRead(LOGCRYPT_BASE, (uint8_t *)&logCryptKey, sizeof(logCryptKey_t));
+    if(crcBlock(logCryptKey.key, LOGCRYPT_KEY_BYTES) != logCryptKey.crc)
+    {
+        memset(logCryptKey.key, 0, LOGCRYPT_KEY_BYTES);//blank or torn, plain dumps until a key is set
+    }
+    framRead(LOGCRYPT_NONCE_BASE, (uint8_t *)slot, sizeof(slot));
+    if(logCryptNonceValid(&slot[0]))
+    {
+        logCryptNonce = slot[0].nonce;
+    }
+    if(logCryptNonceValid(&slot[1]) && (slot[1].nonce > logCryptNonce))
+    {
+        logCryptNonce = slot[1].nonce;
+    }
+}
+
+bool logCryptEnabled(void)//1 while a key is set
+{
+    uint8_t any = 0;
+    uint8_t k;
+
+    for(k = 0; k < LOGCRYPT_KEY_BYTES; k++)
+    {
+        any |= logCryptKey.key[k];
+    }
+    return any != 0;
+}
+
+bool logCryptSetKey(const uint8_t *oldKey, const uint8_t *newKey)//replaces the key and saves it, returns 0 if oldKey is not the key in use
+{
+    uint8_t diff = 0;
+    uint8_t k;
+
+    for(k = 0; k < LOGCRYPT_KEY_BYTES; k++)//every byte compared, the reply time says nothing about the key
+    {
+        diff |= oldKey[k] ^ logCryptKey.key[k];
+    }
+    if(diff)
+    {
+        return 0;
+    }
+    memcpy(logCryptKey.key, newKey, LOGCRYPT_KEY_BYTES);
+    logCryptKey.crc = crcBlock(logCryptKey.key, LOGCRYPT_KEY_BYTES);
+    logCryptKeyDirty = 1;
+    logCryptService();
+    return 1;
+}
+
+bool logCryptStart(uint32_t address, uint32_t *nonce)//loads the key and queues the next nonce to the FRAM ahead of the dump reads, returns 0 if the FRAM queue is full
+{
+    logCryptNonce_t record;
+
+    record.nonce = logCryptNonce + 1;
+    record.crc = crcBlock(&record.nonce, sizeof(record.nonce));
+    if(!framWrite(LOGCRYPT_NONCE_BASE + ((record.nonce & 1) * sizeof(logCryptNonce_t)),
+                  (const uint8_t *)&record, sizeof(logCryptNonce_t)))
+    {
+        return 0;
+    }
+    logCryptNonce = record.nonce;
+    logCryptAddress = address;
+    MAP_AES256_reset(AES256_BASE);
+    MAP_AES256_setCipherKey(AES256_BASE, logCryptKey.key, AES256_KEYLENGTH_256BIT);
+    *nonce = logCryptNonce;
+    return 1;
+}
+
+void logCryptApply(uint8_t *data, uint16_t length, uint32_t offset)//encrypts a run of a chunk in place, offset from the dump start is a multiple of LOGCRYPT_BLOCK_BYTES
+{
+    uint32_t counter[LOGCRYPT_BLOCK_BYTES / 4] = {logCryptNonce, logCryptAddress, 0, offset / LOGCRYPT_BLOCK_BYTES};
+    uint8_t stream[LOGCRYPT_BLOCK_BYTES];
+    uint16_t k;
+
+    for(k = 0; k < length; k++)
+    {
+        if(!(k % LOGCRYPT_BLOCK_BYTES))
+        {
+            MAP_AES256_encryptData(AES256_BASE, (const uint8_t *)counter, stream);//~170 MCLK cycles
+            counter[3]++;
+        }
+        data[k] ^= stream[k % LOGCRYPT_BLOCK_BYTES];
+    }
+}
+
+void logCryptService(void)//writes a changed key once the last one is out, call on EVENT_FRAM_DONE
+{
+    if(!logCryptKeyDirty || !logCryptKeyDone)
+    {
+        return;
+    }
+    memcpy(&logCryptBlock[FRAM_HEADER_BYTES], &logCryptKey, sizeof(logCryptKey_t));
+    logCryptKeyDone = 0;
+    if(framWriteBlock(LOGCRYPT_BASE, logCryptBlock, sizeof(logCryptKey_t), &logCryptKeyDone))
+    {
+        logCryptKeyDirty = 0;
+    }
+    else
+    {
+        logCryptKeyDone = 1;//queue full, try again on the next EVENT_FRAM_DONE
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * logcrypt.h
+ *
+ * Optional encryption of log dumps (download.h) on the AES256 accelerator, AES-256 in counter
+ * mode. Each 16 byte counter block is encrypted by the hardware into key stream that the CPU
+ * XORs over the chunk, ~100 us of a 256 byte chunk's ~2.8 ms on the wire. logCryptApply() takes
+ * any run of whole blocks, so the download encrypts a chunk in slices from a background task
+ * while the one before it is sent (download.h); a dump still moves at the line rate and the FRAM
+ * read ahead is untouched.
+ * Counter block, little endian: uint32 nonce, uint32 dump start address, uint32 0, uint32 block
+ * index from the start of the dump. Every dump takes a new nonce, saved to the FRAM before the
+ * first chunk is read so a power loss never reuses one with the same key.
+ * With no key stored dumps are plain. The key is set over the download port ('E', download.h)
+ * with the old key in front of the new one, so a key in place can only be changed or cleared
+ * (an all zero new key) by whoever knows it. The key record has a CRC32, the nonce alternates
+ * between two slots like the checkpoints.
+ */
+
+#ifndef LOGCRYPT_H_
+#define LOGCRYPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "peak.h"
+
+//Log encryption settings
+#define LOGCRYPT_BASE (PEAK_BASE + sizeof(peakRecord_t))
+#define LOGCRYPT_KEY_BYTES 32
+#define LOGCRYPT_BLOCK_BYTES 16
+#define LOGCRYPT_NONCE_BASE (LOGCRYPT_BASE + sizeof(logCryptKey_t))
+#define LOGCRYPT_UPLOAD_BYTES (2 * LOGCRYPT_KEY_BYTES)//payload of the 'E' command, old key then new key
+
+typedef struct
+{
+    uint8_t key[LOGCRYPT_KEY_BYTES];//all zero for plain dumps
+    uint32_t crc;                   //CRC32 of the key
+} logCryptKey_t;
+
+typedef struct
+{
+    uint32_t nonce;                 //last nonce used, the higher valid slot wins
+    uint32_t crc;                   //CRC32 of the nonce
+} logCryptNonce_t;
+
+void logCryptRestore(void);
+bool logCryptEnabled(void);
+bool logCryptSetKey(const uint8_t *oldKey, const uint8_t *newKey);
+bool logCryptStart(uint32_t address, uint32_t *nonce);
+void logCryptApply(uint8_t *data, uint16_t length, uint32_t offset);
+void logCryptService(void);
+
+#endif /* LOGCRYPT_H_ */
@@ -0,0 +1,67 @@
+/*
+ * logscan.c
+ *
+ * Binary search for the newest record of a circular FRAM log, see logscan.h.
+ */
+
+#include "logscan.h"
+
+void logScan(uint16_t slots, logScanRead_t read, logScan_t *result)//blocking, finds the head of a log of slots records
+{
+    uint32_t first;//sequence of slot 0
+    uint32_t sequence;
+    uint16_t low = 0;//newest slot known to follow slot 0
+    uint16_t high = slots;//first slot known not to
+    uint16_t mid;
+
+    result->next = 0;
+    result->sequence = 0;
+    result->stored = 0;
+    if(!read(0, &first))
+    {
+        if(read(slots - 1, &sequence))//wrapped and the write to slot 0 was torn
+        {
+            result->sequence = sequence + 1;
+            result->stored = slots - 1;
+        }
+        if(result->sequence == 0xFFFFFFFF)//never written, reads as blank
+        {
+            result->sequence = 0;
+        }
+        return;//otherwise blank
+    }
+    while((high - low) > 1)
+    {
+        mid = low + ((high - low) >> 1);
+        if(read(mid, &sequence) && (sequence == (first + mid)))
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    result->next = (low + 1) % slots;
+    result->sequence = first + low + 1;
+    if(result->sequence == 0xFFFFFFFF)
+    {
+        result->sequence = 0;
+    }
+    if((low + 1) == slots)//every slot written on this lap
+    {
+        result->stored = slots;
+    }
+    else if(read(low + 1, &sequence))//older lap after the head
+    {
+        result->stored = slots;
+    }
+    else if(((low + 2) < slots) && read(low + 2, &sequence))//older lap, the slot after the head was torn
+    {
+        result->stored = slots - 1;
+    }
+    else//first lap
+    {
+        result->stored = low + 1;
+    }
+}
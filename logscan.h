@@ -0,0 +1,30 @@
+/*
+ * logscan.h
+ *
+ * Start up search for the head of a circular FRAM log (shiftlog.h, telemetry.h). Records are
+ * written to consecutive slots with consecutive sequence numbers, so from slot 0 up to the
+ * newest record every slot holds the sequence of slot 0 plus its index, and nothing after the
+ * newest does (older records from the lap before, blank slots, or the one record a power loss
+ * tore). That makes the newest record a binary search, about log2(slots) + 3 slot reads
+ * however full the log is, instead of reading every slot.
+ * Only the record being written when power went can be torn, which is the slot after the head.
+ */
+
+#ifndef LOGSCAN_H_
+#define LOGSCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef bool (*logScanRead_t)(uint16_t slot, uint32_t *sequence);//reads slot, 0 if it is blank or fails its CRC
+
+typedef struct
+{
+    uint16_t next;                  //slot the next record goes in
+    uint32_t sequence;              //sequence number of the next record
+    uint32_t stored;                //valid records in the log
+} logScan_t;
+
+void logScan(uint16_t slots, logScanRead_t read, logScan_t *result);
+
+#endif /* LOGSCAN_H_ */
@@ -4,10 +4,12 @@
  * Date of Last Update: 2020.09.11
  * Version #: v1.0.0
  * Use: For use with custom EGR436 Dashboard PCB designed by Nigel Armstrong and John Santose. This program only performs current needed functions as a dashboard.
- *      This program does not add functions for bluetooth, usb interfacing, shift logging, smart shifting, or numeric RPM readout.
  * Description: This program measures RPM from the tachometer signal off of the PE3 ECU when set up for 8 tach pulses per rev.
  *              This program also automates shifting for paddle shifters, ensuring when a paddle is pulled, there is feedback to ensure a new gear is selected.
- *              This program also reports RPM readout to an adjustable RGB lightstrip with adjustable shift lights.
+ *              Every shift is logged to the onboard FRAM with RPM, gear and paddle to hall effect latency, along with the full RPM trace.
+ *              Logs are downloaded over the USB UART, see download.h, and live data is sent to the pit over bluetooth.
+ *              Upshifts at high RPM also signal a timed ignition cut to the ECU so they can be made flat foot.
+ *              This program also reports RPM readout to an adjustable RGB lightstrip with adjustable shift lights, and as a number on the 4-digit display.
  *              This program sets up all pins that are used on the EGR436 dashboard PCB, but not all are used for functions in this program.
  */
 
@@ -23,99 +25,334 @@
 #include "math.h"
 #include "string.h"
 
+/* Dashboard Includes */
+#include "battery.h"
+#include "bluetooth.h"
+#include "boot.h"
+#include "checkpoint.h"
+#include "clock.h"
+#include "crc.h"
+#include "digits.h"
+#include "dma_table.h"
+#include "engine.h"
+#include "download.h"
+#include "ecu.h"
+#include "events.h"
+#include "fram.h"
+#include "gear.h"
+#include "inputs.h"
+#include "shift.h"
+#include "shiftlog.h"
+#include "lightstrip.h"
+#include "spi_rate.h"
+#include "meter.h"
+#include "shiftpoints.h"
+#include "params.h"
+#include "peak.h"
+#include "logcrypt.h"
+#include "stats.h"
+#include "sched.h"
+#include "memstat.h"
+#include "memprotect.h"
+#include "power.h"
+#include "priority.h"
+#include "profile.h"
+#include "hil.h"
+#include "overlay.h"
+#include "program.h"
+#include "ramfunc.h"
+#include "rtc.h"
+#include "tach.h"
+#include "tach_filter.h"
+#include "tach_predict.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "watchdog.h"
+#include "wheel.h"
+#include "serial.h"
+
+
+#define FLASH_TICKS (CLOCK_ACLK_HZ / 8)//ACLK ticks per shift light flash toggle, 0.125 seconds
+#define WARN_BRIGHTNESS 31//warning lights stay at full brightness, battery alert amber on the left half, shift fault red on the right
+#define GEAR_CHECK_HZ 10//wheel ratio gear cross-check rate
+#define GEAR_CHECK_CONFIRM 10//checks in a row that have to disagree before gearIndex is corrected, 1 s
+#define PEAK_MARKER LS_PACK(31, 255, 255, 255)//peak hold led above the bar, white at full brightness
+#define RENDER_DEADLINE_US 5000//lightstrip frame request to frame on the wire, the refresh deadline the render task is held to
 
-//Lightstrip value settings
-#define BRIGHTNESS 3
-#define NUM_GREEN_LEDS 18
-#define NUM_YELLOW_LEDS 6
-#define NUM_RED_LEDS 6
-#define NUM_LEDS (NUM_GREEN_LEDS + NUM_YELLOW_LEDS + NUM_RED_LEDS)
-#define MAX_RPM 12000
-
-void sysTickInit(void);
-void msDelay(int delay);
 void pinInit(void);
 void spiInit(void);
-void sendSPIbyte(uint8_t s);
-void sendLS_START(void);
-void sendLS(uint8_t red, uint8_t green, uint8_t blue);
-void clearLS(void);
-void rpmtoLS(void);
+bool rpmtoLS(void);
+uint8_t alertState(void);
+void warningsDraw(uint8_t alerts);
+void lsDone(void);
+void framDone(void);
+void serialDone(void);
+void btStatus(void);
+void digitsRefresh(void);
+uint32_t digitsPeriod(void);
+void engineIdle(bool idle);
+void inputEdge(uint8_t pin, uint32_t timestamp);
+void gearCheck(void);
+void bootStep(void);
+void tachTask(void);
+void gearTask(void);
+void renderTask(void);
+void timerTask(void);
+void logTask(void);
+void commsTask(void);
+void batteryTask(void);
+void ecuTask(void);
+void ratioTask(void);
+void telemetryIdleTask(void);
+void cryptTask(void);
+void statusTask(void);
+void renderRequest(void);
 
-uint8_t lightstrip [NUM_LEDS] [3];
 int i;
 uint16_t rpm;
 uint8_t ledsON;
-uint16_t rpmCaptureValue;
+uint8_t peakLeds;
+uint32_t rpmCaptureValue;
+tachSample_t tachSample;
+shiftRecord_t shiftRecord;
+checkpoint_t dashState;
+swTimer_t btTimer;
+swTimer_t digitsTimer;
+swTimer_t bootTimer;
+bootMilestone_t bootStage = BOOT_SERIAL;
+bool bootWarm = 0;
 uint8_t gearIndex = 1;
-bool LSflash_flag = 0;
+volatile bool LSflash_flag = 0;
 bool LSflag = 0;
-bool up_flag = 0;
-bool down_flag = 0;
-uint8_t gearON  [10] = {0x77, 0x05, 0xB3, 0xA7, 0xC5, 0xE6, 0xF6, 0x07, 0xF7, 0xE7};
-uint8_t gearOFF [10] = {0x88, 0xFA, 0x4C, 0x58, 0x3A, 0x19, 0x09, 0xF8, 0x08, 0x18};
+bool shiftZone_flag = 0;
+uint8_t warningsShown = 0;
+uint8_t gearMismatch = 0;//gearCheck()s in a row the wheel ratio disagreed with gearIndex
+
+const schedTask_t tasks[] = {//main loop tasks, highest priority first: name, run, released by, period ms, deadline us (sched.h)
+    {"tach", tachTask, EVENT_BIT(EVENT_TACH) | EVENT_BIT(EVENT_STALL), 0, 2000},//before the ring fills at the rev limit
+    {"gear", gearTask, EVENT_BIT(EVENT_UPSHIFT) | EVENT_BIT(EVENT_DOWNSHIFT), 0, 5000},
+    {"render", renderTask, EVENT_BIT(EVENT_RENDER) | EVENT_BIT(EVENT_LS_DONE) | EVENT_BIT(EVENT_FLASH), 0, RENDER_DEADLINE_US},
+    {"timers", timerTask, EVENT_BIT(EVENT_TIMER), 0, 10000},
+    {"log", logTask, EVENT_BIT(EVENT_SHIFT_DONE) | EVENT_BIT(EVENT_FRAM_DONE), 0, 20000},
+    {"comms", commsTask, EVENT_BIT(EVENT_SERIAL_RX) | EVENT_BIT(EVENT_SERIAL_DONE), 0, 10000},
+    {"battery", batteryTask, EVENT_BIT(EVENT_BATTERY), 0, 50000},
+    {"ecu", ecuTask, EVENT_BIT(EVENT_ECU), 0, 50000},
+    {"ratio", ratioTask, 0, 1000 / GEAR_CHECK_HZ, 20000},
+    {"telem", telemetryIdleTask, 0, TELEM_IDLE_MS, 50000},
+    {"crypt", cryptTask, EVENT_BIT(EVENT_CRYPT), 0, 2000},//a whole chunk encrypted in the ~2.8 ms the last one is on the wire
+    {"status", statusTask, EVENT_BIT(EVENT_COUNT) - 1, 0, 20000},//any event, runs once the rest are done
+};
 
 void main(void)
 {
-    WDT_A->CTL = WDT_A_CTL_PW | WDT_A_CTL_HOLD;     // stop watchdog timer
-
-    pinInit();
-    sysTickInit();
+    WDT_A->CTL = WDT_A_CTL_PW | WDT_A_CTL_HOLD;     // stop watchdog timer until the boot has finished
+    memStatPaint();//stack high water mark, before any interrupt can run
+    memProtectInit();//MPU on before anything else runs, after the paint reached the stack guard
+    bootInit();//boot milestone stamps, see boot.h
+    bootWarm = watchdogWarmBoot();//watchdog reset, clocks and the 4-digit display are still set up
+
+    pinInit();//fast boot path on the reset clocks, restore the gear before waiting on the crystal
+    framPortInit();
+    if(bootWarm){
+        framWake();//the reset may have caught the FRAM asleep
+    }
+    if(checkpointRestore(&dashState) && (dashState.gear >= 1) && (dashState.gear <= 6)){
+        gearIndex = dashState.gear;
+    }
+    dashState.gear = gearIndex;
+    gearShow(gearIndex);
+    bootMark(BOOT_GEAR);
+    meterInit();
+    paramsRestore();//brightness, colour zones and max RPM, rebuilds the tables derived from them
+    shiftPointsRestore();//per gear meter thresholds, defaults from the max RPM if the FRAM has none
+    peakRestore();//the last session's peak RPM, record and over-rev count
+    logCryptRestore();//log dump key, plain dumps if none is set
+    statsRestore();//the last session's summary
+    meterSetGear(gearIndex);
+
+    clockInit();//48 MHz MCLK, 24 MHz SMCLK, everything below assumes these
+    powerInit();//VCORE1 onto the DC-DC
+    priorityInit();//before any interrupt is enabled
+    timebaseInit();
+    profileInit();//DWT cycle counter, Debug builds only
+    bootMark(BOOT_CLOCK);
+
+    dmaTableInit();//what the driver needs first: tach, paddles and shifting, lightstrip
+    crcInit();//DMA fed CRC32 for the FRAM logs
+    framInit();//DMA only, the checkpoint saves on every gear change
+    framSetCallback(framDone);
+    tachInit();
+    shiftInit();
+    inputsSetHandler(inputEdge);
+    inputsInit();//starts TIMER_A1
     spiInit();
+    lsInit();
+    lsSetCallback(lsDone);
+    lsSetBars(meterPalette);//meter bar frames from the palette paramsRestore() left
+    schedInit(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    bootMark(BOOT_LIVE);
+    swTimerStart(&bootTimer, 1, 0, bootStep);//everything else from the main loop
 
-    for(i = 0; i < NUM_LEDS; i++){//FOR LOOP TO LOAD COLOR SETTINGS INTO RPM LIGHTSTRIP
-        if(i < NUM_GREEN_LEDS){      //GREEN
-            lightstrip [i] [0] = 0;
-            lightstrip [i] [1] = 255;
-            lightstrip [i] [2] = 0;
-        }
-        else if((i < (NUM_GREEN_LEDS + NUM_YELLOW_LEDS)) && (i >= NUM_GREEN_LEDS)){//YELLOW
-            lightstrip [i] [0] = 255;
-            lightstrip [i] [1] = 255;
-            lightstrip [i] [2] = 0;
+    while (1)
+    {
+        eventWait();//sleep in LPM0 until an ISR posts an event
+        watchdogCheckIn(WDOG_TASK_LOOP);
+        schedRun();//highest priority released task, the rest on the next passes
+        watchdogService();
+    }
+}
+
+void tachTask(void){//tach edges captured or stopped, filter, predict, peak, stats and the RPM trace
+    if(eventTake(EVENT_TACH)){//New tach edges captured
+        if(engineState() == ENGINE_STALLED){//first edge after a stall, full speed before anything else
+            engineIdle(0);
         }
-        else{                        //RED
-            lightstrip [i] [0] = 255;
-            lightstrip [i] [1] = 0;
-            lightstrip [i] [2] = 0;
+        while(tachPop(&tachSample)){//Process every tach edge captured since the last pass
+            rpmCaptureValue = tachFilter(&tachSample);//glitch rejected, smoothed period
+            tachPredictAdd(tachSample.timestamp, rpmCaptureValue);
+            peakAdd(tachSample.timestamp, rpmCaptureValue);//peak hold and over-rev on capture counts
+            statsAdd(tachSample.timestamp, rpmCaptureValue, gearIndex);//session summary
+            if(bootDone()){
+                telemetryLog(tachSample.timestamp, tachCountToRPM(rpmCaptureValue));//RPM trace to the FRAM
+            }
         }
+        rpm = tachCountToRPM(rpmCaptureValue);//integer conversion, (SMCLK / 2 timer ticks * 60 seconds per minute) / (period ticks * 8 pulses per revolution)
+        shiftSetContext(rpm, gearIndex);//ignition cut time for the next upshift
+        engineUpdate(rpm);
+        renderRequest();
     }
+    if(eventTake(EVENT_STALL)){//no tach edge for a TACH_MIN_RPM period, the last RPM is stale
+        engineStall();
+        rpmCaptureValue = 0;
+        rpm = 0;
+        tachPredictReset();
+        shiftSetContext(rpm, gearIndex);
+        engineIdle(1);
+        renderRequest();//meter goes dark
+    }
+}
 
-    while (1)
-    {
-        if(LSflag){//If new RPM read in is available
-            rpmtoLS();
+void gearTask(void){//paddle shift confirmed by a hall effect
+    if(eventTake(EVENT_UPSHIFT) && gearIndex < 6){//If upshift paddle is pulled and current gear value is under 6
+        gearIndex++;//increase gear index
+        shiftSetContext(rpm, gearIndex);
+        wheelGearReset();//new ratio
+        meterSetGear(gearIndex);
+        dashState.gear = gearIndex;
+        checkpointSave(&dashState);//in the FRAM straight away, a brownout keeps the gear
+    }
+    else if(eventTake(EVENT_DOWNSHIFT) && gearIndex > 1){//If downshift paddle is pulled and current gear value is above 1
+        gearIndex--;//decrease gear index
+        shiftSetContext(rpm, gearIndex);
+        wheelGearReset();
+        meterSetGear(gearIndex);
+        dashState.gear = gearIndex;
+        checkpointSave(&dashState);//in the FRAM straight away, a brownout keeps the gear
+    }
+}
+
+void renderTask(void){//lightstrip frame, when one is wanted and the strip is free
+    eventTake(EVENT_RENDER);
+    eventTake(EVENT_LS_DONE);//Lightstrip is free again, a pending frame is retried below
+    if(eventTake(EVENT_FLASH) && shiftZone_flag){//Shift lights toggle on the TIMER_A1 cadence, not on tach edges
+        LSflag = 1;
+    }
+    if(LSflag){//If new RPM read in is available
+        PROFILE_BEGIN(PROF_RENDER);
+        HIL_FRAME_BEGIN();
+        bool sent = rpmtoLS();
+        HIL_FRAME_END();
+        PROFILE_END(PROF_RENDER);
+        if(sent){//frame sent or unchanged, otherwise try again once the last frame is finished
             LSflag = 0;//reset flag
         }
-        if(up_flag && gearIndex < 6){//If upshift paddle is pulled and current gear value is under 6
-            gearIndex++;//increase gear index
-            P4OUT |= gearON[gearIndex];//print increased gear to 7 segment
-            P4OUT &= ~gearOFF[gearIndex];//turn off superfluous segments
-            up_flag = 0;//reset flag
+    }
+}
+
+void timerTask(void){//software timers due
+    eventTake(EVENT_TIMER);
+    swTimerService();
+    watchdogCheckIn(WDOG_TASK_TIMERS);
+}
+
+void logTask(void){//finished shifts to the shift log, FRAM writes as the FRAM frees up
+    if(eventTake(EVENT_SHIFT_DONE) && bootDone()){//Log finished shifts to the FRAM, held in the shift ring until the log is scanned
+        while(shiftPop(&shiftRecord)){
+            shiftLogAppend(&shiftRecord);
+            btSendShift(&shiftRecord);//and to the pit
+            statsShift(&shiftRecord);
+            if(shiftRecord.faulted){
+                dashState.faults++;
+            }
+            else if(shiftRecord.dir == SHIFT_UP){
+                dashState.upshifts++;
+            }
+            else{
+                dashState.downshifts++;
+            }
         }
-        else if(down_flag && gearIndex > 1){//If downshift paddle is pulled and current gear value is above 1
-            gearIndex--;//decrease gear index
-            P4OUT |= gearON[gearIndex];//print decreased gear to 7 segment
-            P4OUT &= ~gearOFF[gearIndex];//turn off superfluous segments
-            down_flag = 0;//reset flag
+        checkpointSave(&dashState);
+    }
+    if(eventTake(EVENT_FRAM_DONE)){//FRAM free, the dash checkpoint and shift records go first, then telemetry blocks
+        checkpointService();
+        shiftPointsService();
+        paramsService();
+        peakService();
+        logCryptService();
+        statsService();
+        if(bootDone()){
+            shiftLogService();
+            telemetryService();
+            downloadService();//a dump waits for log writes
         }
     }
 }
 
-void sysTickInit(void)//Initializes systick timer for use in delays
-{
+void commsTask(void){//log download commands and streaming
+    if((eventTake(EVENT_SERIAL_RX) | eventTake(EVENT_SERIAL_DONE)) && bootDone()){//| so both events are taken
+        serialService();//idle line poll during a burst
+        downloadService();
+    }
+}
+
+void batteryTask(void){//battery left or came back into range, tell the pit now instead of at the next status frame
+    eventTake(EVENT_BATTERY);
+    btStatus();
+}
+
+void ecuTask(void){//engine alert from the ECU data came on or went off, tell the pit now
+    eventTake(EVENT_ECU);
+    btStatus();
+}
 
-    SysTick->CTRL &= ~BIT0; //clears enable to stop the counter
-    SysTick->LOAD = 0x00FFFFFF; //sets the period... note: (3006600/1000 - 1) = 1ms
-    SysTick->VAL = 0; //clears the value
-    SysTick->CTRL = 0x00000005; //enable SysTick, without interrupts
+void ratioTask(void){//periodic wheel ratio gear cross-check, from BOOT_LOGS
+    if(bootDone()){
+        gearCheck();
+    }
 }
 
-void msDelay(int delay){//input # of ms to delay (assuming 48 MHz sysclock)
+void telemetryIdleTask(void){//periodic, writes out a telemetry block that stopped filling, from BOOT_LOGS
+    if(bootDone()){
+        telemetryTick();
+    }
+}
+
+void cryptTask(void){//background encryption of a dump chunk, one slice per run
+    eventTake(EVENT_CRYPT);
+    downloadCrypt();
+}
+
+void statusTask(void){//after everything else on any event, gear indicator and alert lights
+    gearShow(shiftFaulted() ? GEAR_FAULT : gearIndex);//only writes the port when the glyph changes
+    uint8_t alerts = alertState();
+    if(overlayUpdate(alerts) || programUpdate() || (alerts != warningsShown)){//alert overlay blink step, pit program step or warning lights change without a tach edge, e.g. with the engine off
+        renderRequest();
+    }
+}
 
-    SysTick->LOAD = delay * 48000 - 1;           //counts up to delay
-    SysTick->VAL = 0;                           //starts counting from 0
-    while ((SysTick->CTRL & 0x00010000) == 0);  //wait until flag is set (delay number is reached)
+void renderRequest(void){//new lightstrip frame wanted
+    LSflag = 1;
+    eventPost(EVENT_RENDER);
 }
 
 void pinInit(void){//initializes all IO pins available on custom board
@@ -126,6 +363,10 @@ void pinInit(void){//initializes all IO pins available on custom board
     P1SEL1 &= ~0x01;
     P1DIR |= 0x01;
 
+    //SPI pins 1.5 and 1.6 for the warning light strip
+    P1SEL0 |=  0x60;//0b.0110.0000
+    P1SEL1 &= ~0x60;
+
     //SPI pins 2.1, 2.2, 2.3, and 7.4 for FRAM interfacing
     P2SEL0 |=  0x0E;//0b.0000.1110
     P2SEL1 &= ~0x0E;
@@ -145,6 +386,11 @@ void pinInit(void){//initializes all IO pins available on custom board
     P4DIR  |=  0xFF;//Outputs
     P4OUT  &= ~0xFF;//All off
 
+    //Interrupt pin 5.0 for the ECU CAN controller
+    P5SEL0 &= ~0x01;//0b.0000.0001
+    P5SEL1 &= ~0x01;
+    P5DIR  &= ~0x01;//Input, interrupt set up by ecuInit()
+
     //ADC pin 5.5 for battery voltage
     P5SEL0 |=  0x20;//0b.0010.0000
     P5SEL1 |=  0x20;
@@ -158,10 +404,15 @@ void pinInit(void){//initializes all IO pins available on custom board
     P6IE   |=  0x77;//Interrupt enable
 
     //TimerA CC pin 7.3 for tachometer read from ECU
+#if TACH_COMP_ENABLE
+    P7SEL0 |=  0x20;//0b.0010.0000, comparator input 7.5 instead (TACH_COMP_INPUT), analog
+    P7SEL1 |=  0x20;
+#else
     P7SEL0 |=  0x08;//0b.0000.1000
     P7SEL1 &= ~0x08;
+#endif
 
-    //GPIO pins 8.4-8.6 for shifting relay outputs
+    //GPIO pins 8.4-8.5 for shifting relay outputs, 8.6 for ignition cut to ECU
     P8SEL0 &= ~0x70;//0b.0111.0000
     P8SEL1 &= ~0x70;
     P8DIR  |=  0x70;//Outputs
@@ -170,24 +421,18 @@ void pinInit(void){//initializes all IO pins available on custom board
     //UART pins 9.6 and 9.7 for Bluetooth interfacing
     P9SEL0 |=  0xC0;//0b.1100.0000
     P9SEL1 &= ~0xC0;
+
+    //SPI pins 10.1-10.3 and 10.0 for the ECU CAN controller
+    P10SEL0 |=  0x0E;//0b.0000.1110
+    P10SEL1 &= ~0x0E;
+    P10SEL0 &= ~0x01;//0b.0000.0001
+    P10SEL1 &= ~0x01;
+    P10DIR  |=  0x01;//Output, deselected
+    P10OUT  |=  0x01;
 }
 
 void spiInit(void){//initializes SPI modules and timers for various functions
-    //Configure SPI for FRAM module
-    EUSCI_A1->CTLW0 |= EUSCI_A_CTLW0_SWRST; // Put eUSCI state machine in reset
-    EUSCI_A1->CTLW0 = EUSCI_A_CTLW0_SWRST | // Remain eUSCI state machine in reset
-            EUSCI_A_CTLW0_MST |             // Set as SPI master
-            EUSCI_A_CTLW0_SYNC |            // Set as synchronous mode
-            EUSCI_A_CTLW0_CKPL |            // Set clock polarity high
-            EUSCI_A_CTLW0_MODE_2 |          // command select low
-            EUSCI_A_CTLW0_MSB;              // MSB first
-
-    EUSCI_A1->CTLW0 |= EUSCI_A_CTLW0_SSEL__SMCLK; // SMCLK
-    EUSCI_A1->BRW = 0x01;                   // /2,fBitClock = fBRCLK/(UCBRx+1).
-    EUSCI_A1->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;    // Initialize USCI state machine
-
-    // Enable eUSCI_A1 interrupt in NVIC module
-    //NVIC->ISER[0] = 1 << ((EUSCIA1_IRQn) & 31);
+    //SPI for FRAM module is set up by framPortInit() at boot
 
     //Configure SPI for Lightstrip
     EUSCI_A2->CTLW0 |= EUSCI_A_CTLW0_SWRST; // Put eUSCI state machine in reset
@@ -199,148 +444,239 @@ void spiInit(void){//initializes SPI modules and timers for various functions
             EUSCI_A_CTLW0_MSB;              // MSB first
 
     EUSCI_A2->CTLW0 |= EUSCI_A_CTLW0_SSEL__SMCLK; // SMCLK
-    EUSCI_A2->BRW = 0x02;                   // /3,fBitClock = fBRCLK/(UCBRx+1).
+    EUSCI_A2->BRW = SPI_BRW(LS_SPI_HZ);     // fBitClock = fBRCLK/UCBRx, LS_SPI_HZ
     EUSCI_A2->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;    // Initialize USCI state machine
 
     // Enable eUSCI_A1 interrupt in NVIC module
     NVIC->ISER[0] = 1 << ((EUSCIA2_IRQn) & 31);
 
+    //Configure SPI for the warning light strip, same frame format as the lightstrip
+    EUSCI_B0->CTLW0 |= EUSCI_B_CTLW0_SWRST; // Put eUSCI state machine in reset
+    EUSCI_B0->CTLW0 = EUSCI_B_CTLW0_SWRST | // Remain eUSCI state machine in reset
+            EUSCI_B_CTLW0_MST |             // Set as SPI master
+            EUSCI_B_CTLW0_SYNC |            // Set as synchronous mode
+            EUSCI_B_CTLW0_CKPL |            // Set clock polarity high
+            EUSCI_B_CTLW0_MODE_0 |          // 3 wire, no chip select
+            EUSCI_B_CTLW0_MSB;              // MSB first
+
+    EUSCI_B0->CTLW0 |= EUSCI_B_CTLW0_SSEL__SMCLK; // SMCLK
+    EUSCI_B0->BRW = SPI_BRW(LS_SPI_HZ);     // fBitClock = fBRCLK/UCBRx, LS_SPI_HZ
+    EUSCI_B0->CTLW0 &= ~EUSCI_B_CTLW0_SWRST;    // Initialize USCI state machine
+
+    //TIMER_A1 itself runs from inputsInit(), the paddle debounce needs it first
+    TIMER_A1->CCR[0] = TIMER_A1->R + FLASH_TICKS;//Flash speed is (FLASH_TICKS * 2) / ACLK = 0.25 seconds per flash
     TIMER_A1->CCTL[0] = TIMER_A_CCTLN_CCIE; // TACCR0 interrupt enabled
-    TIMER_A1->CCR[0] = 4000;//Flash speed is roughly (4000 * 2)/120000 ~0.07 seconds per flash
-    TIMER_A1->CTL = TIMER_A_CTL_SSEL__ACLK | // ACLK, continuous mode
-                TIMER_A_CTL_MC__CONTINUOUS;
 
     NVIC->ISER[0] = 1 << ((TA1_0_IRQn) & 31);
 
-    TIMER_A0->CCTL[0] = TIMER_A_CCTLN_CM_1 | // Capture rising edge,
-            TIMER_A_CCTLN_CCIS_0 |          // Use CCI2A=ACLK,
-            TIMER_A_CCTLN_CCIE |            // Enable capture interrupt
-            TIMER_A_CCTLN_CAP |             // Enable capture mode,
-            TIMER_A_CCTLN_SCS;              // Synchronous capture
+    __enable_irq();//Enables all global interrupts on MSP
+}
+
+RAMFUNC bool rpmtoLS(void)//converts timerA count value to the correct display of leds on lightstrip, returns 0 if the lightstrip was busy
+{
+    if(programActive() != PROGRAM_METER){//pit or launch program in place of the bar and the shift flash
+        warningsDraw(alertState());
+        shiftZone_flag = 0;
+        programDraw(tachPredict(tachNow()));
+        overlayCompose();
+        return lsShow();
+    }
+
+    ledsON = meterLeds(tachPredict(tachNow()));//# of leds to turn on at the time the frame latches, from const thresholds on the capture period with no division
 
-    TIMER_A0->CTL |= TIMER_A_CTL_TASSEL_2 | // Use SMCLK as clock source,
-            0x00C0 |                        // 8 times divider (total 64 division)
-            TIMER_A_CTL_MC__CONTINUOUS;   // Start timer in continuous mode
+    warningsDraw(alertState());
+    shiftZone_flag = (ledsON > NUM_LEDS);
+    if(shiftZone_flag && !overlayLit()){//If RPM is in shift zone, flash red to tell driver to shift
+        return lsShowFlash(LSflash_flag);//precomputed all red / all off frame, only sent when the flash state changes
+    }
+    if(!shiftZone_flag){
+        peakLeds = meterLeds(peakHold());
+        if(!overlayLit() && ((peakLeds <= ledsON) || (peakLeds > NUM_LEDS))){//plain bar, no marker above it
+            return lsShowBar(ledsON);//precomputed frame of the bar, no drawing
+        }
+    }
 
-    TIMER_A0->EX0 |= 0x0007;      //8 times divider (total 64 division)
+    for (i = 0; i < NUM_LEDS; i++)//base layer, shift flash under an alert or the metered indicator below the shift zone
+    {
+        if(shiftZone_flag && LSflash_flag)
+        {
+            lsSetLED(i, 255, 0, 0);//same red as the precomputed flash frame
+        }
+        else if(shiftZone_flag)
+        {
+            lsSetPacked(i, LS_LED_OFF);
+        }
+        else
+        {
+            lsSetPacked(i, (i < ledsON) ? meterPalette[i] : LS_LED_OFF);//turn on correct # of leds based on RPM from the packed palette, the rest off
+        }
+    }
+    if(!shiftZone_flag)
+    {
+        if((peakLeds > ledsON) && (peakLeds <= NUM_LEDS))
+        {
+            lsSetPacked(peakLeds - 1, PEAK_MARKER);//peak hold marker above the bar
+        }
+    }
+    overlayCompose();//lit alerts on top, no-op with none lit
+    return lsShow();
+}
 
-    NVIC->ISER[0] = 1 << ((TA0_0_IRQn) & 31);
+uint8_t alertState(void)//OVERLAY_BIT()s of the alerts that are on now
+{
+    return ((batteryAlarm() != BATT_OK) ? OVERLAY_BIT(OVERLAY_BATTERY) : 0) | (shiftFaulted() ? OVERLAY_BIT(OVERLAY_SHIFT) : 0) |
+           (ecuAlert() ? OVERLAY_BIT(OVERLAY_ENGINE) : 0) | (peakOverRev() ? OVERLAY_BIT(OVERLAY_OVERREV) : 0);
+}
 
+void warningsDraw(uint8_t alerts)//warning light segment to the aux strip back buffer, sent with the next lsShow()
+{
+    uint8_t k;
 
+    for(k = 0; k < LS_WARN_LEDS; k++)
+    {
+        if(k < (LS_WARN_LEDS / 2))
+        {
+            lsSegmentSet(LS_SEG_WARNING, k, (alerts & OVERLAY_BIT(OVERLAY_BATTERY)) ? LS_PACK(WARN_BRIGHTNESS, 255, 176, 0) : LS_LED_OFF);
+        }
+        else
+        {
+            lsSegmentSet(LS_SEG_WARNING, k, (alerts & OVERLAY_BIT(OVERLAY_SHIFT)) ? LS_PACK(WARN_BRIGHTNESS, 255, 0, 0) : LS_LED_OFF);
+        }
+    }
+    warningsShown = alerts;
+}
 
-    __enable_irq();//Enables all global interrupts on MSP
+void lsDone(void)//lightstrip DMA complete callback, runs in the DMA interrupt
+{
+    HIL_FRAME_DONE();
+    eventPost(EVENT_LS_DONE);
 }
 
-void sendSPIbyte(uint8_t s)//sends 8 bits (1 byte) to EUSCI_A2 (lightstrip)
+void framDone(void)//FRAM DMA complete callback, runs in the DMA interrupt
 {
-    while ((EUSCI_A2->STATW & 0x0001));
-    EUSCI_A2->TXBUF = (s);   // Load response data onto buffer and send
+    eventPost(EVENT_FRAM_DONE);
 }
 
-void sendLS_START(void)//Start frame for lightstrip as detailed in SK9822 datasheet
+void serialDone(void)//UART DMA complete callback, runs in the DMA interrupt
 {
-    sendSPIbyte(0);
-    sendSPIbyte(0);
-    sendSPIbyte(0);
-    sendSPIbyte(0);
+    eventPost(EVENT_SERIAL_DONE);
 }
 
-void sendLS(uint8_t red, uint8_t green, uint8_t blue)//led frame format for lightstrip as detailed in SK9822 datasheet
+void digitsRefresh(void)//software timer callback, numeric RPM readout
 {
-    sendSPIbyte(224+BRIGHTNESS);
-    sendSPIbyte(blue);
-    sendSPIbyte(green);
-    sendSPIbyte(red);
+    digitsShowRPM(rpm);
+    watchdogCheckIn(WDOG_TASK_DISPLAY);
 }
 
-void clearLS(void)//turns all leds on lightstrip off
+uint32_t digitsPeriod(void)//ms between numeric readout refreshes, slower while the engine is stalled
 {
-    sendLS_START();
+    return 1000 / ((engineState() == ENGINE_STALLED) ? ENGINE_IDLE_DIGITS_HZ : DIGITS_REFRESH_HZ);
+}
 
-    for(i = 0; i <= NUM_LEDS; i++)//Loop to cover all leds
-    {
-        sendSPIbyte(224);
-        sendSPIbyte(0);
-        sendSPIbyte(0);
-        sendSPIbyte(0);
+void engineIdle(bool idle)//power mode and the readout refresh for a stalled (1) or turning (0) engine
+{
+    powerSet(idle ? POWER_IDLE : POWER_RUN);
+    if(swTimerActive(&digitsTimer)){//not before BOOT_DIGITS
+        swTimerStart(&digitsTimer, digitsPeriod(), digitsPeriod(), digitsRefresh);
     }
 }
 
-void rpmtoLS(void)//converts timerA count value to the correct display of leds on lightstrip
+void bootStep(void)//software timer callback, one background init stage per main loop pass
 {
-    if(!rpmCaptureValue){//Error value would not work in calculation
-        rpm = 0;
+    switch(bootStage){
+    case BOOT_SERIAL:
+        serialInit();
+        serialSetCallback(serialDone);
+        break;
+    case BOOT_BLUETOOTH:
+        btInit();
+        swTimerStart(&btTimer, 1000 / BT_STATUS_HZ, 1000 / BT_STATUS_HZ, btStatus);
+        break;
+    case BOOT_BATTERY:
+        batteryInit();
+        break;
+    case BOOT_DIGITS:
+        digitsInit(bootWarm);
+        swTimerStart(&digitsTimer, digitsPeriod(), digitsPeriod(), digitsRefresh);
+        break;
+    case BOOT_ECU:
+        ecuInit();//no controller on the bus leaves the link off
+        break;
+    default://BOOT_LOGS
+        rtcInit();//wall clock for the log keyframes, the LFXT is not waited for
+        shiftLogInit();//scans the FRAM for the newest shift record
+        telemetryInit();//and the newest RPM telemetry block
+        break;
     }
-    else{
-        rpm = (uint16_t)((750000.0 * 60.0) / ((float)rpmCaptureValue * 8.0));//(48MHz / 64 clock divider * 60 seconds per minute) / (timerA count value * 8 pulses per revolution)
-    }                                                                        //8 pulses per revolution is set in the ECU settings on the PE3 (tach pulses per rev in Engine Setup)
+    bootMark(bootStage);
 
-    ledsON = (rpm * NUM_LEDS) / (MAX_RPM - 1500);//Calculates # of leds to turn on based on calculated RPM
-
-    clearLS();//Clear lightstrip
-
-    if(ledsON > NUM_LEDS){//If RPM is in shift zone, flash red to tell driver to shift
-        if(LSflash_flag)//if flash flag on
-        {
-            sendLS_START();//start frame
-            for(i = 0; i < NUM_LEDS; i++)//turn on all leds to red
-            {
-                sendLS(255, 0, 0);
-            }
-        }
-        else//if flash flag off
-        {
-            clearLS();//clear lightstrip
-        }
+    if(bootDone()){
+        watchdogInit();//from here every task has to check in, see watchdog.h
+        eventPost(EVENT_SHIFT_DONE);//anything held back while booting
+        eventPost(EVENT_FRAM_DONE);
+        eventPost(EVENT_SERIAL_RX);
     }
-    else//if RPM is below shift zone, display as a metered indicator
-    {
-        sendLS_START();//start frame
-        for (i = 0; i < ledsON; i++)//turn on correct # of leds based on RPM
-        {
-            sendLS(lightstrip[i][0], lightstrip[i][1], lightstrip[i][2]);//References array for colors of each section
-        }
+    else{
+        bootStage++;
+        swTimerStart(&bootTimer, 1, 0, bootStep);
     }
 }
 
-void TA1_0_IRQHandler(void)//Interrupt every 4000 / 1200000 to flash shift lights
+void btStatus(void)//software timer callback, live status frame to the pit
 {
-    TIMER_A1->CCTL[0] &= ~TIMER_A_CCTLN_CCIFG;//clear interrupt flag
-    LSflash_flag = !LSflash_flag;//toggle flash flag
-    TIMER_A1->CCR[0] += 4000;              // Add Offset to TACCR0
+    watchdogCheckIn(WDOG_TASK_STATUS);
+    btSendStatus(rpm, gearIndex, batteryMillivolts(),
+                 (shiftZone_flag ? BT_STATUS_SHIFT_ZONE : 0) | (shiftFaulted() ? BT_STATUS_SHIFT_FAULT : 0) |
+                 ((batteryAlarm() != BATT_OK) ? BT_STATUS_BATTERY_ALARM : 0) | (gearMismatch ? BT_STATUS_GEAR_MISMATCH : 0) |
+                 (ecuAlert() ? BT_STATUS_ENGINE_ALARM : 0));
 }
 
-void TA0_0_IRQHandler(void)//Interrupt based on input from ECU tach signal
+void gearCheck(void)//software timer callback, corrects gearIndex if the smoothed wheel to engine ratio keeps saying another gear, e.g. after a missed hall effect
 {
-    rpmCaptureValue = TIMER_A0->CCR[0];//timer count value into accessible variable
-    LSflag = 1;//set flag
+    uint8_t gear = (engineState() == ENGINE_RUNNING) ? wheelGear(rpmCaptureValue) : 0;//filtered RPM against the rear wheel revolution
 
-    TIMER_A0->CCTL[0] &= ~(TIMER_A_CCTLN_CCIFG);// Clear the interrupt flag
-    TIMER_A0->R = 0;//reset timer count value
+    if(!gear || (gear == gearIndex) || (shiftState() == SHIFT_ACTUATING) || (shiftState() == SHIFT_REST)){//no estimate, agrees, or a shift is moving the barrel
+        gearMismatch = 0;
+        return;
+    }
+    if(++gearMismatch < GEAR_CHECK_CONFIRM){
+        return;
+    }
+    gearMismatch = 0;
+    gearIndex = gear;
+    shiftSetContext(rpm, gearIndex);
+    meterSetGear(gearIndex);
+    dashState.gear = gearIndex;
+    checkpointSave(&dashState);
 }
 
-void PORT6_IRQHandler(void)
+RAMFUNC void TA1_0_IRQHandler(void)//Interrupt every FLASH_TICKS / ACLK to flash shift lights
 {
-    if(P6IFG & BIT0)//up paddle
-    {
-        P8OUT |=  BIT4;//up relay on
-        P8OUT &= ~BIT5;//down relay off
-    }
-    else if(P6IFG & BIT1)//down paddle
-    {
-        P8OUT |=  BIT5;//down relay on
-        P8OUT &= ~BIT4;//up relay off
-    }
-    else if(P6IFG & BIT4)//up hall effect
-    {
-        P8OUT &= ~0x30;//all relays off
-        up_flag = 1;//Up shift indicated, update 7 segment
+    TIMER_A1->CCTL[0] &= ~TIMER_A_CCTLN_CCIFG;//clear interrupt flag
+    LSflash_flag = !LSflash_flag;//toggle flash flag
+    if(shiftZone_flag){//nothing to redraw outside the shift zone, let the main loop sleep
+        eventPost(EVENT_FLASH);
     }
-    else if(P6IFG & BIT5)//down hall effect
+    TIMER_A1->CCR[0] += FLASH_TICKS;              // Add Offset to TACCR0
+}
+
+RAMFUNC void inputEdge(uint8_t pin, uint32_t timestamp)//qualified paddle / hall effect edge, runs in the PORT6 interrupt
+{
+    switch(pin)
     {
-        P8OUT &= ~0x30;//all relays off
-        down_flag = 1;//down shift indicated, update 7 segment
+    case INPUT_UP_PADDLE:
+        shiftRequest(SHIFT_UP, timestamp);//up relay on
+        break;
+    case INPUT_DOWN_PADDLE:
+        shiftRequest(SHIFT_DOWN, timestamp);//down relay on
+        break;
+    case INPUT_UP_HALL:
+        shiftConfirm(SHIFT_UP, timestamp);//relays off, update 7 segment
+        break;
+    case INPUT_DOWN_HALL:
+        shiftConfirm(SHIFT_DOWN, timestamp);
+        break;
+    default:
+        break;
     }
-
-    P6IFG &= ~0xFF;//clear interrupt flag
 }
@@ -0,0 +1,148 @@
+/*
+ * memprotect.c
+ *
+ * MPU regions and the MemManage fault record, see memprotect.h.
+ * Higher region numbers win where regions overlap, so the SRAM background comes first and the
+ * stack guard last. The linker symbols carry their value as their address, only ever take & of
+ * them.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "memprotect.h"
+#include <stdio.h>
+
+#define MEMPROTECT_MAGIC 0x4D505546u//"MPUF", the record has been set up since the last power up
+#define MEMPROTECT_SUBREGION_BYTES 1024//cache region is 8 KB from an 8 KB boundary, 1 KB subregions
+#define MEMPROTECT_FLASH 0x00000000u//MAIN, msp432p401r.cmd
+#define MEMPROTECT_CODE 0x01000000u//SRAM_CODE
+#define MEMPROTECT_SRAM 0x20000000u//the SRAM on the data bus, its first 16 KB are SRAM_CODE
+#define MEMPROTECT_MMFSR 0x000000FFu//MemManage status byte of the CFSR
+#define MEMPROTECT_MMARVALID 0x00000080u//MMFAR holds the faulting address
+
+typedef enum
+{
+    MEMPROTECT_RGN_SRAM,            //whole SRAM, read and write, never executed
+    MEMPROTECT_RGN_FLASH,
+    MEMPROTECT_RGN_CODE,            //SRAM_CODE on the code bus
+    MEMPROTECT_RGN_CODE_DATA,       //the same SRAM through the data alias
+    MEMPROTECT_RGN_CACHE,
+    MEMPROTECT_RGN_GUARD
+} memProtectRegion_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t pending;               //1 from a fault to the next memProtectInit()
+    uint32_t address;               //MMFAR, 0 if the fault had no data address (an instruction fetch)
+    uint32_t status;                //MMFSR bits of the CFSR
+    uint32_t count;                 //faults since the last power up
+} memProtectRecord_t;
+
+extern uint32_t __stack;//bottom of .stack, from the TI run time
+extern uint8_t memProtectCacheStart, memProtectCacheSize;//.display.cache, msp432p401r.cmd
+
+#pragma NOINIT(memProtectRecord)
+static memProtectRecord_t memProtectRecord;//kept through the watchdog reset
+static memProtectRecord_t memProtectLast;//what memProtectRecord held at start up
+static uint32_t memProtectCacheFlags = 0;//MPU_setRegion() flags of the frame cache, 0 if it could not be covered
+static const uint32_t *memProtectFloor;
+
+static uint32_t memProtectCacheRegion(uint32_t start, uint32_t bytes, uint32_t *base)//flags covering the whole subregions of start to start + bytes, 0 if none
+{
+    uint32_t enabled = 0;
+    uint32_t offset;
+    uint8_t k;
+
+    *base = start & ~((8 * MEMPROTECT_SUBREGION_BYTES) - 1);
+    for(k = 0; k < 8; k++)
+    {
+        offset = *base + ((uint32_t)k * MEMPROTECT_SUBREGION_BYTES);
+        if((offset >= start) && ((offset + MEMPROTECT_SUBREGION_BYTES) <= (start + bytes)))
+        {
+            enabled |= 1u << k;
+        }
+    }
+    if(!enabled)
+    {
+        return 0;
+    }
+    return MPU_RGN_SIZE_8K | MPU_RGN_PERM_NOEXEC | MPU_RGN_PERM_PRV_RO_USR_RO | ((uint32_t)(~enabled & 0xFF) << 8) | MPU_RGN_ENABLE;
+}
+
+void memProtectInit(void)//sets up every region and turns the MPU on, call early in main() after memStatPaint()
+{
+    uint32_t guard = ((uint32_t)(uintptr_t)&__stack + MEMPROTECT_GUARD_BYTES - 1) & ~(uint32_t)(MEMPROTECT_GUARD_BYTES - 1);
+    uint32_t cacheBase;
+
+    if(memProtectRecord.magic != MEMPROTECT_MAGIC)//power up, the SRAM holds noise
+    {
+        memProtectRecord.pending = 0;
+        memProtectRecord.count = 0;
+        memProtectRecord.magic = MEMPROTECT_MAGIC;
+    }
+    memProtectLast = memProtectRecord;
+    memProtectRecord.pending = 0;
+    memProtectFloor = (const uint32_t *)(uintptr_t)(guard + MEMPROTECT_GUARD_BYTES);
+
+    MAP_MPU_disableModule();
+    MAP_MPU_setRegion(MEMPROTECT_RGN_SRAM, MEMPROTECT_SRAM, MPU_RGN_SIZE_64K | MPU_RGN_PERM_NOEXEC | MPU_RGN_PERM_PRV_RW_USR_NO | MPU_RGN_ENABLE);
+    MAP_MPU_setRegion(MEMPROTECT_RGN_FLASH, MEMPROTECT_FLASH, MPU_RGN_SIZE_256K | MPU_RGN_PERM_EXEC | MPU_RGN_PERM_PRV_RO_USR_RO | MPU_RGN_ENABLE);
+    MAP_MPU_setRegion(MEMPROTECT_RGN_CODE, MEMPROTECT_CODE, MPU_RGN_SIZE_16K | MPU_RGN_PERM_EXEC | MPU_RGN_PERM_PRV_RO_USR_RO | MPU_RGN_ENABLE);
+    MAP_MPU_setRegion(MEMPROTECT_RGN_CODE_DATA, MEMPROTECT_SRAM, MPU_RGN_SIZE_16K | MPU_RGN_PERM_NOEXEC | MPU_RGN_PERM_PRV_RO_USR_RO | MPU_RGN_ENABLE);
+    memProtectCacheFlags = memProtectCacheRegion((uint32_t)(uintptr_t)&memProtectCacheStart, (uint32_t)(uintptr_t)&memProtectCacheSize, &cacheBase);
+    MAP_MPU_setRegion(MEMPROTECT_RGN_CACHE, cacheBase, memProtectCacheFlags ? memProtectCacheFlags : MPU_RGN_DISABLE);
+    MAP_MPU_setRegion(MEMPROTECT_RGN_GUARD, guard, MPU_RGN_SIZE_32B | MPU_RGN_PERM_NOEXEC | MPU_RGN_PERM_PRV_NO_USR_NO | MPU_RGN_ENABLE);
+    MAP_MPU_enableModule(MPU_CONFIG_PRIV_DEFAULT);//default map for the peripherals, off in the HardFault handler
+    MAP_MPU_enableInterrupt();//MemManage, not escalated to a HardFault
+}
+
+void memProtectCache(bool writable)//opens (1) or closes (0) the meter bar frames for a rebuild, main loop only
+{
+    if(!memProtectCacheFlags)
+    {
+        return;
+    }
+    if(writable)
+    {
+        MAP_MPU_disableRegion(MEMPROTECT_RGN_CACHE);//the SRAM background region below is read and write
+    }
+    else
+    {
+        MAP_MPU_enableRegion(MEMPROTECT_RGN_CACHE);
+    }
+    __DSB();
+    __ISB();//the next store sees the new permission
+}
+
+const uint32_t *memProtectStackFloor(void)//first stack word above the guard, the guard itself must not be read
+{
+    return memProtectFloor;
+}
+
+int memProtectFormat(char *text, int size)//"MPU <0|1 faulted before this reset> <address> <MMFSR> <faults since power up>\n", returns the length
+{
+    bool faulted = (memProtectLast.pending == 1);
+    int n;
+
+    n = snprintf(text, size, "MPU %u %lu %lu %lu", faulted, (unsigned long)(faulted ? memProtectLast.address : 0),
+                 (unsigned long)(faulted ? memProtectLast.status : 0), (unsigned long)memProtectLast.count);
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+void MemManage_Handler(void)//records the fault and leaves the reset to the watchdog
+{
+    uint32_t status = SCB->CFSR & MEMPROTECT_MMFSR;
+
+    memProtectRecord.address = (status & MEMPROTECT_MMARVALID) ? SCB->MMFAR : 0;
+    memProtectRecord.status = status;
+    memProtectRecord.count++;
+    memProtectRecord.pending = 1;
+    __disable_irq();//nothing else runs on what may be corrupt state
+    while(1);//the main loop stops checking in, WDOG_ITERATIONS later the warm boot
+}
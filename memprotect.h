@@ -0,0 +1,35 @@
+/*
+ * memprotect.h
+ *
+ * Cortex-M4 MPU setup. Every stray write to memory no code should change after start up faults
+ * on the spot instead of corrupting it quietly:
+ *      flash                   read only, code and every const table
+ *      SRAM_CODE               read only through both aliases once RAMFUNC code is copied
+ *      meter bar frames        read only but while lsSetBars() rebuilds them (lightstrip.h),
+ *                              the .display.cache section, whole 1 KB subregions
+ *      stack guard             no access, the lowest MEMPROTECT_GUARD_BYTES of .stack
+ *      the rest of the SRAM    read and write, never executed
+ * Peripherals and everything else keep the default memory map. The stack grows down into the
+ * guard, so an overflow faults on the first word past the reservation rather than running into
+ * .bss, and the stack can be sized from the 'M' high water mark (memstat.h) without a margin
+ * for silent overruns.
+ * A fault records the data address and the MMFSR status bits in memory kept through a reset
+ * and then waits for the watchdog (watchdog.h), the warm boot brings the dashboard back within
+ * WDOG_ITERATIONS; read the record over the download port ('F', download.h).
+ */
+
+#ifndef MEMPROTECT_H_
+#define MEMPROTECT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Memory protection settings
+#define MEMPROTECT_GUARD_BYTES 32   //smallest MPU region, at the bottom of .stack
+
+void memProtectInit(void);
+void memProtectCache(bool writable);
+const uint32_t *memProtectStackFloor(void);
+int memProtectFormat(char *text, int size);
+
+#endif /* MEMPROTECT_H_ */
@@ -0,0 +1,81 @@
+/*
+ * memstat.c
+ *
+ * RAM budget report and stack painting, see memstat.h.
+ * The linker symbols carry their value as their address, only ever take & of them.
+ */
+
+#include "memstat.h"
+#include "memprotect.h"
+#include <stdio.h>
+
+extern uint32_t __stack;//bottom of .stack, from the TI run time
+extern uint32_t __STACK_END;
+extern uint8_t memStatCodeUsed, memStatCaptureUsed, memStatDisplayUsed, memStatCommsUsed, memStatLogUsed, memStatDebugUsed;//SIZE() of each group, msp432p401r.cmd
+extern uint8_t memStatCodeBudget, memStatCaptureBudget, memStatDisplayBudget, memStatCommsBudget, memStatLogBudget, memStatDebugBudget;//range lengths
+
+static const uint8_t * const memStatUsedSym[MEMSTAT_REGIONS] =
+{
+    &memStatCodeUsed, &memStatCaptureUsed, &memStatDisplayUsed, &memStatCommsUsed, &memStatLogUsed, &memStatDebugUsed
+};
+static const uint8_t * const memStatBudgetSym[MEMSTAT_REGIONS] =
+{
+    &memStatCodeBudget, &memStatCaptureBudget, &memStatDisplayBudget, &memStatCommsBudget, &memStatLogBudget, &memStatDebugBudget
+};
+
+void memStatPaint(void)//fills the unused stack below the caller, call first in main() with interrupts off
+{
+    volatile uint32_t here;
+    volatile uint32_t *word = &__stack;
+    volatile uint32_t *end = (volatile uint32_t *)((uintptr_t)&here - MEMSTAT_PAINT_MARGIN);
+
+    while(word < end)
+    {
+        *word++ = MEMSTAT_PAINT;
+    }
+}
+
+uint32_t memStatStackSize(void)
+{
+    return (uint32_t)((uintptr_t)&__STACK_END - (uintptr_t)&__stack);
+}
+
+uint32_t memStatStackPeak(void)//deepest stack use since memStatPaint() in bytes, the whole stack if the bottom word above the MPU guard is gone
+{
+    const volatile uint32_t *word = memProtectStackFloor();//reading the guard faults
+
+    while((word < &__STACK_END) && (*word == MEMSTAT_PAINT))
+    {
+        word++;
+    }
+    return (uint32_t)((uintptr_t)&__STACK_END - (uintptr_t)word);
+}
+
+uint32_t memStatUsed(memStatRegion_t region)//bytes placed in the region by the linker
+{
+    return (uint32_t)(uintptr_t)memStatUsedSym[region];
+}
+
+uint32_t memStatBudget(memStatRegion_t region)
+{
+    return (uint32_t)(uintptr_t)memStatBudgetSym[region];
+}
+
+int memStatFormat(char *text, int size)//"MEM <stack bytes> <stack peak> <used> <budget> ...\n" per memStatRegion_t, returns the length
+{
+    int n;
+    uint8_t k;
+
+    n = snprintf(text, size, "MEM %lu %lu", (unsigned long)memStatStackSize(), (unsigned long)memStatStackPeak());
+    for(k = 0; (k < MEMSTAT_REGIONS) && (n < size); k++)
+    {
+        n += snprintf(&text[n], size - n, " %lu %lu", (unsigned long)memStatUsed((memStatRegion_t)k),
+                      (unsigned long)memStatBudget((memStatRegion_t)k));
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
@@ -0,0 +1,46 @@
+/*
+ * memstat.h
+ *
+ * Static RAM budgets and the stack high water mark. msp432p401r.cmd splits the SRAM into one
+ * range per subsystem (capture, display, comms, log, debug) besides the SRAM code range and the
+ * general data range, and places each module's .bss and .data in its subsystem's range, so a
+ * subsystem that outgrows its budget fails the link with a placement error naming the range
+ * instead of quietly eating into the stack. The budgets and the bytes used are exported to the
+ * firmware as linker symbols.
+ * The stack is painted with MEMSTAT_PAINT from its bottom up to just below the caller by
+ * memStatPaint(), first thing in main() before any interrupt can run. The ISRs share the main
+ * stack, so the deepest word still overwritten since then is the high water mark of the whole
+ * firmware, found by scanning up from the bottom for the first unpainted word. The bottom
+ * MEMPROTECT_GUARD_BYTES are the MPU stack guard (memprotect.h) and are never scanned, a stack
+ * that reaches them faults.
+ * Read both over the download port ('M', download.h).
+ */
+
+#ifndef MEMSTAT_H_
+#define MEMSTAT_H_
+
+#include <stdint.h>
+
+//Memory statistics settings
+#define MEMSTAT_PAINT 0x5AA5C33Cu   //stack fill, unlikely as a saved register or return address
+#define MEMSTAT_PAINT_MARGIN 32     //bytes below the caller's frame left unpainted, memStatPaint()'s own frame
+
+typedef enum
+{
+    MEMSTAT_CODE,                   //RAMFUNC code (ramfunc.h)
+    MEMSTAT_CAPTURE,                //tach, wheel speed, inputs, shifting, battery
+    MEMSTAT_DISPLAY,                //lightstrip, meter, 4-digit display, overlays, display programs
+    MEMSTAT_COMMS,                  //USB UART, bluetooth, frames, log download, ECU link
+    MEMSTAT_LOG,                    //FRAM driver, everything it persists and the log wall clock
+    MEMSTAT_DEBUG,                  //profiling, HIL and the benchmark, empty in Release builds
+    MEMSTAT_REGIONS
+} memStatRegion_t;
+
+void memStatPaint(void);
+uint32_t memStatStackSize(void);
+uint32_t memStatStackPeak(void);
+uint32_t memStatUsed(memStatRegion_t region);
+uint32_t memStatBudget(memStatRegion_t region);
+int memStatFormat(char *text, int size);
+
+#endif /* MEMSTAT_H_ */
@@ -0,0 +1,140 @@
+/*
+ * meter.c
+ *
+ * Lightstrip colours and per gear meter thresholds, see meter.h.
+ */
+
+#include "meter.h"
+#include "ramfunc.h"
+
+typedef struct
+{
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t share;                  //of the global brightness, /32
+} meterColour_t;
+
+static const meterColour_t meterZones [3] = {{0, 255, 0, 20}, {255, 176, 0, 26}, {255, 0, 0, 32}};//green, amber, red, brighter towards the shift point
+static const uint8_t meterGamma [256] = {//round(255 * (value / 255)^2.2), LED output is linear in PWM duty, the eye is not
+          0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+          1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+          3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+          6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+         12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+         20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+         30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+         42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+         56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+         73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+         91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+        113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+        137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+        163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+        192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+        223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255};
+
+uint32_t meterPalette [NUM_LEDS];//LS_PACK() led frame of each led when lit
+static uint32_t meterCountAt [METER_GEARS] [NUM_LEDS + 1];//descending per gear, the last entry is the shift zone
+static const uint32_t *meterActive = meterCountAt[1];//thresholds of the gear on the indicator
+
+void meterInit(void)//default colours and shift points, call before the first meterLeds()
+{
+    meterShiftPoint_t points[METER_GEARS];
+
+    meterSetZones(NUM_GREEN_LEDS, NUM_YELLOW_LEDS, BRIGHTNESS);
+    meterDefaults(MAX_RPM, points);
+    meterLoad(points);
+}
+
+void meterSetZones(uint8_t green, uint8_t yellow, uint8_t brightness)//rebuilds the palette, green leds, then yellow, then red for the rest, brightness 0-31
+{
+    const meterColour_t *zone;
+    uint8_t level;
+    uint8_t led;
+
+    for(led = 0; led < NUM_LEDS; led++)
+    {
+        zone = &meterZones[(led < green) ? 0 : ((led < (green + yellow)) ? 1 : 2)];
+        level = ((brightness * zone->share) + 31) >> 5;//rounded up so a dim strip never goes dark
+        meterPalette[led] = LS_PACK(level, meterGamma[zone->red], meterGamma[zone->green], meterGamma[zone->blue]);
+    }
+}
+
+void meterDefaults(uint16_t maxRpm, meterShiftPoint_t *points)//same meter from 0 RPM in every gear, shift zone METER_MAX_MARGIN below maxRpm
+{
+    uint8_t gear;
+
+    for(gear = 0; gear < METER_GEARS; gear++)
+    {
+        points[gear].startRpm = 0;
+        points[gear].shiftRpm = METER_SHIFT_RPM(maxRpm);
+    }
+}
+
+bool meterValid(const meterShiftPoint_t *points)//every gear needs room for one RPM step per LED
+{
+    uint8_t gear;
+
+    for(gear = 0; gear < METER_GEARS; gear++)
+    {
+        if((points[gear].shiftRpm < TACH_MIN_RPM) || (points[gear].startRpm >= points[gear].shiftRpm) ||
+           ((uint16_t)(points[gear].shiftRpm - points[gear].startRpm) <= NUM_LEDS))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+bool meterLoad(const meterShiftPoint_t *points)//rebuilds every gear's thresholds from a METER_GEARS table, returns 0 and keeps the old ones if it is invalid
+{
+    uint8_t gear;
+    uint8_t index;
+    uint32_t span;
+    uint32_t rpm;
+
+    if(!meterValid(points))
+    {
+        return 0;
+    }
+    for(gear = 0; gear < METER_GEARS; gear++)
+    {
+        span = points[gear].shiftRpm - points[gear].startRpm;
+        for(index = 0; index <= NUM_LEDS; index++)
+        {
+            rpm = points[gear].startRpm + ((((uint32_t)index + 1) * span) + NUM_LEDS) / (NUM_LEDS + 1);//lowest RPM that lights index + 1 leds
+            meterCountAt[gear][index] = TACH_RPM_NUMERATOR / rpm;//longest capture period that does
+        }
+    }
+    return 1;
+}
+
+void meterSetGear(uint8_t gear)//selects the thresholds meterLeds() uses, call on every gear change
+{
+    meterActive = meterCountAt[(gear < METER_GEARS) ? gear : 0];
+}
+
+RAMFUNC uint8_t meterLeds(uint32_t count)//# of leds to turn on for a filtered capture period, METER_SHIFT_ZONE past the meter, 0 for no reading
+{
+    uint8_t low = 0;
+    uint8_t high = NUM_LEDS + 1;
+
+    if(!count)
+    {
+        return 0;
+    }
+    while(low < high)//binary search the capture period thresholds
+    {
+        uint8_t mid = (low + high) >> 1;
+        if(meterActive[mid] >= count)//fast enough to light mid + 1 leds
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
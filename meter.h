@@ -0,0 +1,50 @@
+/*
+ * meter.h
+ *
+ * RPM to lightstrip meter mapping, no hardware access so it also builds into the host
+ * simulation (sim/). The LED palette is rebuilt from the colour zones and brightness of the
+ * parameter store (params.h) when they change: each zone colour is gamma corrected and packed
+ * into a finished SK9822 led frame with its own 5 bit brightness (zone share of the global
+ * brightness), so drawing the meter is one word copy per led. The meter ramp and shift point are set per gear
+ * (meterShiftPoint_t, stored in the FRAM by shiftpoints.h) and turned into the longest capture
+ * period that lights each LED count whenever the table is loaded, so the LED count comes from a
+ * binary search on the filtered capture period with no RPM conversion and no division, the same
+ * work in every gear.
+ *
+ * LED k of NUM_LEDS lights at startRpm + k * (shiftRpm - startRpm) / (NUM_LEDS + 1), the shift
+ * zone starts at shiftRpm.
+ */
+
+#ifndef METER_H_
+#define METER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lightstrip.h"
+#include "tach.h"
+
+//Meter settings
+#define MAX_RPM 12000                       //default for the parameter store (params.h)
+#define METER_MAX_MARGIN 1500               //default meter tops out this far below the max RPM, past it is the shift zone
+#define METER_SHIFT_ZONE (NUM_LEDS + 1)     //meterLeds() result past the last LED
+#define METER_GEARS 7                       //indexed by gearIndex, 0 is neutral
+#define METER_SHIFT_RPM(max) ((((NUM_LEDS + 1) * ((uint32_t)(max) - METER_MAX_MARGIN)) + NUM_LEDS - 1) / NUM_LEDS)//one LED step past the meter span
+
+typedef struct
+{
+    uint16_t startRpm;              //meter zero
+    uint16_t shiftRpm;              //shift zone, the whole strip flashes from here
+} meterShiftPoint_t;
+
+extern uint32_t meterPalette [NUM_LEDS];
+
+
+void meterInit(void);
+void meterSetZones(uint8_t green, uint8_t yellow, uint8_t brightness);
+void meterDefaults(uint16_t maxRpm, meterShiftPoint_t *points);
+bool meterValid(const meterShiftPoint_t *points);
+bool meterLoad(const meterShiftPoint_t *points);
+void meterSetGear(uint8_t gear);
+uint8_t meterLeds(uint32_t count);
+
+#endif /* METER_H_ */
@@ -42,21 +42,17 @@ MEMORY
 {
     MAIN       (RX) : origin = 0x00000000, length = 0x00040000
     INFO       (RX) : origin = 0x00200000, length = 0x00004000
-#ifdef  __TI_COMPILER_VERSION__
-#if     __TI_COMPILER_VERSION__ >= 15009000
-    ALIAS
-    {
-    SRAM_CODE  (RWX): origin = 0x01000000
-    SRAM_DATA  (RW) : origin = 0x20000000
-    } length = 0x00010000
-#else
-    /* Hint: If the user wants to use ram functions, please observe that SRAM_CODE             */
-    /* and SRAM_DATA memory areas are overlapping. You need to take measures to separate       */
-    /* data from code in RAM. This is only valid for Compiler version earlier than 15.09.0.STS.*/ 
-    SRAM_CODE  (RWX): origin = 0x01000000, length = 0x00010000
-    SRAM_DATA  (RW) : origin = 0x20000000, length = 0x00010000
-#endif
-#endif
+
+    /* SRAM budgets (memstat.h). SRAM_CODE is the code bus alias of 0x20000000, so the ranges    */
+    /* below are disjoint in the one 64 KB SRAM and a group that outgrows its range fails the   */
+    /* link with a placement error instead of overlapping its neighbour or the stack.            */
+    SRAM_CODE    (RWX): origin = 0x01000000, length = 0x00004000
+    SRAM_CAPTURE (RW) : origin = 0x20004000, length = 0x00000400
+    SRAM_DISPLAY (RW) : origin = 0x20004400, length = 0x00001C00
+    SRAM_COMMS   (RW) : origin = 0x20006000, length = 0x00000800
+    SRAM_LOG     (RW) : origin = 0x20006800, length = 0x00001000
+    SRAM_DEBUG   (RW) : origin = 0x20007800, length = 0x00000400
+    SRAM_DATA    (RW) : origin = 0x20007C00, length = 0x00008400
 }
 
 /* The following command line options are set as part of the CCS project.    */
@@ -77,8 +73,8 @@ MEMORY
 SECTIONS
 {
     .intvecs:   > 0x00000000
-    .text   :   > MAIN
-    .const  :   > MAIN
+    .text   :   > MAIN, SIZE(benchTextSize)     /* code and const sizes for the benchmark report (benchmark.h) */
+    .const  :   > MAIN, SIZE(benchConstSize)
     .cinit  :   > MAIN
     .pinit  :   > MAIN
     .init_array   :     > MAIN
@@ -94,19 +90,147 @@ SECTIONS
     /* BSL area for device bootstrap loader                                  */
     .bslArea      : > 0x00202000
 
-    .vtable :   > 0x20000000
+    /* One group per SRAM budget, modules not listed go to .bss and .data in SRAM_DATA */
+    GROUP
+    {
+        .capture.bss :
+        {
+            tach.obj(.bss)
+            tach_filter.obj(.bss)
+            tach_predict.obj(.bss)
+            wheel.obj(.bss)
+            inputs.obj(.bss)
+            shift.obj(.bss)
+            battery.obj(.bss)
+            engine.obj(.bss)
+            gear.obj(.bss)
+        }
+        .capture.data :
+        {
+            tach.obj(.data)
+            tach_filter.obj(.data)
+            tach_predict.obj(.data)
+            wheel.obj(.data)
+            inputs.obj(.data)
+            shift.obj(.data)
+            battery.obj(.data)
+            engine.obj(.data)
+            gear.obj(.data)
+        }
+    } > SRAM_CAPTURE, SIZE(memStatCaptureUsed)
+
+    GROUP
+    {
+        /* First in SRAM_DISPLAY and padded to whole 1 KB MPU subregions, read only (memprotect.h) */
+        .display.cache : { lightstrip.obj(.display.cache) } palign(1024), RUN_START(memProtectCacheStart), RUN_SIZE(memProtectCacheSize)
+        .display.bss :
+        {
+            lightstrip.obj(.bss)
+            meter.obj(.bss)
+            digits.obj(.bss)
+            overlay.obj(.bss)
+            program.obj(.bss)
+        }
+        .display.data :
+        {
+            lightstrip.obj(.data)
+            meter.obj(.data)
+            digits.obj(.data)
+            overlay.obj(.data)
+            program.obj(.data)
+        }
+    } > SRAM_DISPLAY, SIZE(memStatDisplayUsed)
+
+    GROUP
+    {
+        .comms.bss :
+        {
+            serial.obj(.bss)
+            bluetooth.obj(.bss)
+            frame.obj(.bss)
+            download.obj(.bss)
+            ecu.obj(.bss)
+        }
+        .comms.data :
+        {
+            serial.obj(.data)
+            bluetooth.obj(.data)
+            frame.obj(.data)
+            download.obj(.data)
+            ecu.obj(.data)
+        }
+    } > SRAM_COMMS, SIZE(memStatCommsUsed)
+
+    GROUP
+    {
+        .log.bss :
+        {
+            fram.obj(.bss)
+            telemetry.obj(.bss)
+            shiftlog.obj(.bss)
+            stats.obj(.bss)
+            logcrypt.obj(.bss)
+            checkpoint.obj(.bss)
+            params.obj(.bss)
+            peak.obj(.bss)
+            shiftpoints.obj(.bss)
+            logscan.obj(.bss)
+            crc.obj(.bss)
+            boot.obj(.bss)
+            rtc.obj(.bss)
+        }
+        .log.data :
+        {
+            fram.obj(.data)
+            telemetry.obj(.data)
+            shiftlog.obj(.data)
+            stats.obj(.data)
+            logcrypt.obj(.data)
+            checkpoint.obj(.data)
+            params.obj(.data)
+            peak.obj(.data)
+            shiftpoints.obj(.data)
+            logscan.obj(.data)
+            crc.obj(.data)
+            boot.obj(.data)
+            rtc.obj(.data)
+        }
+    } > SRAM_LOG, SIZE(memStatLogUsed)
+
+    GROUP
+    {
+        .debug.bss :
+        {
+            profile.obj(.bss)
+            hil.obj(.bss)
+            benchmark.obj(.bss)
+        }
+        .debug.data :
+        {
+            profile.obj(.data)
+            hil.obj(.data)
+            benchmark.obj(.data)
+        }
+    } > SRAM_DEBUG, SIZE(memStatDebugUsed)
+
+    .vtable :   > SRAM_DATA     /* RAM vector table (priority.c), aligned by its DATA_ALIGN */
+    .TI.noinit : > SRAM_DATA    /* MPU fault record (memprotect.c), kept through the watchdog reset */
     .data   :   > SRAM_DATA
     .bss    :   > SRAM_DATA
     .sysmem :   > SRAM_DATA
     .stack  :   > SRAM_DATA (HIGH)
 
-#ifdef  __TI_COMPILER_VERSION__
-#if     __TI_COMPILER_VERSION__ >= 15009000
-    .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT)
-#endif
-#endif
+    .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT), RUN_SIZE(memStatCodeUsed)
 }
 
+/* Budgets for the memory report, the range lengths above */
+memStatCodeBudget    = 0x00004000;
+memStatCaptureBudget = 0x00000400;
+memStatDisplayBudget = 0x00001C00;
+memStatCommsBudget   = 0x00000800;
+memStatLogBudget     = 0x00001000;
+memStatDebugBudget   = 0x00000400;
+
 /* Symbolic definition of the WDTCTL register for RTS */
 WDTCTL_SYM = 0x4000480C;
 
@@ -0,0 +1,91 @@
+/*
+ * overlay.c
+ *
+ * Alert overlay compositing on the meter segment, see overlay.h.
+ */
+
+#include "overlay.h"
+#include "lightstrip.h"
+#include "timebase.h"
+#include "ramfunc.h"
+
+typedef struct
+{
+    uint8_t first;                  //meter led the overlay starts at
+    uint8_t leds;
+    uint8_t pattern;                //bit n lit on blink step n
+    uint32_t colour;                //LS_PACK() led frame
+} overlayDef_t;
+
+static const overlayDef_t overlayDefs[OVERLAY_COUNT] =
+{
+    {0, 3, 0xCC, LS_PACK(OVERLAY_BRIGHTNESS, 255, 176, 0)},                   //amber, slow blink at the bottom of the bar
+    {0, NUM_LEDS / 5, 0xF0, LS_PACK(OVERLAY_BRIGHTNESS, 255, 0, 0)},          //red, 1 Hz over the bottom fifth
+    {NUM_LEDS - (NUM_LEDS / 5), NUM_LEDS / 5, 0xCC, LS_PACK(OVERLAY_BRIGHTNESS, 255, 0, 255)},//magenta, slow blink over the top fifth
+    {0, NUM_LEDS, 0xAA, LS_PACK(OVERLAY_BRIGHTNESS, 0, 0, 255)}               //blue, 4 Hz over the whole bar
+};
+
+static swTimer_t overlayTimer;
+static uint8_t overlayActive = 0;//OVERLAY_BIT()s of the alerts that are on
+static uint8_t overlayPhase = 0;//blink pattern step
+static uint8_t overlayShown = 0;//overlays lit in the last composed frame
+
+static void overlayStep(void)//software timer callback
+{
+    overlayPhase = (overlayPhase + 1) & 7;
+}
+
+RAMFUNC uint8_t overlayLit(void)//OVERLAY_BIT()s of the alerts that are lit on this blink step
+{
+    uint8_t lit = 0;
+    uint8_t overlay;
+
+    if(!overlayActive)
+    {
+        return 0;
+    }
+    for(overlay = 0; overlay < OVERLAY_COUNT; overlay++)
+    {
+        if((overlayActive & OVERLAY_BIT(overlay)) && (overlayDefs[overlay].pattern & (1 << overlayPhase)))
+        {
+            lit |= OVERLAY_BIT(overlay);
+        }
+    }
+    return lit;
+}
+
+bool overlayUpdate(uint8_t active)//sets the active alerts, call every main loop pass, returns 1 if the bar has to be redrawn
+{
+    if(active && !overlayActive)
+    {
+        overlayPhase = 0;
+        swTimerStart(&overlayTimer, OVERLAY_STEP_MS, OVERLAY_STEP_MS, overlayStep);
+    }
+    else if(!active && overlayActive)
+    {
+        swTimerStop(&overlayTimer);
+    }
+    overlayActive = active;
+    return overlayLit() != overlayShown;
+}
+
+RAMFUNC void overlayCompose(void)//writes the lit overlays over the base layer in the meter back buffer
+{
+    const overlayDef_t *def;
+    uint8_t lit = overlayLit();
+    uint8_t overlay;
+    uint8_t k;
+
+    overlayShown = lit;
+    for(overlay = 0; lit; overlay++, lit >>= 1)
+    {
+        if(lit & 1)
+        {
+            def = &overlayDefs[overlay];
+            for(k = 0; k < def->leds; k++)
+            {
+                lsSetPacked(def->first + k, def->colour);
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * overlay.h
+ *
+ * Alert overlays composited on top of the RPM bar. Each alert has a fixed led range of the meter
+ * segment, a packed colour and an 8 step blink pattern; the base layer (meter or shift flash) is
+ * drawn first, then every lit overlay is written over its range in priority order, later
+ * overlays in overlay_t win. Only the leds of lit overlays are touched and lsShow() only sends
+ * the leds that changed, so with no alert active the render path costs one test.
+ * The blink timer only runs while an alert is active.
+ */
+
+#ifndef OVERLAY_H_
+#define OVERLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Overlay settings
+#define OVERLAY_STEP_MS 125         //blink pattern step, patterns repeat every second
+#define OVERLAY_BRIGHTNESS 31       //alerts stay at full brightness
+
+typedef enum                        //lowest priority first
+{
+    OVERLAY_BATTERY,                //battery out of range (battery.h)
+    OVERLAY_SHIFT,                  //last shift gave up (shift.h)
+    OVERLAY_ENGINE,                 //coolant hot or oil pressure low (ecu.h)
+    OVERLAY_OVERREV,                //RPM above the max RPM parameter (peak.h)
+    OVERLAY_COUNT
+} overlay_t;
+
+#define OVERLAY_BIT(overlay) (1 << (overlay))
+
+bool overlayUpdate(uint8_t active);
+uint8_t overlayLit(void);
+void overlayCompose(void);
+
+#endif /* OVERLAY_H_ */
@@ -0,0 +1,98 @@
+/*
+ * params.c
+ *
+ * Versioned, CRC protected parameter store in the FRAM, see params.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "params.h"
+#include "fram.h"
+#include "lightstrip.h"
+#include "meter.h"
+#include "peak.h"
+#include <stddef.h>
+#include <string.h>
+
+#define PARAMS_CRC_SEED 0xFFFF
+
+static const paramValues_t paramsDefaults = {BRIGHTNESS, NUM_GREEN_LEDS, NUM_YELLOW_LEDS, NUM_RED_LEDS, MAX_RPM, 0};
+static params_t params;//values in use
+static bool paramsDirty = 0;//params not written to the FRAM yet
+
+static uint16_t paramsCrc(const params_t *record)//CRC-16 CCITT of the record up to the crc field
+{
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint8_t k;
+
+    MAP_CRC32_setSeed(PARAMS_CRC_SEED, CRC16_MODE);
+    for(k = 0; k < offsetof(params_t, crc); k++)
+    {
+        MAP_CRC32_set8BitData(bytes[k], CRC16_MODE);
+    }
+    return (uint16_t)MAP_CRC32_getResult(CRC16_MODE);
+}
+
+static bool paramsValid(const paramValues_t *values)
+{
+    return (values->brightness <= 31) &&
+           ((values->greenLeds + values->yellowLeds + values->redLeds) == NUM_LEDS) &&
+           (values->maxRpm > (METER_MAX_MARGIN + NUM_LEDS + 1)) && (values->maxRpm <= PARAMS_MAX_RPM);
+}
+
+static void paramsApply(const paramValues_t *values)//rebuilds every table derived from the parameters
+{
+    memcpy(&params.values, values, sizeof(paramValues_t));
+    lsSetBrightness(values->brightness);
+    meterSetZones(values->greenLeds, values->yellowLeds, values->brightness);
+    lsSetBars(meterPalette);
+    shiftPointsDefaults(values->maxRpm);
+    peakSetLimit(values->maxRpm);
+}
+
+void paramsRestore(void)//blocking read, applies the stored parameters or the defaults, call after meterInit()
+{
+    params_t record;
+
+    framRead(PARAMS_BASE, (uint8_t *)&record, sizeof(params_t));
+    if((record.version == PARAMS_VERSION) && (record.length == sizeof(paramValues_t)) &&
+       (paramsCrc(&record) == record.crc) && paramsValid(&record.values))
+    {
+        paramsApply(&record.values);
+    }
+    else
+    {
+        paramsApply(&paramsDefaults);
+    }
+}
+
+bool paramsSet(const paramValues_t *values)//new parameter set, applied now and saved, returns 0 if it is invalid
+{
+    if(!paramsValid(values))
+    {
+        return 0;
+    }
+    paramsApply(values);
+    paramsDirty = 1;
+    paramsService();
+    return 1;
+}
+
+const paramValues_t *paramsGet(void)
+{
+    return &params.values;
+}
+
+void paramsService(void)//queues the pending save, call on EVENT_FRAM_DONE in case the FRAM queue was full
+{
+    if(!paramsDirty)
+    {
+        return;
+    }
+    params.version = PARAMS_VERSION;
+    params.length = sizeof(paramValues_t);
+    params.crc = paramsCrc(&params);
+    if(framWrite(PARAMS_BASE, (const uint8_t *)&params, sizeof(params_t)))
+    {
+        paramsDirty = 0;//framWrite() copied the record
+    }
+}
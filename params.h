@@ -0,0 +1,51 @@
+/*
+ * params.h
+ *
+ * Dashboard tuning parameters kept in the FRAM so they can be changed in the paddock without a
+ * rebuild. The record carries a layout version and a CRC-16 (CCITT, from the CRC32 module); a
+ * blank record, another version or a bad CRC leaves the compiled in defaults (lightstrip.h,
+ * meter.h). Applying a parameter set rebuilds whatever is derived from it once, the SK9822
+ * frame headers and flash frames, the meter colour table and the default shift points, so the
+ * per edge path is still only table lookups.
+ * Values are read and replaced over the log download port ('C' and 'K', download.h), a new set
+ * is checked, applied and written back from paramsService() on EVENT_FRAM_DONE.
+ * The number of leds is the strip itself and stays a build setting, only the colour split moves.
+ */
+
+#ifndef PARAMS_H_
+#define PARAMS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "shiftpoints.h"
+
+//Parameter settings
+#define PARAMS_BASE (SHIFTPOINT_BASE + sizeof(shiftPoints_t))
+#define PARAMS_VERSION 1            //bump when paramValues_t changes, older records are ignored
+#define PARAMS_MAX_RPM 20000        //highest max RPM accepted
+#define PARAMS_VALUE_BYTES sizeof(paramValues_t)//payload of the 'K' command
+
+typedef struct
+{
+    uint8_t brightness;             //SK9822 global brightness, 0-31
+    uint8_t greenLeds;              //colour zones, green + yellow + red is NUM_LEDS
+    uint8_t yellowLeds;
+    uint8_t redLeds;
+    uint16_t maxRpm;                //default shift points, METER_MAX_MARGIN above the top of the meter
+    uint16_t spare;
+} paramValues_t;
+
+typedef struct
+{
+    uint8_t version;                //PARAMS_VERSION
+    uint8_t length;                 //sizeof(paramValues_t)
+    paramValues_t values;
+    uint16_t crc;                   //CRC-16 of everything before it
+} params_t;
+
+void paramsRestore(void);
+bool paramsSet(const paramValues_t *values);
+const paramValues_t *paramsGet(void);
+void paramsService(void);
+
+#endif /* PARAMS_H_ */
@@ -0,0 +1,113 @@
+/*
+ * peak.c
+ *
+ * Peak RPM and over-rev tracking, see peak.h.
+ */
+
+#include "peak.h"
+#include "fram.h"
+#include "crc.h"
+#include "timebase.h"
+#include "ramfunc.h"
+#include <stddef.h>
+
+static peakRecord_t peakRecord;//RPMs are converted from the counts below by peakGet()
+static swTimer_t peakTimer;
+static bool peakDirty = 0;//peakRecord behind the counts or not written to the FRAM yet
+static uint32_t peakRecordCount = 0xFFFFFFFF;//shortest periods seen, TACH_COUNT_HZ ticks
+static uint32_t peakSessionCount = 0xFFFFFFFF;
+static uint32_t peakHoldCount = 0;//peak hold marker period, 0 for none
+static uint32_t peakHoldTime = 0;//tach timestamp of peakHoldCount
+static uint32_t peakOverRevCount = 0xFFFFFFFF;//period at the max RPM, from peakSetLimit()
+static uint32_t peakOverRevExitCount = 0xFFFFFFFF;//period PEAK_OVERREV_HYST_RPM below it
+static bool peakOverRevFlag = 0;
+
+void peakRestore(void)//blocking read, the stored session becomes the last session, call at start up
+{
+    framRead(PEAK_BASE, (uint8_t *)&peakRecord, sizeof(peakRecord_t));
+    if(crcBlock(&peakRecord, offsetof(peakRecord_t, crc)) != peakRecord.crc)
+    {
+        peakRecord = (peakRecord_t){0};//blank or torn, start counting again
+    }
+    peakDirty = peakRecord.sessionRpm || peakRecord.lastSessionRpm;//the roll over is written at the first EVENT_FRAM_DONE, so a session that never saves still becomes the last one
+    peakRecord.lastSessionRpm = peakRecord.sessionRpm;
+    peakRecord.sessionRpm = 0;
+    if(peakRecord.recordRpm)
+    {
+        peakRecordCount = TACH_RPM_TO_COUNT(peakRecord.recordRpm);
+    }
+}
+
+void peakSetLimit(uint16_t maxRpm)//over-rev thresholds from the max RPM parameter, called by paramsApply()
+{
+    peakOverRevCount = TACH_RPM_TO_COUNT(maxRpm);
+    peakOverRevExitCount = (maxRpm > PEAK_OVERREV_HYST_RPM) ? TACH_RPM_TO_COUNT(maxRpm - PEAK_OVERREV_HYST_RPM) : 0xFFFFFFFF;
+}
+
+RAMFUNC void peakAdd(uint32_t timestamp, uint32_t period)//filtered tach period (tachFilter()), call for every edge
+{
+    if(!period)
+    {
+        return;
+    }
+    if(period <= peakHoldCount || (uint32_t)(timestamp - peakHoldTime) > PEAK_HOLD_TICKS)//new high or the hold ran out
+    {
+        peakHoldCount = period;
+        peakHoldTime = timestamp;
+    }
+    if(period < peakSessionCount)
+    {
+        peakSessionCount = period;
+        if(period < peakRecordCount)
+        {
+            peakRecordCount = period;
+        }
+        peakDirty = 1;
+    }
+    if(!peakOverRevFlag && period < peakOverRevCount)
+    {
+        peakOverRevFlag = 1;
+        peakRecord.overRevs++;
+        peakDirty = 1;
+    }
+    else if(peakOverRevFlag && period > peakOverRevExitCount)
+    {
+        peakOverRevFlag = 0;
+    }
+    if(peakDirty && !swTimerActive(&peakTimer))
+    {
+        swTimerStart(&peakTimer, PEAK_SAVE_MS, 0, peakService);
+    }
+}
+
+bool peakOverRev(void)//1 while the engine is above the max RPM
+{
+    return peakOverRevFlag;
+}
+
+uint32_t peakHold(void)//peak hold marker period for meterLeds(), 0 before the first edge
+{
+    return peakHoldCount;
+}
+
+const peakRecord_t *peakGet(void)//peaks and over-rev count up to the last edge
+{
+    peakRecord.sessionRpm = tachCountToRPM(peakSessionCount);
+    peakRecord.recordRpm = tachCountToRPM(peakRecordCount);
+    return &peakRecord;
+}
+
+void peakService(void)//queues the pending save, call on EVENT_FRAM_DONE in case the FRAM queue was full, also run from peakTimer
+{
+    if(!peakDirty || swTimerActive(&peakTimer))
+    {
+        return;
+    }
+    peakGet();
+    peakRecord.spare = 0;
+    peakRecord.crc = crcBlock(&peakRecord, offsetof(peakRecord_t, crc));
+    if(framWrite(PEAK_BASE, (const uint8_t *)&peakRecord, sizeof(peakRecord_t)))
+    {
+        peakDirty = 0;//framWrite() copied the record
+    }
+}
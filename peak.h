@@ -0,0 +1,53 @@
+/*
+ * peak.h
+ *
+ * Peak RPM and over-rev tracking. Every filtered tach period goes through peakAdd(), which only
+ * compares against capture counts precomputed from the max RPM parameter (params.h), no
+ * RPM conversion per edge: a shorter period than the peak is a new peak, crossing the over-rev
+ * count starts an over-rev, which ends PEAK_OVERREV_HYST_RPM lower so a bouncing limiter counts
+ * once.
+ * Three peaks are kept: the session (since power up), the previous session and the record since
+ * the FRAM was blank, together with the over-rev count, in a record after the parameters. The
+ * stored session becomes the previous one at power up and that roll over is written straight
+ * back, so a session too short for a save still counts as the previous one next time. A
+ * change marks the record dirty and it is written at most every PEAK_SAVE_MS from
+ * peakService(), so a pull to the limiter is one FRAM write, not one per edge.
+ * The strip shows a peak hold marker, the highest meter led of the last PEAK_HOLD_MS.
+ * Values are read over the log download port ('R', download.h).
+ */
+
+#ifndef PEAK_H_
+#define PEAK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "params.h"
+#include "tach.h"
+
+//Peak settings
+#define PEAK_BASE (PARAMS_BASE + sizeof(params_t))
+#define PEAK_HOLD_MS 2000           //peak hold marker stays this long after the last new high
+#define PEAK_OVERREV_HYST_RPM 200   //over-rev ends this far below the max RPM
+#define PEAK_SAVE_MS 1000           //dirty record written at most this often
+
+#define PEAK_HOLD_TICKS ((uint32_t)TACH_COUNT_HZ / 1000 * PEAK_HOLD_MS)
+
+typedef struct
+{
+    uint16_t recordRpm;             //highest since the FRAM was blank
+    uint16_t sessionRpm;            //highest since power up
+    uint16_t lastSessionRpm;        //sessionRpm found at power up
+    uint16_t spare;
+    uint32_t overRevs;              //times above the max RPM since the FRAM was blank
+    uint32_t crc;                   //CRC32 of everything before it
+} peakRecord_t;
+
+void peakRestore(void);
+void peakSetLimit(uint16_t maxRpm);
+void peakAdd(uint32_t timestamp, uint32_t period);
+bool peakOverRev(void);
+uint32_t peakHold(void);
+const peakRecord_t *peakGet(void);
+void peakService(void);
+
+#endif /* PEAK_H_ */
@@ -0,0 +1,124 @@
+/*
+ * power.c
+ *
+ * PCM active mode and clock switching, see power.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "power.h"
+#include "clock.h"
+#include "timebase.h"
+#include "tach.h"
+#include "serial.h"
+#include "bluetooth.h"
+#include "fram.h"
+#include "lightstrip.h"
+#include "digits.h"
+#include "ecu.h"
+
+static powerMode_t powerNow = POWER_RUN;//clockInit() leaves everything at full speed
+static powerMode_t powerWanted = POWER_RUN;
+static bool powerDcdcFlag = 0;
+static swTimer_t powerTimer;
+
+static void powerStep(void);
+
+static void powerCore(powerMode_t mode)//DC-DC at the VCORE for mode, the LDO if the DC-DC does not take it
+{
+    uint_fast8_t dcdc = (mode == POWER_IDLE) ? PCM_AM_DCDC_VCORE0 : PCM_AM_DCDC_VCORE1;
+    uint_fast8_t ldo = (mode == POWER_IDLE) ? PCM_AM_LDO_VCORE0 : PCM_AM_LDO_VCORE1;
+
+    powerDcdcFlag = powerDcdcFlag && MAP_PCM_setPowerState(dcdc);
+    if(!powerDcdcFlag)
+    {
+        MAP_PCM_setPowerState(ldo);
+    }
+}
+
+static bool powerQuiet(void)//nothing queued on any SMCLK port
+{
+    return !serialBusy() && serialIdle() && !btBusy() && !framBusy() && lsQuiet() && !digitsBusy() && !ecuBusy();
+}
+
+static bool powerClocks(powerMode_t mode)//switches the clocks and retimes the SMCLK modules, returns 0 if a peripheral was busy
+{
+    uint32_t smclk;
+
+    __disable_irq();//PRIMASK, BASEPRI cannot mask PRIORITY_TACH and TIMER_A0 is retimed too
+    if(!powerQuiet())//a callback between the check and here could have started something
+    {
+        __enable_irq();
+        return 0;
+    }
+    while(EUSCI_A0->STATW & EUSCI_A_STATW_BUSY);//last bytes out of the shift registers
+    while(EUSCI_A1->STATW & EUSCI_A_STATW_BUSY);
+    while(EUSCI_A2->STATW & EUSCI_A_STATW_BUSY);
+    while(EUSCI_A3->STATW & EUSCI_A_STATW_BUSY);
+    while(EUSCI_B0->STATW & EUSCI_B_STATW_SPI_BUSY);
+    while(EUSCI_B3->STATW & EUSCI_B_STATW_SPI_BUSY);
+    clockSetIdle(mode == POWER_IDLE);
+    smclk = clockSmclk();
+    tachSetClock(smclk);
+    serialSetClock(smclk);
+    btSetClock(smclk);
+    framSetClock(smclk);
+    lsSetClock(smclk);
+    digitsSetClock(smclk);
+    ecuSetClock(smclk);
+    __enable_irq();
+    return 1;
+}
+
+static void powerStep(void)//one attempt at powerWanted, retried from powerTimer
+{
+    if(powerWanted == powerNow)
+    {
+        return;
+    }
+    if(powerWanted == POWER_RUN)
+    {
+        powerCore(POWER_RUN);//VCORE1 before full speed, staying there with slow clocks is fine
+        if(!powerClocks(POWER_RUN))
+        {
+            swTimerStart(&powerTimer, POWER_RETRY_MS, 0, powerStep);
+            return;
+        }
+    }
+    else
+    {
+        if(!powerClocks(POWER_IDLE))
+        {
+            swTimerStart(&powerTimer, POWER_RETRY_MS, 0, powerStep);
+            return;
+        }
+        powerCore(POWER_IDLE);
+    }
+    powerNow = powerWanted;
+}
+
+void powerInit(void)//moves VCORE1 from the LDO onto the DC-DC, call after clockInit()
+{
+    powerDcdcFlag = MAP_PCM_setPowerState(PCM_AM_DCDC_VCORE1);
+    if(!powerDcdcFlag)
+    {
+        MAP_PCM_setPowerState(PCM_AM_LDO_VCORE1);
+    }
+}
+
+void powerSet(powerMode_t mode)//POWER_IDLE with the engine stalled, POWER_RUN once it turns, from the main loop
+{
+    powerWanted = mode;
+    swTimerStop(&powerTimer);
+    powerStep();
+}
+
+powerMode_t powerMode(void)//mode the clocks are in, lags powerSet() while a peripheral is busy
+{
+    return powerNow;
+}
+
+bool powerOnDcdc(void)//0 if the DC-DC did not start and the LDO supplies the core
+{
+    return powerDcdcFlag;
+}
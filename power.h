@@ -0,0 +1,41 @@
+/*
+ * power.h
+ *
+ * Core voltage and clock speed from the engine state. While the engine turns the PCM runs
+ * VCORE1 from the DC-DC (PCM_AM_DCDC_VCORE1) with every clock at full speed, with it stalled
+ * power drops to VCORE0 with MCLK, HSMCLK and SMCLK at CLOCK_IDLE_MCLK_HZ (clock.h). A board
+ * whose DC-DC does not start stays on the LDO at the same VCORE, powerOnDcdc() tells which.
+ * VCORE0 only allows 24 MHz MCLK and 12 MHz SMCLK, so VCORE1 goes up before the clocks speed
+ * up and comes down after they have slowed. Every eUSCI and TIMER_A0 are clocked from SMCLK,
+ * their dividers are rewritten together with the clock switch (xSetClock()) so the bit rates
+ * and TACH_COUNT_HZ stay the same in both modes. A byte already on its way would come out at
+ * the wrong rate, so a switch only happens with the USB UART, bluetooth, FRAM, both lightstrips,
+ * the 4-digit display and the ECU link all idle, otherwise it is retried every POWER_RETRY_MS. The switch
+ * runs with every interrupt off, for the time of the rewrites plus at most the last bytes
+ * leaving the shift registers.
+ * Left at the SMCLK they were started on: the ADC14 conversion clock (battery.h, conversions
+ * take twice as long while idle) and the HIL stimulus timer (HIL_TIMER_HZ, only right while
+ * the engine turns, which it does during a sweep).
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Power settings
+#define POWER_RETRY_MS 1            //next attempt at a switch held off by a busy peripheral
+
+typedef enum
+{
+    POWER_RUN,                      //VCORE1, 48 MHz
+    POWER_IDLE                      //VCORE0, 12 MHz
+} powerMode_t;
+
+void powerInit(void);
+void powerSet(powerMode_t mode);
+powerMode_t powerMode(void);
+bool powerOnDcdc(void);
+
+#endif /* POWER_H_ */
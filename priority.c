@@ -0,0 +1,44 @@
+/*
+ * priority.c
+ *
+ * NVIC priority setup, see priority.h.
+ */
+
+#include "priority.h"
+
+extern void TA0_0_IRQHandler(void);
+
+void priorityInit(void)//call before any interrupt is enabled
+{
+    MAP_Interrupt_setPriority(INT_TA0_0, PRIORITY_TACH);
+    MAP_Interrupt_setPriority(INT_TA0_N, PRIORITY_TACH);
+
+    MAP_Interrupt_setPriority(INT_PORT6, PRIORITY_SHIFT);
+    MAP_Interrupt_setPriority(INT_TA1_N, PRIORITY_SHIFT);
+    MAP_Interrupt_setPriority(INT_TA2_0, PRIORITY_SHIFT);
+    MAP_Interrupt_setPriority(INT_TA2_N, PRIORITY_SHIFT);
+
+    MAP_Interrupt_setPriority(FAULT_SYSTICK, PRIORITY_TIMEBASE);
+
+    MAP_Interrupt_setPriority(INT_ADC14, PRIORITY_ALERT);
+    MAP_Interrupt_setPriority(INT_EUSCIA0, PRIORITY_ALERT);
+    MAP_Interrupt_setPriority(INT_TA3_0, PRIORITY_ALERT);
+    MAP_Interrupt_setPriority(INT_RTC_C, PRIORITY_ALERT);
+
+    MAP_Interrupt_setPriority(INT_TA1_0, PRIORITY_FLASH);
+
+    MAP_Interrupt_setPriority(INT_DMA_INT1, PRIORITY_DISPLAY);
+    MAP_Interrupt_setPriority(INT_EUSCIB0, PRIORITY_DISPLAY);
+    MAP_Interrupt_setPriority(INT_EUSCIB2, PRIORITY_DISPLAY);
+    MAP_Interrupt_setPriority(INT_EUSCIA2, PRIORITY_DISPLAY);
+
+    MAP_Interrupt_setPriority(INT_DMA_INT0, PRIORITY_LOGGING);
+    MAP_Interrupt_setPriority(INT_DMA_INT2, PRIORITY_LOGGING);
+    MAP_Interrupt_setPriority(INT_DMA_INT3, PRIORITY_LOGGING);
+    MAP_Interrupt_setPriority(INT_EUSCIA3, PRIORITY_LOGGING);
+    MAP_Interrupt_setPriority(INT_PORT5, PRIORITY_LOGGING);
+
+#if PRIORITY_RAM_VECTORS
+    MAP_Interrupt_registerInterrupt(INT_TA0_0, TA0_0_IRQHandler);//first register copies the flash table to g_pfnRAMVectors and moves VTOR there, the handler is unchanged
+#endif
+}
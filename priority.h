@@ -0,0 +1,68 @@
+/*
+ * priority.h
+ *
+ * Interrupt priorities for every ISR on the dashboard, set in one place by priorityInit().
+ * The MSP432 NVIC has 3 priority bits (upper bits of the byte), lower value preempts higher.
+ *
+ *      PRIORITY_TACH     0x00  TA0_0, TA0_N               capture timestamps, nothing may delay them
+ *      PRIORITY_SHIFT    0x20  PORT6, TA1_N, TA2_0, TA2_N paddles, debounce, relay and cut deadlines
+ *      PRIORITY_TIMEBASE 0x40  SysTick
+ *      PRIORITY_ALERT    0x60  ADC14, EUSCIA0, TA3_0, RTC_C  battery alarm, USB RX start of burst, HIL edge stamp, wall clock tick
+ *      PRIORITY_FLASH    0x80  TA1_0                      shift light cadence
+ *      PRIORITY_DISPLAY  0xC0  DMA_INT1, EUSCIB0, EUSCIB2 lightstrip, warning strip and 4-digit display
+ *      PRIORITY_LOGGING  0xE0  DMA_INT0, DMA_INT2, DMA_INT3, EUSCIA3, PORT5  FRAM, USB TX, USB RX halves, ECU frames, bluetooth
+ *
+ * ISRs that share state without a ring buffer share a level so they never preempt each other
+ * (TA0_0 / TA0_N overflow count, PORT6 / TA1_N lockouts, PORT6 / TA2 shift state, PORT5 / DMA_INT0
+ * ECU receive state).
+ *
+ * Critical sections mask by level with BASEPRI instead of disabling every interrupt, so the main
+ * loop can hold off the shift ISRs while tach capture keeps running:
+ *      uint8_t mask = criticalEnter(PRIORITY_SHIFT);
+ *      ...
+ *      criticalExit(mask);
+ * BASEPRI 0 masks nothing, so PRIORITY_TACH cannot be a critical section level and
+ * criticalEnter(PRIORITY_TACH) does not compile; hold off the tach ISRs with PRIMASK,
+ * __disable_irq() / __enable_irq(), and keep that section short.
+ *
+ * With PRIORITY_RAM_VECTORS the vector table is copied to SRAM (.vtable) so the vector fetch on
+ * interrupt entry has no flash wait state, the ISRs themselves are RAMFUNC (ramfunc.h).
+ */
+
+#ifndef PRIORITY_H_
+#define PRIORITY_H_
+
+#include <stdint.h>
+#include "hal.h"
+
+#define PRIORITY_TACH 0x00
+#define PRIORITY_SHIFT 0x20
+#define PRIORITY_TIMEBASE 0x40
+#define PRIORITY_ALERT 0x60
+#define PRIORITY_FLASH 0x80
+#define PRIORITY_DISPLAY 0xC0
+#define PRIORITY_LOGGING 0xE0
+
+#define PRIORITY_RAM_VECTORS 1//1 fetches vectors from the SRAM copy of the table, 0 leaves VTOR on flash
+
+void priorityInit(void);
+
+static inline uint8_t criticalMask(uint8_t level)//masks level and everything below it, returns the mask to restore, through criticalEnter()
+{
+    uint8_t mask = MAP_Interrupt_getPriorityMask();
+
+    if((mask == 0) || (level < mask))//only ever raise the mask, never unmask from inside a critical section
+    {
+        MAP_Interrupt_setPriorityMask(level);
+    }
+    return mask;
+}
+
+#define criticalEnter(level) ((void)sizeof(char[((level) != PRIORITY_TACH) ? 1 : -1]), criticalMask(level))//a level 0 mask would mask nothing, does not compile
+
+static inline void criticalExit(uint8_t mask)
+{
+    MAP_Interrupt_setPriorityMask(mask);
+}
+
+#endif /* PRIORITY_H_ */
@@ -0,0 +1,96 @@
+/*
+ * profile.c
+ *
+ * DWT cycle counter statistics, see profile.h.
+ */
+
+#include "profile.h"
+#include "ramfunc.h"
+
+#ifdef PROFILE_ENABLE
+
+#include <stdio.h>
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[PROFILE_BUCKETS];
+} profStats_t;
+
+static const char *const profNames[PROF_COUNT] = {"tach_isr", "input_isr", "render"};
+static profStats_t profStats[PROF_COUNT];//each region is only recorded from one context
+
+void profileInit(void)//starts the DWT cycle counter
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;//already running from bootInit(), not cleared so the boot stamps stay valid
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    profileReset();
+}
+
+RAMFUNC void profileRecord(profRegion_t region, uint32_t cycles)
+{
+    profStats_t *stats = &profStats[region];
+    uint8_t bucket = 0;
+    uint32_t above = cycles >> 5;
+
+    while(above && (bucket < (PROFILE_BUCKETS - 1)))
+    {
+        bucket++;
+        above >>= 1;
+    }
+    stats->histogram[bucket]++;
+    stats->count++;
+    stats->total += cycles;
+    if(cycles < stats->min)
+    {
+        stats->min = cycles;
+    }
+    if(cycles > stats->max)
+    {
+        stats->max = cycles;
+    }
+}
+
+void profileReset(void)
+{
+    uint8_t k;
+    uint8_t b;
+
+    for(k = 0; k < PROF_COUNT; k++)
+    {
+        profStats[k].count = 0;
+        profStats[k].min = 0xFFFFFFFF;
+        profStats[k].max = 0;
+        profStats[k].total = 0;
+        for(b = 0; b < PROFILE_BUCKETS; b++)
+        {
+            profStats[k].histogram[b] = 0;
+        }
+    }
+}
+
+int profileFormat(profRegion_t region, char *text, int size)//"PROF <name> <count> <min> <max> <mean> <bucket 0> ... <bucket n>\n", returns the length
+{
+    const profStats_t *stats = &profStats[region];
+    uint32_t mean = stats->count ? (uint32_t)(stats->total / stats->count) : 0;
+    int n;
+    uint8_t b;
+
+    n = snprintf(text, size, "PROF %s %lu %lu %lu %lu", profNames[region], (unsigned long)stats->count,
+                 (unsigned long)(stats->count ? stats->min : 0), (unsigned long)stats->max, (unsigned long)mean);
+    for(b = 0; (b < PROFILE_BUCKETS) && (n < size); b++)
+    {
+        n += snprintf(&text[n], size - n, " %lu", (unsigned long)stats->histogram[b]);
+    }
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+#endif
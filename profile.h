@@ -0,0 +1,47 @@
+/*
+ * profile.h
+ *
+ * Cycle counting for the hot paths with the Cortex-M4 DWT cycle counter (MCLK cycles, 20.8 ns).
+ * Wrap a region in PROFILE_BEGIN / PROFILE_END and every pass is added to that region's count,
+ * min, max and total, and to a log2 histogram so worst cases under engine noise show up.
+ * Dump the results with the 'P' command of the log download (download.h).
+ * Only compiled in when PROFILE_ENABLE is defined (Debug configuration), otherwise the macros
+ * are empty and nothing is measured.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include "msp.h"
+
+//Profile settings
+#define PROFILE_BUCKETS 12          //bucket 0 < 32 cycles, bucket k < 2^(k + 5) cycles, last bucket everything above
+
+typedef enum
+{
+    PROF_TACH_ISR,                  //tach capture, TA0_0_IRQHandler (TA0_N with TACH_COMP_ENABLE)
+    PROF_INPUT_ISR,                 //PORT6_IRQHandler
+    PROF_RENDER,                    //rpmtoLS(), lightstrip frame build and send
+    PROF_COUNT
+} profRegion_t;
+
+#ifdef PROFILE_ENABLE
+
+#define PROFILE_BEGIN(region) uint32_t profileStart_##region = DWT->CYCCNT
+#define PROFILE_END(region) profileRecord((region), DWT->CYCCNT - profileStart_##region)
+
+void profileInit(void);
+void profileRecord(profRegion_t region, uint32_t cycles);
+void profileReset(void);
+int profileFormat(profRegion_t region, char *text, int size);
+
+#else
+
+#define PROFILE_BEGIN(region)
+#define PROFILE_END(region)
+#define profileInit()
+
+#endif
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,158 @@
+/*
+ * program.c
+ *
+ * Pit and launch display programs, see program.h.
+ */
+
+#include "program.h"
+#include "lightstrip.h"
+#include "params.h"
+#include "tach.h"
+#include "timebase.h"
+#include "ramfunc.h"
+
+#if NUM_LEDS > 32
+#error "program frames keep one mask bit per meter led"
+#endif
+
+#define PROGRAM_PIT_TRAVEL (NUM_LEDS - PROGRAM_PIT_WIDTH)
+#define PROGRAM_PIT_FRAMES (2 * PROGRAM_PIT_TRAVEL)
+#define PROGRAM_LAUNCH_STEPS (NUM_LEDS / 2)     //leds lit from each end before the window
+#define PROGRAM_LAUNCH_WINDOW (PROGRAM_LAUNCH_STEPS + 1)
+#define PROGRAM_LAUNCH_OVER (PROGRAM_LAUNCH_STEPS + 2)
+#define PROGRAM_LAUNCH_FRAMES (PROGRAM_LAUNCH_STEPS + 3)
+
+#define PROGRAM_BITS(n) ((n) ? (0xFFFFFFFFUL >> (32 - (n))) : 0UL)//the n lowest leds
+#define PROGRAM_AMBER LS_PACK(PROGRAM_BRIGHTNESS, 255, 176, 0)
+#define PROGRAM_GREEN LS_PACK(PROGRAM_BRIGHTNESS, 0, 255, 0)
+#define PROGRAM_RED LS_PACK(PROGRAM_BRIGHTNESS, 255, 0, 0)
+
+//block at led f on the way up, coming back down from the top after PROGRAM_PIT_TRAVEL frames
+#define PIT(f) {PROGRAM_BITS(PROGRAM_PIT_WIDTH) << (((f) <= PROGRAM_PIT_TRAVEL) ? (f) : (PROGRAM_PIT_FRAMES - (f))), PROGRAM_AMBER}
+//k leds from each end
+#define LAUNCH(k) {PROGRAM_BITS(k) | (PROGRAM_BITS(k) << (NUM_LEDS - (k))), PROGRAM_AMBER}
+
+#if PROGRAM_PIT_FRAMES != 52
+#error "programPit is written out for NUM_LEDS 30 and PROGRAM_PIT_WIDTH 4"
+#endif
+#if PROGRAM_LAUNCH_STEPS != 15
+#error "programLaunch is written out for NUM_LEDS 30"
+#endif
+
+typedef struct
+{
+    uint32_t mask;                  //bit k lights meter led k
+    uint32_t colour;                //LS_PACK() led frame
+} programFrame_t;
+
+static const programFrame_t programPit[PROGRAM_PIT_FRAMES] =
+{
+    PIT(0), PIT(1), PIT(2), PIT(3), PIT(4), PIT(5), PIT(6), PIT(7),
+    PIT(8), PIT(9), PIT(10), PIT(11), PIT(12), PIT(13), PIT(14), PIT(15),
+    PIT(16), PIT(17), PIT(18), PIT(19), PIT(20), PIT(21), PIT(22), PIT(23),
+    PIT(24), PIT(25), PIT(26), PIT(27), PIT(28), PIT(29), PIT(30), PIT(31),
+    PIT(32), PIT(33), PIT(34), PIT(35), PIT(36), PIT(37), PIT(38), PIT(39),
+    PIT(40), PIT(41), PIT(42), PIT(43), PIT(44), PIT(45), PIT(46), PIT(47),
+    PIT(48), PIT(49), PIT(50), PIT(51)
+};
+
+static const programFrame_t programLaunch[PROGRAM_LAUNCH_FRAMES] =
+{
+    LAUNCH(0), LAUNCH(1), LAUNCH(2), LAUNCH(3), LAUNCH(4), LAUNCH(5), LAUNCH(6), LAUNCH(7),
+    LAUNCH(8), LAUNCH(9), LAUNCH(10), LAUNCH(11), LAUNCH(12), LAUNCH(13), LAUNCH(14), LAUNCH(15),
+    {PROGRAM_BITS(NUM_LEDS), PROGRAM_GREEN},                                  //PROGRAM_LAUNCH_WINDOW
+    {PROGRAM_BITS(NUM_LEDS), PROGRAM_RED}                                     //PROGRAM_LAUNCH_OVER
+};
+
+static program_t programNow = PROGRAM_METER;
+static uint16_t programTarget = PROGRAM_LAUNCH_RPM;
+static uint32_t programLaunchCount[PROGRAM_LAUNCH_OVER];//longest capture period past each launch frame boundary, descending
+static uint8_t programStep = 0;//pit frame
+static uint8_t programShown = 0;//pit frame last drawn
+static bool programChanged = 0;//program switched, the bar has to be redrawn
+static swTimer_t programTimer;
+
+static void programTick(void)//software timer callback
+{
+    programStep = (programStep + 1) % PROGRAM_PIT_FRAMES;
+}
+
+static void programLoad(uint16_t target)//launch frame boundaries for target
+{
+    uint16_t start = target - PROGRAM_LAUNCH_RANGE_RPM;
+    uint16_t step = (PROGRAM_LAUNCH_RANGE_RPM - PROGRAM_LAUNCH_WINDOW_RPM) / PROGRAM_LAUNCH_STEPS;
+    uint8_t k;
+
+    for(k = 0; k < PROGRAM_LAUNCH_STEPS; k++)
+    {
+        programLaunchCount[k] = TACH_RPM_TO_COUNT(start + (k * step));
+    }
+    programLaunchCount[PROGRAM_LAUNCH_STEPS] = TACH_RPM_TO_COUNT(target - PROGRAM_LAUNCH_WINDOW_RPM);
+    programLaunchCount[PROGRAM_LAUNCH_WINDOW] = TACH_RPM_TO_COUNT(target + PROGRAM_LAUNCH_WINDOW_RPM);
+    programTarget = target;
+}
+
+bool programSet(program_t program, uint16_t launchRpm)//switches program, launchRpm is only used by PROGRAM_LAUNCH, returns 0 if either is out of range
+{
+    if((program >= PROGRAM_COUNT) ||
+       ((program == PROGRAM_LAUNCH) && ((launchRpm <= PROGRAM_LAUNCH_RANGE_RPM) || (launchRpm > (PARAMS_MAX_RPM - PROGRAM_LAUNCH_WINDOW_RPM)))))
+    {
+        return 0;
+    }
+    if(program == PROGRAM_LAUNCH)
+    {
+        programLoad(launchRpm);
+    }
+    if(program == PROGRAM_PIT)
+    {
+        programStep = 0;
+        swTimerStart(&programTimer, PROGRAM_STEP_MS, PROGRAM_STEP_MS, programTick);
+    }
+    else
+    {
+        swTimerStop(&programTimer);
+    }
+    programNow = program;
+    programChanged = 1;
+    return 1;
+}
+
+RAMFUNC program_t programActive(void)
+{
+    return programNow;
+}
+
+uint16_t programLaunchRpm(void)//launch target, also while another program runs
+{
+    return programTarget;
+}
+
+bool programUpdate(void)//call every main loop pass, returns 1 if the bar has to be redrawn without a tach edge
+{
+    bool redraw = programChanged || ((programNow == PROGRAM_PIT) && (programStep != programShown));
+
+    programChanged = 0;
+    return redraw;
+}
+
+RAMFUNC void programDraw(uint32_t count)//draws the running program into the meter back buffer, count is the capture period for PROGRAM_LAUNCH
+{
+    const programFrame_t *frame;
+    uint8_t band;
+    uint8_t k;
+
+    if(programNow == PROGRAM_PIT)
+    {
+        frame = &programPit[programStep];
+        programShown = programStep;
+    }
+    else
+    {
+        for(band = 0; count && (band < PROGRAM_LAUNCH_OVER) && (count < programLaunchCount[band]); band++);//no estimate is below the bars
+        frame = &programLaunch[band];
+    }
+    for(k = 0; k < NUM_LEDS; k++)
+    {
+        lsSetPacked(k, (frame->mask & (1UL << k)) ? frame->colour : LS_LED_OFF);
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * program.h
+ *
+ * Display programs that take the RPM bar over from the meter for the pit lane and for launch
+ * control. Each program is a const table of meter segment frames in flash, one led mask and one
+ * packed colour per frame, so drawing one is the same word copy per led as the meter and
+ * switching programs only changes which table the renderer reads:
+ *      PROGRAM_PIT      a PROGRAM_PIT_WIDTH block sweeping up and down the bar, stepped every
+ *                       PROGRAM_STEP_MS by a software timer, the lightstrip is redrawn per step
+ *      PROGRAM_LAUNCH   two amber bars closing in from the ends as the RPM climbs towards the
+ *                       launch target, all green inside +-PROGRAM_LAUNCH_WINDOW_RPM of it, all red
+ *                       above; the frame comes from capture period thresholds worked out when
+ *                       the target is set, no RPM conversion per frame
+ * The alert overlays (overlay.h) and the warning strip stay on top of either, the shift flash is
+ * off. Selected over the log download port ('V', download.h), not kept over a power cycle.
+ */
+
+#ifndef PROGRAM_H_
+#define PROGRAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Program settings
+#define PROGRAM_STEP_MS 40          //pit sweep frame time, ~2 s per sweep up and down
+#define PROGRAM_PIT_WIDTH 4         //leds in the sweeping block
+#define PROGRAM_BRIGHTNESS 31
+#define PROGRAM_LAUNCH_RPM 6500     //launch target until one is set
+#define PROGRAM_LAUNCH_WINDOW_RPM 250//either side of the target shown green
+#define PROGRAM_LAUNCH_RANGE_RPM 3000//the bars start closing in this far below the target
+#define PROGRAM_SET_BYTES 3         //'V' payload, uint8 program_t and uint16 launch RPM, little endian
+
+typedef enum
+{
+    PROGRAM_METER,                  //RPM bar and shift flash
+    PROGRAM_PIT,
+    PROGRAM_LAUNCH,
+    PROGRAM_COUNT
+} program_t;
+
+bool programSet(program_t program, uint16_t launchRpm);
+program_t programActive(void);
+uint16_t programLaunchRpm(void);
+bool programUpdate(void);
+void programDraw(uint32_t count);
+
+#endif /* PROGRAM_H_ */
@@ -0,0 +1,22 @@
+/*
+ * ramfunc.h
+ *
+ * Runs a function from SRAM instead of flash. At 48 MHz flash needs a wait state on every fetch
+ * the buffer misses, SRAM has none, so the ISRs and the render path are kept there.
+ * RAMFUNC puts the function in .TI.ramfunc, which msp432p401r.cmd loads into MAIN and the boot
+ * code copies to SRAM_CODE through the BINIT table before main(). Calls between flash and SRAM
+ * code go through linker trampolines, so everything on a hot path should be RAMFUNC, not just
+ * the ISR at its top.
+ * Costs one copy of the code in SRAM, keep it to the time critical paths.
+ */
+
+#ifndef RAMFUNC_H_
+#define RAMFUNC_H_
+
+#ifdef SIM_HOST
+#define RAMFUNC                     //host simulation, ordinary code
+#else
+#define RAMFUNC __attribute__((section(".TI.ramfunc")))
+#endif
+
+#endif /* RAMFUNC_H_ */
@@ -0,0 +1,176 @@
+/*
+ * rtc.c
+ *
+ * RTC_C wall clock and the tach timestamp to wall time conversion, see rtc.h.
+ * The seconds count and its tach stamp are written by the RTC_C ISR, the main loop reads the pair
+ * with PRIORITY_ALERT masked.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "rtc.h"
+#include "tach.h"
+#include "priority.h"
+#include <stdio.h>
+
+#define RTC_SECONDS_PER_DAY 86400UL
+#define RTC_UNIX_EPOCH_DAYS 719468L //days from 0000-03-01 to 1970-01-01 in the proleptic Gregorian calendar
+
+static volatile uint32_t rtcSecondsCount = 0;//Unix seconds at the last calendar tick
+static volatile uint32_t rtcTickTime = 0;//tachNow() at the last calendar tick
+static volatile bool rtcClockValid = 0;
+static volatile bool rtcResync = 0;//calendar kept through a reset, rtcSecondsCount is read back on the next tick
+
+static int32_t rtcDays(uint16_t year, uint8_t month, uint8_t day)//days since 1970-01-01, eras of 400 years from March 1st so the leap day is last
+{
+    uint32_t yearOfEra;
+    uint32_t dayOfYear;
+    int32_t era;
+
+    year -= (month <= 2);
+    era = year / 400;
+    yearOfEra = year - (era * 400);
+    dayOfYear = ((153 * (month + ((month > 2) ? -3 : 9))) + 2) / 5 + day - 1;
+    return (era * 146097) + (int32_t)((yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100) + dayOfYear) - RTC_UNIX_EPOCH_DAYS;
+}
+
+static uint32_t rtcUnix(const RTC_C_Calendar *calendar)
+{
+    return ((uint32_t)rtcDays(calendar->year, calendar->month, calendar->dayOfmonth) * RTC_SECONDS_PER_DAY) +
+           ((uint32_t)calendar->hours * 3600) + ((uint32_t)calendar->minutes * 60) + calendar->seconds;
+}
+
+static void rtcCalendar(uint32_t unixSeconds, RTC_C_Calendar *calendar)//inverse of rtcUnix()
+{
+    uint32_t days = unixSeconds / RTC_SECONDS_PER_DAY;
+    uint32_t seconds = unixSeconds % RTC_SECONDS_PER_DAY;
+    uint32_t shifted = days + RTC_UNIX_EPOCH_DAYS;
+    uint32_t era = shifted / 146097;
+    uint32_t dayOfEra = shifted - (era * 146097);
+    uint32_t yearOfEra = (dayOfEra - (dayOfEra / 1460) + (dayOfEra / 36524) - (dayOfEra / 146096)) / 365;
+    uint32_t dayOfYear = dayOfEra - ((yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100));
+    uint32_t monthFromMarch = ((dayOfYear * 5) + 2) / 153;
+
+    calendar->seconds = seconds % 60;
+    calendar->minutes = (seconds / 60) % 60;
+    calendar->hours = seconds / 3600;
+    calendar->dayOfWeek = (days + 4) % 7;//1970-01-01 was a Thursday, 0 is Sunday
+    calendar->dayOfmonth = dayOfYear - (((monthFromMarch * 153) + 2) / 5) + 1;
+    calendar->month = (monthFromMarch < 10) ? (monthFromMarch + 3) : (monthFromMarch - 9);
+    calendar->year = (era * 400) + yearOfEra + (calendar->month <= 2);
+}
+
+void rtcInit(void)//starts the LFXT without waiting for it and picks up a calendar kept through a reset
+{
+    RTC_C_Calendar calendar;
+
+    //LFXT crystal pins PJ.0 and PJ.1
+    MAP_GPIO_setAsPeripheralModuleFunctionOutputPin(GPIO_PORT_PJ, GPIO_PIN0 | GPIO_PIN1, GPIO_PRIMARY_MODULE_FUNCTION);
+    MAP_CS_startLFXTWithTimeout(CS_LFXT_DRIVE3, RTC_LFXT_TIMEOUT);//REFO stands in while it faults
+    MAP_CS_initClockSignal(CS_BCLK, CS_LFXTCLK_SELECT, CS_CLOCK_DIVIDER_1);
+
+    if(!(RTC_C->CTL13 & RTC_C_CTL13_HOLD) && !(RTC_C->CTL13 & RTC_C_CTL13_BCD))
+    {
+        calendar = MAP_RTC_C_getCalendarTime();
+        rtcResync = (calendar.year >= RTC_MIN_YEAR);
+    }
+    MAP_RTC_C_clearInterruptFlag(RTC_C_CLOCK_READ_READY_INTERRUPT);
+    MAP_RTC_C_enableInterrupt(RTC_C_CLOCK_READ_READY_INTERRUPT);
+    MAP_Interrupt_enableInterrupt(INT_RTC_C);
+}
+
+bool rtcSet(uint32_t unixSeconds)//sets the calendar to unixSeconds UTC as of now, 0 if it is before RTC_MIN_YEAR
+{
+    RTC_C_Calendar calendar;
+    uint8_t mask;
+
+    if(unixSeconds < ((uint32_t)rtcDays(RTC_MIN_YEAR, 1, 1) * RTC_SECONDS_PER_DAY))
+    {
+        return 0;
+    }
+    rtcCalendar(unixSeconds, &calendar);
+    mask = criticalEnter(PRIORITY_ALERT);
+    MAP_RTC_C_initCalendar(&calendar, RTC_C_FORMAT_BINARY);//holds the clock
+    RTC_C->PS = 0;//prescalers from zero, the next tick is a whole second after the start
+    MAP_RTC_C_startClock();
+    rtcTickTime = tachNow();
+    rtcSecondsCount = unixSeconds;
+    rtcResync = 0;
+    rtcClockValid = 1;
+    criticalExit(mask);
+    return 1;
+}
+
+bool rtcValid(void)//0 until the host has set the time
+{
+    return rtcClockValid;
+}
+
+uint32_t rtcSeconds(void)//Unix seconds UTC, 0 while the clock is unset
+{
+    return rtcClockValid ? rtcSecondsCount : 0;
+}
+
+uint64_t rtcStamp(uint32_t timestamp)//wall time of a tach timestamp within a couple of minutes of now, 32.32 Unix seconds, 0 while the clock is unset
+{
+    uint8_t mask = criticalEnter(PRIORITY_ALERT);
+    uint32_t seconds = rtcSecondsCount;
+    int32_t ticks = (int32_t)(timestamp - rtcTickTime);
+    bool valid = rtcClockValid;
+
+    criticalExit(mask);
+    if(!valid)
+    {
+        return 0;
+    }
+    while(ticks < 0)//captured before the last tick was stamped
+    {
+        ticks += TACH_COUNT_HZ;
+        seconds--;
+    }
+    seconds += (uint32_t)ticks / TACH_COUNT_HZ;
+    ticks = (uint32_t)ticks % TACH_COUNT_HZ;
+    return ((uint64_t)seconds << 32) | (uint32_t)(((uint64_t)ticks << 32) / TACH_COUNT_HZ);
+}
+
+int rtcFormat(char *text, int size)//"CLOCK <0|1 set> <unix s> <0|1 on the crystal>\n", returns the length
+{
+    int n;
+
+    n = snprintf(text, size, "CLOCK %u %lu %u", rtcValid(), (unsigned long)rtcSeconds(), !(MAP_CS_getInterruptStatus() & CS_LFXT_FAULT));
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+void RTC_C_IRQHandler(void)//read ready, once a second right after the calendar ticked
+{
+    uint32_t now = tachNow();
+    uint_fast8_t status = MAP_RTC_C_getEnabledInterruptStatus();
+    RTC_C_Calendar calendar;
+
+    MAP_RTC_C_clearInterruptFlag(status);
+    if(!(status & RTC_C_CLOCK_READ_READY_INTERRUPT))
+    {
+        return;
+    }
+    if(rtcResync)//the registers are stable for the next ~1 s
+    {
+        calendar = MAP_RTC_C_getCalendarTime();
+        rtcSecondsCount = rtcUnix(&calendar);
+        rtcResync = 0;
+        rtcClockValid = 1;
+    }
+    else
+    {
+        rtcSecondsCount++;
+    }
+    rtcTickTime = now;
+    if(MAP_CS_getInterruptStatus() & CS_LFXT_FAULT)//lets the clock system go back to the crystal once it runs
+    {
+        MAP_CS_clearInterruptFlag(CS_LFXT_FAULT);
+    }
+}
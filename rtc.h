@@ -0,0 +1,38 @@
+/*
+ * rtc.h
+ *
+ * Wall clock for the logs, so a session can be lined up with the ECU's own logs. RTC_C counts
+ * the calendar from the 32.768 kHz LFXT crystal on PJ.0/PJ.1 through BCLK, the clock system falls
+ * back to REFO on its own while the crystal is faulted (still starting or missing) and goes back
+ * to it once the fault clears. The host sets the time over the download port ('Y', download.h),
+ * there is no battery backed domain, so the clock is unset after a power up and kept through a
+ * watchdog reset as long as the calendar still reads a year from RTC_MIN_YEAR on.
+ *
+ * The calendar only resolves seconds. The read ready interrupt comes once a second right after
+ * the counters tick and stamps that instant with tachNow(), so a tach timestamp converts to wall
+ * time as the Unix seconds at the last tick plus the tach ticks since, down to the capture
+ * resolution (rtcStamp()). The stamp is a 64-bit 32.32 fixed point (NTP style) count of Unix
+ * seconds, 0 while the clock is unset, and only goes into the telemetry keyframes (telemetry.h);
+ * every sample after a keyframe and every shift record is timed against the keyframe's millis()
+ * and tach timestamp, so the records themselves do not grow.
+ */
+
+#ifndef RTC_H_
+#define RTC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//RTC settings
+#define RTC_MIN_YEAR 2024           //earlier calendars are the reset value, not a time the host set
+#define RTC_LFXT_TIMEOUT 1000       //CS_startLFXTWithTimeout() loop count, the crystal takes ~0.5 s and is not waited for
+#define RTC_SET_BYTES 4             //'Y' payload, uint32 Unix seconds UTC
+
+void rtcInit(void);
+bool rtcSet(uint32_t unixSeconds);
+bool rtcValid(void);
+uint32_t rtcSeconds(void);
+uint64_t rtcStamp(uint32_t timestamp);
+int rtcFormat(char *text, int size);
+
+#endif /* RTC_H_ */
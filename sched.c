@@ -0,0 +1,210 @@
+/*
+ * sched.c
+ *
+ * Fixed priority cooperative scheduler and task statistics, see sched.h.
+ * Everything here runs in the main loop.
+ */
+
+#include "sched.h"
+#include "events.h"
+#include "tach.h"
+#include "timebase.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SCHED_TICKS_PER_US ((uint32_t)TACH_COUNT_HZ / 1000000)
+#define SCHED_TICKS_PER_MS ((uint32_t)TACH_COUNT_HZ / 1000)
+
+typedef struct
+{
+    uint32_t runs;
+    uint32_t overruns;              //runs that finished past the deadline
+    uint32_t maxExec;               //tach ticks
+    uint32_t maxLatency;
+    uint64_t totalExec;
+} schedStats_t;
+
+static const schedTask_t *schedTable = 0;
+static uint8_t schedTasks = 0;
+static uint32_t schedReleased = 0;//bit per task, released and not run yet
+static uint32_t schedReleaseTime[SCHED_MAX_TASKS];//tachNow() base
+static uint32_t schedDue[SCHED_MAX_TASKS];//millis() of the next periodic release
+static schedStats_t schedStats[SCHED_MAX_TASKS];
+static swTimer_t schedTimer;
+
+static void schedTick(void);
+
+static void schedMark(uint8_t task, uint32_t time)//releases task at time unless it already is, the earlier release counts
+{
+    if(!(schedReleased & (1UL << task)))
+    {
+        schedReleased |= 1UL << task;
+        schedReleaseTime[task] = time;
+    }
+}
+
+static void schedArm(void)//timer to the earliest periodic release
+{
+    uint32_t now = millis();
+    int32_t wait = INT32_MAX;
+    uint8_t k;
+
+    for(k = 0; k < schedTasks; k++)
+    {
+        if(schedTable[k].periodMs && ((int32_t)(schedDue[k] - now) < wait))
+        {
+            wait = (int32_t)(schedDue[k] - now);
+        }
+    }
+    if(wait != INT32_MAX)
+    {
+        swTimerStart(&schedTimer, (wait > 0) ? (uint32_t)wait : 0, 0, schedTick);
+    }
+}
+
+static void schedTick(void)//periodic releases, from swTimerService()
+{
+    uint32_t now = millis();
+    uint32_t late;
+    uint8_t k;
+
+    for(k = 0; k < schedTasks; k++)
+    {
+        late = now - schedDue[k];
+        if(!schedTable[k].periodMs || ((int32_t)late < 0))
+        {
+            continue;
+        }
+        schedMark(k, tachNow() - (late * SCHED_TICKS_PER_MS));//released when it was due, not when the timer was serviced
+        schedDue[k] += schedTable[k].periodMs;
+        if((int32_t)(now - schedDue[k]) >= 0)//fell a whole period behind, one release for the lot
+        {
+            schedDue[k] = now + schedTable[k].periodMs;
+        }
+    }
+    eventPost(EVENT_SCHED);
+    schedArm();
+}
+
+void schedInit(const schedTask_t *table, uint8_t count)//table in priority order, at most SCHED_MAX_TASKS, timebase must be running
+{
+    uint32_t now = millis();
+    uint8_t k;
+
+    schedTable = table;
+    schedTasks = (count < SCHED_MAX_TASKS) ? count : SCHED_MAX_TASKS;
+    for(k = 0; k < schedTasks; k++)
+    {
+        schedDue[k] = now + table[k].periodMs;
+    }
+    schedReset();
+    schedArm();
+}
+
+void schedRelease(uint8_t task)//releases task from the main loop, nothing if it already is
+{
+    if(task < schedTasks)
+    {
+        schedMark(task, tachNow());
+        eventPost(EVENT_SCHED);//keeps eventWait() from sleeping on it
+    }
+}
+
+bool schedRun(void)//runs the highest priority released task, returns 0 if there was none
+{
+    uint32_t pending = eventPending();
+    uint32_t start;
+    uint32_t oldest;
+    uint32_t end;
+    uint32_t exec;
+    uint32_t latency;
+    schedStats_t *stats;
+    uint8_t k;
+    uint8_t e;
+
+    eventTake(EVENT_SCHED);
+    for(k = 0; k < schedTasks; k++)//events pending since the last pass release their tasks
+    {
+        if((schedReleased & (1UL << k)) || !(schedTable[k].events & pending))
+        {
+            continue;
+        }
+        start = tachNow();
+        oldest = start;
+        for(e = 0; e < EVENT_COUNT; e++)//from the oldest of its events
+        {
+            if((schedTable[k].events & pending & EVENT_BIT(e)) && ((start - eventStamp((event_t)e)) > (start - oldest)))
+            {
+                oldest = eventStamp((event_t)e);
+            }
+        }
+        schedMark(k, oldest);
+    }
+
+    for(k = 0; k < schedTasks; k++)
+    {
+        if(schedReleased & (1UL << k))
+        {
+            break;
+        }
+    }
+    if(k == schedTasks)
+    {
+        return 0;
+    }
+    schedReleased &= ~(1UL << k);
+    start = tachNow();
+    schedTable[k].run();
+    end = tachNow();
+
+    stats = &schedStats[k];
+    exec = end - start;
+    latency = end - schedReleaseTime[k];
+    stats->runs++;
+    stats->totalExec += exec;
+    if(exec > stats->maxExec)
+    {
+        stats->maxExec = exec;
+    }
+    if(latency > stats->maxLatency)
+    {
+        stats->maxLatency = latency;
+    }
+    if(latency > (schedTable[k].deadlineUs * SCHED_TICKS_PER_US))
+    {
+        stats->overruns++;
+    }
+    if(schedReleased)//whose events were taken by someone else, keeps eventWait() from sleeping on them
+    {
+        eventPost(EVENT_SCHED);
+    }
+    return 1;
+}
+
+uint8_t schedCount(void)
+{
+    return schedTasks;
+}
+
+void schedReset(void)//clears the task statistics
+{
+    memset(schedStats, 0, sizeof(schedStats));
+}
+
+int schedFormat(uint8_t task, char *text, int size)//"TASK <name> <runs> <overruns> <mean exec us> <max exec us> <max latency us> <deadline us>\n", returns the length
+{
+    const schedStats_t *stats = &schedStats[task];
+    uint32_t mean = stats->runs ? (uint32_t)(stats->totalExec / stats->runs) : 0;
+    int n;
+
+    n = snprintf(text, size, "TASK %s %lu %lu %lu %lu %lu %lu", schedTable[task].name, (unsigned long)stats->runs,
+                 (unsigned long)stats->overruns, (unsigned long)(mean / SCHED_TICKS_PER_US),
+                 (unsigned long)(stats->maxExec / SCHED_TICKS_PER_US), (unsigned long)(stats->maxLatency / SCHED_TICKS_PER_US),
+                 (unsigned long)schedTable[task].deadlineUs);
+    if(n > (size - 2))//truncated
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
@@ -0,0 +1,40 @@
+/*
+ * sched.h
+ *
+ * Cooperative run to completion scheduler for the main loop. The tasks are a const table in
+ * priority order, first is highest. A task is released by any pending event in its mask
+ * (events.h), by schedRelease() from the main loop or every periodMs, and each schedRun() runs the
+ * highest priority released task to completion, so a lower task only ever delays a higher one by
+ * the rest of one run. Tasks take their own events, an event nobody takes keeps releasing.
+ * A task's release time is the first post of the events that released it (stamped by eventPost())
+ * or the schedRelease() call, so its latency includes the wait behind other tasks. Every run
+ * records its execution time and its release to finish latency in tach ticks, a latency past
+ * deadlineUs counts an overrun. Read them over the download port ('Q', download.h).
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Scheduler settings
+#define SCHED_MAX_TASKS 12
+
+typedef struct
+{
+    const char *name;               //for the report
+    void (*run)(void);
+    uint32_t events;                //EVENT_BIT()s that release it
+    uint16_t periodMs;              //also released this often, 0 for none
+    uint32_t deadlineUs;            //release to finish
+} schedTask_t;
+
+void schedInit(const schedTask_t *table, uint8_t count);
+void schedRelease(uint8_t task);
+bool schedRun(void);
+uint8_t schedCount(void);
+void schedReset(void);
+int schedFormat(uint8_t task, char *text, int size);
+
+#endif /* SCHED_H_ */
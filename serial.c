@@ -0,0 +1,271 @@
+/*
+ * serial.c
+ *
+ * USB serial driver, see serial.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "serial.h"
+#include "events.h"
+#include "timebase.h"
+#include "clock.h"
+#include <string.h>
+
+#define SERIAL_DMA_CHANNEL 0
+#define SERIAL_DMA_MAX 1024           //longest single uDMA transfer
+#define SERIAL_RX_HALF (SERIAL_RX_RING_SIZE / 2)
+
+//Baud rate generator, oversampling mode, N = SMCLK / SERIAL_BAUD = 24 MHz / 921600 = 26.04
+//BRW = INT(N / 16) = 1, BRF = INT(((N / 16) - BRW) * 16) = 10, BRS = 0x00 for a fraction of 0.04 (users guide table 24-4)
+#define SERIAL_BRW 1
+#define SERIAL_BRF 10
+#define SERIAL_BRS 0x00
+//On the idle SMCLK (clock.h) N = 12 MHz / 921600 = 13.02, too low for oversampling
+//BRW = INT(N) = 13, BRS = 0x00 for a fraction of 0.02
+#define SERIAL_IDLE_BRW 13
+#define SERIAL_IDLE_BRS 0x00
+
+static uint8_t serialRing[SERIAL_RX_RING_SIZE + SERIAL_RX_SLACK];//written by the DMA, the slack only by serialPeek()
+static volatile uint32_t serialRxFilled = 0;//bytes in the halves finished so far, only written by serialRxDone()
+static volatile uint8_t serialRxHalf = 0;//half the DMA is filling, only written by serialRxDone()
+static uint32_t serialTail = 0;//bytes taken so far, main loop only
+static uint32_t serialPollHead = 0;//serialHead() at the last idle poll
+static volatile bool serialIdleFlag = 1;//no byte for a whole SERIAL_IDLE_MS, start bit interrupt armed
+static swTimer_t serialIdleTimer;
+static volatile bool serialBusyFlag = 0;
+static void (*serialCallback)(void) = 0;
+
+static void serialRxArm(uint32_t select, uint8_t *half)
+{
+    MAP_DMA_setChannelTransfer(select | DMA_CH1_EUSCIA0RX, UDMA_MODE_PINGPONG,
+                           (void *)MAP_UART_getReceiveBufferAddressForDMA(EUSCI_A0_BASE), half, SERIAL_RX_HALF);
+}
+
+static uint32_t serialHead(void)//bytes received so far, from the DMA position in the half being filled
+{
+    uint32_t filled;
+    uint32_t left;
+    uint8_t half;
+
+    do{//retry if serialRxDone() ran between the reads
+        filled = serialRxFilled;
+        half = serialRxHalf;
+        left = MAP_DMA_getChannelSize((half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT) | DMA_CH1_EUSCIA0RX);
+    } while(filled != serialRxFilled);
+    return filled + SERIAL_RX_HALF - left;//a finished half not yet re-armed reads 0 left, the next byte is in the other half
+}
+
+static void serialRate(uint32_t smclk)//baud rate generator for SERIAL_BAUD from smclk, eUSCI in reset
+{
+    if(smclk == CLOCK_SMCLK_HZ)
+    {
+        EUSCI_A0->BRW = SERIAL_BRW;
+        EUSCI_A0->MCTLW = (SERIAL_BRS << EUSCI_A_MCTLW_BRS_OFS) |
+                (SERIAL_BRF << EUSCI_A_MCTLW_BRF_OFS) |
+                EUSCI_A_MCTLW_OS16;
+    }
+    else
+    {
+        EUSCI_A0->BRW = SERIAL_IDLE_BRW;
+        EUSCI_A0->MCTLW = SERIAL_IDLE_BRS << EUSCI_A_MCTLW_BRS_OFS;
+    }
+}
+
+void serialInit(void)//sets up EUSCI_A0 and DMA channels 0 and 1, call after clockInit(), pinInit() and dmaTableInit()
+{
+    EUSCI_A0->CTLW0 |= EUSCI_A_CTLW0_SWRST; // Put eUSCI state machine in reset
+    EUSCI_A0->CTLW0 = EUSCI_A_CTLW0_SWRST | // Remain eUSCI state machine in reset
+            EUSCI_A_CTLW0_SSEL__SMCLK;      // SMCLK, UART 8N1 LSB first
+    serialRate(clockSmclk());
+    EUSCI_A0->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;    // Initialize USCI state machine
+    EUSCI_A0->IE |= EUSCI_A_IE_STTIE;       // start bit interrupt while the line is idle, RX and TX are fed by the DMA
+
+    NVIC->ISER[0] = 1 << ((EUSCIA0_IRQn) & 31);
+
+    MAP_DMA_assignChannel(DMA_CH0_EUSCIA0TX);
+    MAP_DMA_disableChannelAttribute(DMA_CH0_EUSCIA0TX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH0_EUSCIA0TX,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_1);//one byte per TXIFG
+
+    MAP_DMA_assignChannel(DMA_CH1_EUSCIA0RX);//ping-pong between the ring halves
+    MAP_DMA_disableChannelAttribute(DMA_CH1_EUSCIA0RX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST | UDMA_ATTR_REQMASK);
+    MAP_DMA_enableChannelAttribute(DMA_CH1_EUSCIA0RX, UDMA_ATTR_HIGH_PRIORITY);//a late RXIFG service is a lost byte
+    MAP_DMA_setChannelControl(UDMA_PRI_SELECT | DMA_CH1_EUSCIA0RX,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1);//one byte per RXIFG
+    MAP_DMA_setChannelControl(UDMA_ALT_SELECT | DMA_CH1_EUSCIA0RX,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_1);
+    serialRxArm(UDMA_PRI_SELECT, &serialRing[0]);
+    serialRxArm(UDMA_ALT_SELECT, &serialRing[SERIAL_RX_HALF]);
+    MAP_DMA_clearInterruptFlag(SERIAL_RX_DMA_CHANNEL);//half done lands on DMA_INT0 (dma_table.c)
+    MAP_Interrupt_enableInterrupt(INT_DMA_INT0);
+    MAP_DMA_enableChannel(SERIAL_RX_DMA_CHANNEL);
+
+    MAP_DMA_assignInterrupt(DMA_INT3, SERIAL_DMA_CHANNEL);
+    MAP_DMA_clearInterruptFlag(SERIAL_DMA_CHANNEL);
+    MAP_Interrupt_enableInterrupt(DMA_INT3);
+}
+
+bool serialSend(const uint8_t *data, uint16_t length)//starts a DMA transmission of data, returns 0 if the last one is still sending
+{
+    if(serialBusyFlag || (length == 0) || (length > SERIAL_DMA_MAX))
+    {
+        return 0;
+    }
+    serialBusyFlag = 1;
+    MAP_DMA_setChannelTransfer(UDMA_PRI_SELECT | DMA_CH0_EUSCIA0TX, UDMA_MODE_BASIC, (void *)data,
+                           (void *)MAP_UART_getTransmitBufferAddressForDMA(EUSCI_A0_BASE), length);
+    MAP_DMA_enableChannel(SERIAL_DMA_CHANNEL);
+
+    EUSCI_A0->IFG &= ~EUSCI_A_IFG_TXIFG;//re-arm TXIFG so the DMA sees a new request for the first byte
+    EUSCI_A0->IFG |=  EUSCI_A_IFG_TXIFG;
+    return 1;
+}
+
+void serialSetClock(uint32_t smclk)//keeps SERIAL_BAUD on a new SMCLK, call with nothing on the line (power.c)
+{
+    uint16_t ie = EUSCI_A0->IE;//the reset clears it
+
+    EUSCI_A0->CTLW0 |= EUSCI_A_CTLW0_SWRST;
+    serialRate(smclk);
+    EUSCI_A0->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;
+    EUSCI_A0->IE = ie;
+}
+
+bool serialBusy(void)
+{
+    return serialBusyFlag;
+}
+
+uint16_t serialPeek(const uint8_t **data, uint16_t want)//points data at up to want received bytes in place, returns how many
+{
+    uint32_t head = serialHead();
+    uint16_t at;
+    uint16_t run;
+    uint16_t count;
+
+    if((head - serialTail) > SERIAL_RX_RING_SIZE)//fell a whole ring behind, the oldest bytes are gone
+    {
+        serialTail = head;
+    }
+    count = ((head - serialTail) < want) ? (uint16_t)(head - serialTail) : want;
+    at = serialTail & (SERIAL_RX_RING_SIZE - 1);
+    run = SERIAL_RX_RING_SIZE - at;
+    if(count > run)//wraps, mirror the start of the ring after its end
+    {
+        if(count > (run + SERIAL_RX_SLACK))
+        {
+            count = run + SERIAL_RX_SLACK;
+        }
+        memcpy(&serialRing[SERIAL_RX_RING_SIZE], serialRing, count - run);
+    }
+    *data = &serialRing[at];
+    return count;
+}
+
+void serialSkip(uint16_t count)//releases bytes seen with serialPeek()
+{
+    serialTail += count;
+}
+
+void serialWipe(uint16_t count)//zeroes and releases bytes seen with serialPeek(), for secrets
+{
+    uint16_t at = serialTail & (SERIAL_RX_RING_SIZE - 1);
+    uint16_t run = SERIAL_RX_RING_SIZE - at;
+
+    if(count > run)//wrapped, the start of the ring and its mirror in the slack
+    {
+        memset(serialRing, 0, count - run);
+        memset(&serialRing[SERIAL_RX_RING_SIZE], 0, count - run);
+        memset(&serialRing[at], 0, run);
+    }
+    else
+    {
+        memset(&serialRing[at], 0, count);
+    }
+    serialSkip(count);
+}
+
+bool serialRead(uint8_t *data)//takes the oldest received byte, returns 0 if there is none
+{
+    const uint8_t *next;
+
+    if(!serialPeek(&next, 1))
+    {
+        return 0;
+    }
+    *data = *next;
+    serialSkip(1);
+    return 1;
+}
+
+bool serialIdle(void)//1 once the line has been quiet for SERIAL_IDLE_MS, a partial frame then is never finished
+{
+    return serialIdleFlag;
+}
+
+static void serialIdlePoll(void)//software timer callback every SERIAL_IDLE_MS during a burst
+{
+    uint32_t head = serialHead();
+
+    if(head == serialPollHead)//nothing new, re-arm the start bit interrupt and check nothing slipped in meanwhile
+    {
+        EUSCI_A0->IFG &= ~EUSCI_A_IFG_STTIFG;
+        serialIdleFlag = 1;
+        EUSCI_A0->IE |= EUSCI_A_IE_STTIE;
+        head = serialHead();
+        if(head == serialPollHead)
+        {
+            swTimerStop(&serialIdleTimer);
+            eventPost(EVENT_SERIAL_RX);//readers see serialIdle()
+            return;
+        }
+        EUSCI_A0->IE &= ~EUSCI_A_IE_STTIE;
+        serialIdleFlag = 0;
+    }
+    serialPollHead = head;
+    eventPost(EVENT_SERIAL_RX);
+}
+
+void serialService(void)//starts the idle poll after a start bit, call on EVENT_SERIAL_RX before the readers
+{
+    if(!serialIdleFlag && !swTimerActive(&serialIdleTimer))
+    {
+        serialPollHead = serialHead();
+        swTimerStart(&serialIdleTimer, SERIAL_IDLE_MS, SERIAL_IDLE_MS, serialIdlePoll);
+    }
+}
+
+void serialSetCallback(void (*callback)(void))//callback is run from the DMA interrupt when a transmission has been handed to EUSCI_A0
+{
+    serialCallback = callback;
+}
+
+void EUSCIA0_IRQHandler(void)//Start bit after an idle line, once per burst, the DMA takes the bytes
+{
+    EUSCI_A0->IE &= ~EUSCI_A_IE_STTIE;
+    EUSCI_A0->IFG &= ~EUSCI_A_IFG_STTIFG;
+    serialIdleFlag = 0;
+    eventPost(EVENT_SERIAL_RX);//serialService() starts the idle poll
+}
+
+void serialRxDone(void)//one ring half full, DMA is on the other one now, re-arm this one behind it; called from DMA_INT0
+{
+    uint8_t half = serialRxHalf;
+
+    serialRxHalf = half ^ 1;
+    serialRxFilled += SERIAL_RX_HALF;
+    serialRxArm(half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT, &serialRing[half * SERIAL_RX_HALF]);
+    eventPost(EVENT_SERIAL_RX);
+}
+
+void DMA_INT3_IRQHandler(void)//Interrupt when the last UART byte has been loaded into EUSCI_A0
+{
+    MAP_DMA_clearInterruptFlag(SERIAL_DMA_CHANNEL);
+    serialBusyFlag = 0;
+    if(serialCallback)
+    {
+        serialCallback();
+    }
+}
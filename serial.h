@@ -0,0 +1,45 @@
+/*
+ * serial.h
+ *
+ * USB UART on EUSCI_A0 (P1.2 RX, P1.3 TX) at SERIAL_BAUD, 8N1.
+ * Reception is DMA channel 1 in ping-pong mode over the two halves of a SERIAL_RX_RING_SIZE
+ * ring, DMA_INT0 re-arms a half as it fills, so the CPU takes no interrupt per byte. Idle line
+ * detection runs per burst: the start bit interrupt of the first byte after an idle line starts a
+ * SERIAL_IDLE_MS poll of the DMA position, which posts EVENT_SERIAL_RX while bytes come in and
+ * turns the start bit interrupt back on once a poll sees none, serialIdle() is 1 from then on.
+ * Received bytes are read in place: serialPeek() points at up to SERIAL_RX_SLACK bytes at the
+ * tail (a run that wraps the ring end has its wrapped part mirrored after the end so the view is
+ * contiguous), serialSkip() releases them, serialWipe() zeroes them in the ring and the mirror
+ * first (key uploads), serialRead() takes one byte. If the reader falls a whole ring behind the
+ * oldest bytes are lost and the tail jumps to the newest.
+ * Transmission is fed by DMA channel 0 straight from the caller's buffer, so serialSend() returns
+ * immediately and the buffer has to stay untouched until the callback runs.
+ */
+
+#ifndef SERIAL_H_
+#define SERIAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Serial settings
+#define SERIAL_BAUD 921600
+#define SERIAL_RX_RING_SIZE 512       //bytes, two DMA halves of ~2.8 ms each at SERIAL_BAUD, power of 2
+#define SERIAL_RX_SLACK 80            //largest serialPeek() view across the ring end, at least FRAME_MAX_BYTES (frame.h)
+#define SERIAL_IDLE_MS 1              //a poll with no new byte ends the burst, ~92 byte times
+#define SERIAL_RX_DMA_CHANNEL 1
+
+void serialInit(void);
+bool serialSend(const uint8_t *data, uint16_t length);
+bool serialBusy(void);
+bool serialRead(uint8_t *data);
+uint16_t serialPeek(const uint8_t **data, uint16_t want);
+void serialSkip(uint16_t count);
+void serialWipe(uint16_t count);
+bool serialIdle(void);
+void serialService(void);
+void serialRxDone(void);
+void serialSetCallback(void (*callback)(void));
+void serialSetClock(uint32_t smclk);
+
+#endif /* SERIAL_H_ */
@@ -0,0 +1,248 @@
+/*
+ * shift.c
+ *
+ * Shift relay state machine, see shift.h.
+ * Only called from the PORT6, TA2_0 and TA2_N interrupts, which share PRIORITY_SHIFT so they
+ * never preempt each other, apart from shiftSetContext() and shiftPop() in the main loop.
+ */
+
+#include "hal.h"
+#include "shift.h"
+#include "clock.h"
+#include "events.h"
+#include "timebase.h"
+#include "tach.h"
+#include "priority.h"
+#include "ramfunc.h"
+
+#define SHIFT_UP_RELAY BIT4
+#define SHIFT_DOWN_RELAY BIT5
+#define SHIFT_CUT_OUT BIT6
+#define SHIFT_CUT_GEARS 7
+#define SHIFT_MS_TO_TICKS(ms) ((uint16_t)(((uint32_t)(ms) * CLOCK_ACLK_HZ) / 1000))
+#define SHIFT_TICKS_PER_US (TACH_COUNT_HZ / 1000000)
+
+static volatile shiftState_t shiftCurrent = SHIFT_IDLE;
+static volatile shiftDir_t shiftDirection = SHIFT_UP;
+static volatile uint8_t shiftRetries = 0;
+static volatile bool shiftFaultFlag = 0;
+static volatile uint16_t shiftCutTicks = 0;//0 = no cut for the next upshift
+static volatile uint16_t shiftRpm = 0;//context from the main loop for the shift record
+static volatile uint8_t shiftGear = 0;
+static shiftRecord_t shiftActive;//shift in progress, only touched from the shift interrupts
+static uint32_t shiftStartTicks = 0;//paddle edge, tachNow() base
+
+static volatile shiftRecord_t shiftRing[SHIFT_RING_SIZE];
+static volatile uint8_t shiftHead = 0;//only written from the shift interrupts
+static volatile uint8_t shiftTail = 0;//only written by shiftPop()
+
+static const uint8_t shiftCutMs[SHIFT_CUT_GEARS] = SHIFT_CUT_MS;
+
+static RAMFUNC void shiftDeadline(uint16_t ms)//arms TIMER_A2 CCR0 to interrupt ms from now
+{
+    TIMER_A2->CCR[0] = TIMER_A2->R + SHIFT_MS_TO_TICKS(ms);
+    TIMER_A2->CCTL[0] = TIMER_A_CCTLN_CCIE;
+}
+
+static RAMFUNC void shiftCutEnd(void)
+{
+    TIMER_A2->CCTL[1] = 0;
+    P8OUT &= ~SHIFT_CUT_OUT;
+}
+
+static RAMFUNC void shiftCutStart(void)//ignition cut for the time set by shiftSetContext
+{
+    uint16_t ticks = shiftCutTicks;
+
+    if(ticks == 0)
+    {
+        return;
+    }
+    P8OUT |= SHIFT_CUT_OUT;
+    TIMER_A2->CCR[1] = TIMER_A2->R + ticks;
+    TIMER_A2->CCTL[1] = TIMER_A_CCTLN_CCIE;
+}
+
+static RAMFUNC void shiftFinish(bool faulted, uint32_t timestamp)//queues the record of the shift that just ended for the log
+{
+    uint32_t latency = timestamp - shiftStartTicks;
+    uint8_t head = shiftHead;
+    uint8_t next = (head + 1) & (SHIFT_RING_SIZE - 1);
+
+    shiftActive.latencyTicks = faulted ? 0 : latency;
+    latency /= SHIFT_TICKS_PER_US;
+    if(faulted || (latency > 0xFFFF))
+    {
+        latency = 0xFFFF;
+    }
+    shiftActive.latencyUs = latency;
+    shiftActive.retries = shiftRetries;
+    shiftActive.faulted = faulted;
+
+    if(next == shiftTail)//full, the log is behind, drop this record
+    {
+        return;
+    }
+    shiftRing[head] = shiftActive;
+    shiftHead = next;
+    eventPost(EVENT_SHIFT_DONE);
+}
+
+static RAMFUNC void shiftRelaysOff(void)
+{
+    P8OUT &= ~(SHIFT_UP_RELAY | SHIFT_DOWN_RELAY);
+    shiftCutEnd();//never leave the ECU cutting without a relay pushing the barrel
+}
+
+static RAMFUNC void shiftEnergize(void)//relay for the current direction on, the other off, and start the pulse deadline
+{
+    if(shiftDirection == SHIFT_UP)
+    {
+        P8OUT &= ~SHIFT_DOWN_RELAY;
+        P8OUT |=  SHIFT_UP_RELAY;
+    }
+    else
+    {
+        P8OUT &= ~SHIFT_UP_RELAY;
+        P8OUT |=  SHIFT_DOWN_RELAY;
+    }
+    shiftCurrent = SHIFT_ACTUATING;
+    shiftDeadline(SHIFT_PULSE_MS);
+}
+
+void shiftInit(void)//starts TIMER_A2 free-running from ACLK for the relay deadlines
+{
+    shiftRelaysOff();
+
+    TIMER_A2->CCTL[0] = 0;
+    TIMER_A2->CCTL[1] = 0;
+    TIMER_A2->CTL = TIMER_A_CTL_SSEL__ACLK |    // ACLK, continuous mode
+            TIMER_A_CTL_MC__CONTINUOUS |
+            TIMER_A_CTL_CLR;
+
+    NVIC->ISER[0] = 1 << ((TA2_0_IRQn) & 31);
+    NVIC->ISER[0] = 1 << ((TA2_N_IRQn) & 31);
+}
+
+RAMFUNC void shiftRequest(shiftDir_t dir, uint32_t timestamp)//paddle pulled at timestamp (tachNow()), ignored while a shift is already in progress
+{
+    if((shiftCurrent == SHIFT_ACTUATING) || (shiftCurrent == SHIFT_REST))
+    {
+        return;
+    }
+    shiftStartTicks = timestamp;
+    shiftDirection = dir;
+    shiftRetries = 0;
+    shiftEnergize();
+    shiftActive.timestamp = millis();
+    shiftActive.rpm = shiftRpm;
+    shiftActive.gear = shiftGear;
+    shiftActive.dir = dir;
+    if(dir == SHIFT_UP)
+    {
+        shiftCutStart();//first attempt only, a retry is a slow shift anyway
+    }
+}
+
+RAMFUNC void shiftConfirm(shiftDir_t dir, uint32_t timestamp)//hall effect saw the barrel move in dir at timestamp (tachNow())
+{
+    if(((shiftCurrent == SHIFT_ACTUATING) || (shiftCurrent == SHIFT_REST)) && (dir == shiftDirection))
+    {
+        TIMER_A2->CCTL[0] = 0;//cancel the deadline
+        shiftRelaysOff();
+        shiftCurrent = SHIFT_IDLE;
+        shiftFaultFlag = 0;
+        shiftFinish(0, timestamp);
+    }
+    eventPost((dir == SHIFT_UP) ? EVENT_UPSHIFT : EVENT_DOWNSHIFT);//gear moved either way, update 7 segment
+}
+
+void shiftSetContext(uint16_t rpm, uint8_t gear)//main loop, precomputes the cut time for the next upshift
+{
+    uint32_t ms = 0;
+    uint8_t mask;
+
+    if((rpm >= SHIFT_CUT_MIN_RPM) && (gear < SHIFT_CUT_GEARS))
+    {
+        ms = shiftCutMs[gear];
+        if(rpm > SHIFT_CUT_REF_RPM)
+        {
+            ms = (ms * SHIFT_CUT_REF_RPM) / rpm;//barrel moves faster at higher RPM, shorter cut
+        }
+        if(ms < SHIFT_CUT_FLOOR_MS)
+        {
+            ms = SHIFT_CUT_FLOOR_MS;
+        }
+        if(ms > SHIFT_PULSE_MS)
+        {
+            ms = SHIFT_PULSE_MS;
+        }
+    }
+
+    mask = criticalEnter(PRIORITY_SHIFT);//a paddle sees all three from the same pass, tach capture is not held off
+    shiftRpm = rpm;
+    shiftGear = gear;
+    shiftCutTicks = SHIFT_MS_TO_TICKS(ms);
+    criticalExit(mask);
+}
+
+bool shiftPop(shiftRecord_t *record)//takes the oldest finished shift, returns 0 if there is none
+{
+    uint8_t tail = shiftTail;
+
+    if(tail == shiftHead)
+    {
+        return 0;
+    }
+    *record = shiftRing[tail];
+    shiftTail = (tail + 1) & (SHIFT_RING_SIZE - 1);//release the slot only after it has been copied
+    return 1;
+}
+
+shiftState_t shiftState(void)
+{
+    return shiftCurrent;
+}
+
+bool shiftFaulted(void)//1 from a shift giving up until the next confirmed shift
+{
+    return shiftFaultFlag;
+}
+
+RAMFUNC void TA2_0_IRQHandler(void)//Shift relay deadline
+{
+    TIMER_A2->CCTL[0] = 0;//one-shot, also clears CCIFG
+
+    if(shiftCurrent == SHIFT_ACTUATING)//no hall effect before the deadline
+    {
+        shiftRelaysOff();
+        if(shiftRetries < SHIFT_MAX_RETRIES)
+        {
+            shiftRetries++;
+            shiftCurrent = SHIFT_REST;
+            shiftDeadline(SHIFT_REST_MS);
+        }
+        else
+        {
+            shiftCurrent = SHIFT_FAULT;
+            shiftFaultFlag = 1;
+            shiftFinish(1, tachNow());
+        }
+    }
+    else if(shiftCurrent == SHIFT_REST)//retry
+    {
+        shiftEnergize();
+    }
+}
+
+RAMFUNC void TA2_N_IRQHandler(void)//Ignition cut end
+{
+    switch(TIMER_A2->IV)
+    {
+    case 0x02://CCR1
+        shiftCutEnd();
+        break;
+    default:
+        break;
+    }
+}
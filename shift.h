@@ -0,0 +1,79 @@
+/*
+ * shift.h
+ *
+ * Paddle shift actuation state machine for the pneumatic shift relays (P8.4 up, P8.5 down).
+ * A paddle energizes its relay straight from the PORT6 interrupt, and TIMER_A2 CCR0 (ACLK)
+ * enforces a maximum pulse length, so a relay is always released on a deterministic
+ * deadline even if the hall effect confirmation never arrives. A timed out shift rests and
+ * retries up to SHIFT_MAX_RETRIES times before the controller latches a fault.
+ *
+ *      IDLE -paddle-> ACTUATING -hall-> IDLE
+ *                     ACTUATING -timeout-> REST -rest over-> ACTUATING (retry)
+ *                     ACTUATING -timeout, no retries left-> FAULT
+ *      FAULT -paddle-> ACTUATING (the fault stays flagged until a shift is confirmed)
+ *
+ * Smart shifting: an upshift above SHIFT_CUT_MIN_RPM also raises the ignition cut line to the
+ * PE3 ECU (P8.6) together with the relay. TIMER_A2 CCR1 drops it after a cut time looked up
+ * from the current gear and scaled down with RPM, or earlier when the hall effect confirms the
+ * shift, so the driver can upshift flat foot. The main loop keeps the cut time current with
+ * shiftSetContext() so nothing is calculated in the interrupt.
+ *
+ * Every finished shift, confirmed or faulted, is queued as a shiftRecord_t for the shift log
+ * and EVENT_SHIFT_DONE is posted, drain them with shiftPop(). The latency is taken from the
+ * paddle and hall effect edge stamps of the PORT6 interrupt entry (inputs.h), in TACH_COUNT_HZ
+ * ticks of the tach timestamp base (83 ns), so the ISR path in between is not part of it.
+ */
+
+#ifndef SHIFT_H_
+#define SHIFT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Shift settings
+#define SHIFT_PULSE_MS 80           //maximum time a relay is held waiting for the hall effect
+#define SHIFT_REST_MS 40            //relay off time before a retry
+#define SHIFT_MAX_RETRIES 1         //extra attempts after the first timeout
+#define SHIFT_RING_SIZE 4           //finished shifts waiting for the main loop, power of 2
+
+//Ignition cut settings
+#define SHIFT_CUT_MIN_RPM 4000      //no cut below this, part throttle upshifts don't need it
+#define SHIFT_CUT_REF_RPM 8000      //cut times in the table are for this RPM, shorter above it
+#define SHIFT_CUT_FLOOR_MS 25       //never cut for less than this
+#define SHIFT_CUT_MS {0, 70, 60, 55, 50, 45, 45}//cut time per gear being shifted out of, index is gearIndex
+
+typedef enum
+{
+    SHIFT_UP,
+    SHIFT_DOWN
+} shiftDir_t;
+
+typedef enum
+{
+    SHIFT_IDLE,
+    SHIFT_ACTUATING,
+    SHIFT_REST,
+    SHIFT_FAULT
+} shiftState_t;
+
+typedef struct
+{
+    uint32_t timestamp;             //millis() when the paddle was pulled
+    uint16_t rpm;                   //engine RPM when the paddle was pulled
+    uint16_t latencyUs;             //paddle to hall effect, saturates at 0xFFFF, 0xFFFF for a fault
+    uint32_t latencyTicks;          //paddle to hall effect in TACH_COUNT_HZ ticks, does not saturate, 0 for a fault
+    uint8_t gear;                   //gearIndex when the paddle was pulled
+    uint8_t dir;                    //shiftDir_t
+    uint8_t retries;                //timeouts before the shift finished
+    bool faulted;                   //1 if the shift gave up
+} shiftRecord_t;
+
+void shiftInit(void);
+void shiftRequest(shiftDir_t dir, uint32_t timestamp);
+void shiftConfirm(shiftDir_t dir, uint32_t timestamp);
+void shiftSetContext(uint16_t rpm, uint8_t gear);
+shiftState_t shiftState(void);
+bool shiftFaulted(void);
+bool shiftPop(shiftRecord_t *record);
+
+#endif /* SHIFT_H_ */
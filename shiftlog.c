@@ -0,0 +1,106 @@
+/*
+ * shiftlog.c
+ *
+ * Circular shift log in the FRAM, see shiftlog.h.
+ */
+
+#include "shiftlog.h"
+#include "crc.h"
+#include "logscan.h"
+
+static shiftLogRecord_t shiftLogQueue[SHIFTLOG_QUEUE_SIZE];//only touched from the main loop
+static uint8_t shiftLogHead = 0;
+static uint8_t shiftLogTail = 0;
+static uint16_t shiftLogSlot = 0;//next FRAM slot to write
+static uint32_t shiftLogSequence = 0;//sequence number of the next record
+static uint32_t shiftLogStored = 0;//valid records in the FRAM
+
+static uint16_t shiftLogCrc(const shiftLogRecord_t *record)
+{
+    return (uint16_t)crcBlock(record, SHIFTLOG_CRC_BYTES);
+}
+
+static bool shiftLogValid(const shiftLogRecord_t *record)
+{
+    return (record->sequence != 0xFFFFFFFF) && (shiftLogCrc(record) == record->crc);
+}
+
+static bool shiftLogScanRead(uint16_t slot, uint32_t *sequence)//logScan() slot reader
+{
+    shiftLogRecord_t record;
+
+    framRead(SHIFTLOG_BASE + ((uint32_t)slot * SHIFTLOG_RECORD_BYTES), (uint8_t *)&record, SHIFTLOG_RECORD_BYTES);
+    *sequence = record.sequence;
+    return shiftLogValid(&record);
+}
+
+void shiftLogInit(void)//finds the newest record, blocks for the FRAM scan so call it before the main loop
+{
+    logScan_t scan;
+
+    logScan(SHIFTLOG_RECORDS, shiftLogScanRead, &scan);
+    shiftLogSlot = scan.next;
+    shiftLogSequence = scan.sequence;
+    shiftLogStored = scan.stored;
+}
+
+bool shiftLogAppend(const shiftRecord_t *shift)//queues shift for the FRAM, returns 0 if the queue is full
+{
+    shiftLogRecord_t *record = &shiftLogQueue[shiftLogHead];
+    uint8_t next = (shiftLogHead + 1) & (SHIFTLOG_QUEUE_SIZE - 1);
+
+    if(next == shiftLogTail)
+    {
+        return 0;
+    }
+    record->sequence = shiftLogSequence;
+    record->timestamp = shift->timestamp;
+    record->rpm = shift->rpm;
+    record->latencyUs = shift->latencyUs;
+    record->gear = shift->gear;
+    record->flags = ((shift->dir == SHIFT_DOWN) ? SHIFTLOG_FLAG_DOWN : 0) |
+                    (shift->faulted ? SHIFTLOG_FLAG_FAULT : 0) | (shift->retries << SHIFTLOG_RETRY_SHIFT);
+    record->crc = shiftLogCrc(record);
+
+    shiftLogSequence++;
+    if(shiftLogSequence == 0xFFFFFFFF)
+    {
+        shiftLogSequence = 0;
+    }
+    shiftLogHead = next;
+    shiftLogService();
+    return 1;
+}
+
+void shiftLogService(void)//hands queued records to the FRAM queue while it has room, call on EVENT_FRAM_DONE
+{
+    while((shiftLogTail != shiftLogHead) &&
+          framWrite(SHIFTLOG_BASE + ((uint32_t)shiftLogSlot * SHIFTLOG_RECORD_BYTES),
+                    (const uint8_t *)&shiftLogQueue[shiftLogTail], SHIFTLOG_RECORD_BYTES))
+    {
+        shiftLogTail = (shiftLogTail + 1) & (SHIFTLOG_QUEUE_SIZE - 1);//framWrite() copied the record
+        shiftLogSlot = (shiftLogSlot + 1) % SHIFTLOG_RECORDS;
+        if(shiftLogStored < SHIFTLOG_RECORDS)
+        {
+            shiftLogStored++;
+        }
+    }
+}
+
+uint32_t shiftLogCount(void)//records stored in the FRAM
+{
+    return shiftLogStored;
+}
+
+bool shiftLogRead(uint32_t age, shiftLogRecord_t *record)//blocking read of a stored record behind any queued writes, age 0 is the newest, returns 0 if it is not valid
+{
+    uint16_t slot;
+
+    if(age >= shiftLogStored)
+    {
+        return 0;
+    }
+    slot = (shiftLogSlot + SHIFTLOG_RECORDS - 1 - (age % SHIFTLOG_RECORDS)) % SHIFTLOG_RECORDS;
+    framRead(SHIFTLOG_BASE + ((uint32_t)slot * SHIFTLOG_RECORD_BYTES), (uint8_t *)record, SHIFTLOG_RECORD_BYTES);
+    return shiftLogValid(record);
+}
@@ -0,0 +1,53 @@
+/*
+ * shiftlog.h
+ *
+ * Append-only circular shift log in the FRAM. Every finished shift becomes one fixed size
+ * record with a sequence number and a CRC from the hardware CRC32 module (crc.h). There is no
+ * index to keep up to date, at start up the newest record is found by a binary search over the
+ * sequence numbers (logscan.h), so a write torn by a power loss only costs that one record and
+ * the scan time does not grow with the log. FRAM has no wear limit that
+ * matters here, old records are simply overwritten once the log wraps.
+ *
+ * Records are queued in RAM by shiftLogAppend() and written one at a time by DMA, the main
+ * loop calls shiftLogService() on EVENT_FRAM_DONE to start the next one, before any other
+ * FRAM user so shifts are never held up by telemetry.
+ */
+
+#ifndef SHIFTLOG_H_
+#define SHIFTLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fram.h"
+#include "shift.h"
+
+//Shift log settings
+#define SHIFTLOG_BASE 0x0000                        //first FRAM byte of the log
+#define SHIFTLOG_BYTES 0x1000                       //256 shifts
+#define SHIFTLOG_RECORD_BYTES 16
+#define SHIFTLOG_RECORDS (SHIFTLOG_BYTES / SHIFTLOG_RECORD_BYTES)
+#define SHIFTLOG_QUEUE_SIZE 8                       //records waiting for the FRAM, power of 2
+
+#define SHIFTLOG_FLAG_DOWN 0x01
+#define SHIFTLOG_FLAG_FAULT 0x02
+#define SHIFTLOG_RETRY_SHIFT 4                      //retries in the upper nibble of flags
+#define SHIFTLOG_CRC_BYTES (SHIFTLOG_RECORD_BYTES - 2)//record bytes covered by the CRC
+
+typedef struct
+{
+    uint32_t sequence;              //0xFFFFFFFF is never written, an erased / blank slot reads as invalid
+    uint32_t timestamp;             //ms since power up
+    uint16_t rpm;
+    uint16_t latencyUs;             //paddle to hall effect, 0xFFFF for a fault
+    uint8_t gear;
+    uint8_t flags;                  //SHIFTLOG_FLAG_x | retries << SHIFTLOG_RETRY_SHIFT
+    uint16_t crc;                   //low half of the CRC32 of the bytes before it
+} shiftLogRecord_t;
+
+void shiftLogInit(void);
+bool shiftLogAppend(const shiftRecord_t *shift);
+void shiftLogService(void);
+uint32_t shiftLogCount(void);
+bool shiftLogRead(uint32_t age, shiftLogRecord_t *record);
+
+#endif /* SHIFTLOG_H_ */
@@ -0,0 +1,69 @@
+/*
+ * shiftpoints.c
+ *
+ * Per gear shift point table in the FRAM, see shiftpoints.h.
+ */
+
+#include "shiftpoints.h"
+#include "fram.h"
+#include "crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static shiftPoints_t shiftPoints;//table the meter was loaded from
+static bool shiftPointsDirty = 0;//shiftPoints not written to the FRAM yet
+static bool shiftPointsCustom = 0;//table came from the FRAM or the download port, not from the max RPM
+
+void shiftPointsRestore(void)//blocking read, loads the stored table into the meter or leaves the defaults, call after paramsRestore()
+{
+    shiftPoints_t record;
+
+    framRead(SHIFTPOINT_BASE, (uint8_t *)&record, sizeof(shiftPoints_t));
+    if((record.gears == METER_GEARS) && (crcBlock(&record, offsetof(shiftPoints_t, crc)) == record.crc) && meterLoad(record.points))
+    {
+        memcpy(&shiftPoints, &record, sizeof(shiftPoints_t));
+        shiftPointsCustom = 1;
+    }
+}
+
+void shiftPointsDefaults(uint16_t maxRpm)//derives the table from the max RPM (meterDefaults()) unless one was stored or uploaded
+{
+    if(!shiftPointsCustom)
+    {
+        meterDefaults(maxRpm, shiftPoints.points);
+        meterLoad(shiftPoints.points);
+    }
+}
+
+bool shiftPointsSet(const meterShiftPoint_t *points)//new METER_GEARS table, rebuilds the meter and saves it, returns 0 if it is invalid
+{
+    if(!meterLoad(points))
+    {
+        return 0;
+    }
+    memcpy(shiftPoints.points, points, sizeof(shiftPoints.points));
+    shiftPointsCustom = 1;
+    shiftPointsDirty = 1;
+    shiftPointsService();
+    return 1;
+}
+
+const meterShiftPoint_t *shiftPointsTable(void)
+{
+    return shiftPoints.points;
+}
+
+void shiftPointsService(void)//queues the pending save, call on EVENT_FRAM_DONE in case the FRAM queue was full
+{
+    if(!shiftPointsDirty)
+    {
+        return;
+    }
+    shiftPoints.gears = METER_GEARS;
+    memset(shiftPoints.spare, 0, sizeof(shiftPoints.spare));
+    shiftPoints.crc = crcBlock(&shiftPoints, offsetof(shiftPoints_t, crc));
+    if(framWrite(SHIFTPOINT_BASE, (const uint8_t *)&shiftPoints, sizeof(shiftPoints_t)))
+    {
+        shiftPointsDirty = 0;//framWrite() copied the record
+    }
+}
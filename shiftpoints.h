@@ -0,0 +1,39 @@
+/*
+ * shiftpoints.h
+ *
+ * Per gear shift points (meter.h) kept in the FRAM, in the dash state area after the
+ * checkpoint slots. The record is the METER_GEARS table followed by a gear count and a CRC32
+ * (crc.h), a blank or torn record fails the CRC and the meter keeps the defaults derived from the
+ * max RPM parameter (params.h).
+ * shiftPointsRestore() is a blocking read for start up. A new table comes in over the log
+ * download port ('W', download.h), is validated, loaded into the meter so the thresholds are
+ * rebuilt once, and written back from shiftPointsService() on EVENT_FRAM_DONE.
+ */
+
+#ifndef SHIFTPOINTS_H_
+#define SHIFTPOINTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "meter.h"
+#include "checkpoint.h"
+
+//Shift point settings
+#define SHIFTPOINT_BASE (CHECKPOINT_BASE + (CHECKPOINT_SLOTS * CHECKPOINT_SLOT_BYTES))
+#define SHIFTPOINT_TABLE_BYTES (METER_GEARS * sizeof(meterShiftPoint_t))//payload of the 'W' command
+
+typedef struct
+{
+    meterShiftPoint_t points[METER_GEARS];
+    uint8_t gears;                  //METER_GEARS, a table for another layout is ignored
+    uint8_t spare[3];
+    uint32_t crc;                   //CRC32 of everything before it
+} shiftPoints_t;
+
+void shiftPointsRestore(void);
+void shiftPointsDefaults(uint16_t maxRpm);
+bool shiftPointsSet(const meterShiftPoint_t *points);
+const meterShiftPoint_t *shiftPointsTable(void);
+void shiftPointsService(void);
+
+#endif /* SHIFTPOINTS_H_ */
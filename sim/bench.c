@@ -0,0 +1,352 @@
+/*
+ * bench.c
+ *
+ * Replays a tach trace through the shared tach capture, filter, meter and shift modules on the
+ * host and reports throughput and the cost of every edge (capture ISR plus the main loop work it
+ * causes, the same path as main.c).
+ *
+ *      bench [-x speed] [-s seconds] [-w out] [trace]
+ *
+ * trace is text, one event per line, times in TACH_COUNT_HZ ticks since the start:
+ *      <ticks> or E <ticks>    tach edge
+ *      U <ticks> / D <ticks>   up / down paddle pulled
+ *      u <ticks> / d <ticks>   up / down hall effect (shift confirmed)
+ *      # ...                   comment
+ * Without a trace a run of -s seconds (default 60) is synthesised: full throttle pulls through
+ * the gears with jitter on every period, then a braking run back down.
+ * -x paces the replay at speed times real time (e.g. -x 100), 0 (default) runs flat out.
+ * -w writes every event replayed to out as a trace, so a synthetic run can be kept and replayed
+ * (pull10.trace is -s 10, make check).
+ * Costs are host wall clock, so the max also catches host scheduling, compare means between runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sim.h"
+#include "events.h"
+#include "tach.h"
+#include "tach_filter.h"
+#include "tach_predict.h"
+#include "meter.h"
+#include "shift.h"
+
+#define BENCH_NS_PER_TICK (1000000000.0 / TACH_COUNT_HZ)
+#define BENCH_UPSHIFT_RPM 10500
+#define BENCH_DOWNSHIFT_RPM 5000
+#define BENCH_TOP_RPM 11500
+#define BENCH_GEAR_RATIO 0.75       //RPM after / before an upshift
+#define BENCH_HALL_MS 25            //paddle to hall effect
+
+typedef struct
+{
+    char type;                      //E, U, D, u, d
+    uint64_t ticks;
+} benchEvent_t;
+
+typedef struct
+{
+    double rpm;
+    double ticks;                   //last edge
+    double period;                  //next period, 0 until drawn
+    double endTicks;
+    uint8_t gear;
+    bool braking;
+    benchEvent_t pending[2];        //paddle, then its hall effect, type 0 for none
+    uint32_t seed;
+} benchSynth_t;
+
+static uint8_t benchGear = 1;
+static uint16_t benchRpm = 0;
+static uint8_t benchLeds = 0;
+static uint32_t benchShifts = 0;
+static uint32_t benchFaults = 0;
+
+static uint64_t benchWallNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static bool benchRead(FILE *trace, benchEvent_t *event)//next event of a trace file, 0 at the end
+{
+    char line[64];
+    unsigned long long ticks;
+    char type;
+
+    while(fgets(line, sizeof(line), trace))
+    {
+        if(sscanf(line, " %llu", &ticks) == 1)//bare edge time
+        {
+            event->type = 'E';
+            event->ticks = ticks;
+            return 1;
+        }
+        if((sscanf(line, " %c %llu", &type, &ticks) == 2) && strchr("EUDud", type))
+        {
+            event->type = type;
+            event->ticks = ticks;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void benchWrite(FILE *out, const benchEvent_t *event)//one trace line, edges as bare times
+{
+    if(event->type == 'E')
+    {
+        fprintf(out, "%llu\n", (unsigned long long)event->ticks);
+    }
+    else
+    {
+        fprintf(out, "%c %llu\n", event->type, (unsigned long long)event->ticks);
+    }
+}
+
+static void benchShift(benchSynth_t *synth, char paddle, uint64_t ticks)//paddle now, hall effect BENCH_HALL_MS later
+{
+    synth->pending[0].type = paddle;
+    synth->pending[0].ticks = ticks;
+    synth->pending[1].type = paddle - 'A' + 'a';
+    synth->pending[1].ticks = ticks + ((uint64_t)TACH_COUNT_HZ * BENCH_HALL_MS) / 1000;
+}
+
+static bool benchSynth(benchSynth_t *synth, benchEvent_t *event)//next event of the synthetic run, 0 at the end
+{
+    uint8_t k;
+
+    if(!synth->period)//+-0.5 % jitter on every period, LCG
+    {
+        synth->seed = synth->seed * 1664525u + 1013904223u;
+        synth->period = ((double)TACH_RPM_NUMERATOR / synth->rpm) *
+                        (1.0 + ((double)(synth->seed >> 8) / (double)(1u << 24) - 0.5) * 0.01);
+    }
+    for(k = 0; k < 2; k++)
+    {
+        if(synth->pending[k].type && (synth->pending[k].ticks <= (uint64_t)(synth->ticks + synth->period)))
+        {
+            *event = synth->pending[k];
+            synth->pending[k].type = 0;
+            if(event->type == 'u')
+            {
+                synth->rpm *= BENCH_GEAR_RATIO;
+            }
+            else if(event->type == 'd')
+            {
+                synth->rpm /= BENCH_GEAR_RATIO;
+            }
+            return 1;
+        }
+    }
+    if(synth->ticks >= synth->endTicks)
+    {
+        return 0;
+    }
+
+    synth->ticks += synth->period;
+    synth->rpm += (synth->braking ? -4000.0 : 3000.0 / synth->gear) * (synth->period / TACH_COUNT_HZ);//RPM per second
+    synth->period = 0;
+    event->type = 'E';
+    event->ticks = (uint64_t)synth->ticks;
+
+    if(synth->pending[1].type)//shift in progress
+    {
+        return 1;
+    }
+    if(!synth->braking && (synth->rpm >= BENCH_UPSHIFT_RPM) && (synth->gear < 6))
+    {
+        synth->gear++;
+        benchShift(synth, 'U', event->ticks + 1);
+    }
+    else if(!synth->braking && (synth->rpm >= BENCH_TOP_RPM))
+    {
+        synth->braking = 1;
+    }
+    else if(synth->braking && (synth->rpm <= BENCH_DOWNSHIFT_RPM))
+    {
+        if(synth->gear > 1)
+        {
+            synth->gear--;
+            benchShift(synth, 'D', event->ticks + 1);
+        }
+        else
+        {
+            synth->braking = 0;//back on the throttle in first
+        }
+    }
+    return 1;
+}
+
+static void benchLoop(void)//main loop pass, same order and work as main.c
+{
+    tachSample_t sample;
+    shiftRecord_t record;
+    uint32_t count = 0;
+
+    if(eventTake(EVENT_TACH))
+    {
+        while(tachPop(&sample))
+        {
+            count = tachFilter(&sample);
+            tachPredictAdd(sample.timestamp, count);
+        }
+        meterSetGear(benchGear);
+        benchLeds = meterLeds(tachPredict(tachNow()));
+        benchRpm = tachCountToRPM(count);
+        shiftSetContext(benchRpm, benchGear);
+    }
+    if(eventTake(EVENT_SHIFT_DONE))
+    {
+        while(shiftPop(&record))
+        {
+            benchShifts++;
+            benchFaults += record.faulted;
+        }
+    }
+    if(eventTake(EVENT_UPSHIFT) && (benchGear < 6))
+    {
+        benchGear++;
+        shiftSetContext(benchRpm, benchGear);
+    }
+    else if(eventTake(EVENT_DOWNSHIFT) && (benchGear > 1))
+    {
+        benchGear--;
+        shiftSetContext(benchRpm, benchGear);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    benchSynth_t synth = {2000.0, 0.0, 0.0, 0.0, 1, 0, {{0, 0}, {0, 0}}, 12345};
+    benchEvent_t event;
+    FILE *trace = 0;
+    FILE *out = 0;
+    double speed = 0;
+    double seconds = 60;
+    uint64_t edges = 0;
+    uint64_t costTotal = 0;
+    uint64_t costMax = 0;
+    uint64_t costMaxAt = 0;
+    uint64_t wallStart;
+    uint64_t wallEnd;
+    uint64_t start;
+    uint64_t cost;
+    int k;
+
+    for(k = 1; k < argc; k++)
+    {
+        if(!strcmp(argv[k], "-x") && (k + 1 < argc))
+        {
+            speed = atof(argv[++k]);
+        }
+        else if(!strcmp(argv[k], "-s") && (k + 1 < argc))
+        {
+            seconds = atof(argv[++k]);
+        }
+        else if(!strcmp(argv[k], "-w") && (k + 1 < argc))
+        {
+            if(!(out = fopen(argv[++k], "w")))
+            {
+                fprintf(stderr, "bench: cannot create %s\n", argv[k]);
+                return 1;
+            }
+            fprintf(out, "# bench trace, %lu ticks per second\n", (unsigned long)TACH_COUNT_HZ);
+        }
+        else if(!(trace = fopen(argv[k], "r")))
+        {
+            fprintf(stderr, "bench: cannot open %s\n", argv[k]);
+            return 1;
+        }
+    }
+    synth.endTicks = seconds * TACH_COUNT_HZ;
+
+    simReset();
+    tachInit();
+    tachFilterReset();
+    tachPredictReset();
+    meterInit();
+    shiftInit();
+
+    wallStart = benchWallNs();
+    while(trace ? benchRead(trace, &event) : benchSynth(&synth, &event))
+    {
+        uint64_t at = (uint64_t)(event.ticks * BENCH_NS_PER_TICK);
+
+        if(out)
+        {
+            benchWrite(out, &event);
+        }
+        if(at < simNow())//out of order trace line
+        {
+            continue;
+        }
+        simAdvance(at);
+        benchLoop();//anything the timer ISRs on the way posted
+
+        start = benchWallNs();
+        switch(event.type)
+        {
+        case 'E':
+            simTachEdge();
+            break;
+        case 'U':
+            shiftRequest(SHIFT_UP, tachNow());
+            break;
+        case 'D':
+            shiftRequest(SHIFT_DOWN, tachNow());
+            break;
+        case 'u':
+            shiftConfirm(SHIFT_UP, tachNow());
+            break;
+        case 'd':
+            shiftConfirm(SHIFT_DOWN, tachNow());
+            break;
+        default:
+            break;
+        }
+        benchLoop();
+        if(event.type == 'E')
+        {
+            cost = benchWallNs() - start;
+            edges++;
+            costTotal += cost;
+            if(cost > costMax)
+            {
+                costMax = cost;
+                costMaxAt = at;
+            }
+        }
+
+        if(speed > 0)//hold the replay to speed x real time
+        {
+            uint64_t due = wallStart + (uint64_t)(at / speed);
+            uint64_t now = benchWallNs();
+            if(due > now)
+            {
+                struct timespec wait = {(time_t)((due - now) / 1000000000u), (long)((due - now) % 1000000000u)};
+                nanosleep(&wait, 0);
+            }
+        }
+    }
+    wallEnd = benchWallNs();
+
+    printf("edges %llu  dropped %u  shifts %u  faults %u  gear %u  leds %u\n", (unsigned long long)edges,
+           tachDropped(), benchShifts, benchFaults, benchGear, benchLeds);
+    printf("sim %.3f s  wall %.3f s  speed %.1fx\n", simNow() / 1e9, (wallEnd - wallStart) / 1e9,
+           (wallEnd > wallStart) ? (double)simNow() / (wallEnd - wallStart) : 0.0);
+    printf("edge cost mean %.0f ns  max %llu ns at %.6f s  throughput %.0f edges/s\n",
+           edges ? (double)costTotal / edges : 0.0, (unsigned long long)costMax, costMaxAt / 1e9,
+           costTotal ? edges * 1e9 / costTotal : 0.0);
+    if(trace)
+    {
+        fclose(trace);
+    }
+    if(out)
+    {
+        fclose(out);
+    }
+    return 0;
+}
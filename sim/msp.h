@@ -0,0 +1,12 @@
+/*
+ * msp.h
+ *
+ * Host simulation stand-in for the device header, see sim_hal.h.
+ */
+
+#ifndef SIM_MSP_H_
+#define SIM_MSP_H_
+
+#include "sim_hal.h"
+
+#endif /* SIM_MSP_H_ */
@@ -0,0 +1,27 @@
+/*
+ * sim.h
+ *
+ * Host simulation of the dashboard timing paths. Simulated time only moves when the harness
+ * calls simAdvance(), which runs the TIMER_A0 overflow and TIMER_A2 compare ISRs due on the way
+ * in time order, so the shared tach and shift modules see the same register sequence as on the part.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sim_hal.h"
+
+void TA0_0_IRQHandler(void);
+void TA0_N_IRQHandler(void);
+void TA2_0_IRQHandler(void);
+void TA2_N_IRQHandler(void);
+
+void simReset(void);
+uint64_t simNow(void);
+void simAdvance(uint64_t ns);
+void simTachEdge(void);
+
+#endif /* SIM_H_ */
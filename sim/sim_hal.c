@@ -0,0 +1,191 @@
+/*
+ * sim_hal.c
+ *
+ * Register storage, simulated time and the TIMER_A models for the host simulation, see sim.h.
+ */
+
+#include "sim.h"
+#include "clock.h"
+#include "timebase.h"
+
+Timer_A_Type simTimerA0;
+Timer_A_Type simTimerA2;
+NVIC_Type simNVIC;
+volatile uint8_t simP8OUT;
+uint8_t simPriorityMask;
+
+typedef struct
+{
+    Timer_A_Type *regs;
+    uint64_t startNs;           //sim time of the last TACLR
+} simTimer_t;
+
+static simTimer_t simTA0 = {&simTimerA0, 0};
+static simTimer_t simTA2 = {&simTimerA2, 0};
+static uint64_t simNowNs = 0;
+
+static uint64_t simTimerHz(const simTimer_t *timer)//counts per second after both dividers, 0 if stopped
+{
+    const Timer_A_Type *regs = timer->regs;
+    uint64_t source = (regs->CTL & TIMER_A_CTL_SSEL__SMCLK) ? CLOCK_SMCLK_HZ : CLOCK_ACLK_HZ;
+    uint64_t divider = (1u << ((regs->CTL & TIMER_A_CTL_ID_MASK) >> 6)) * ((regs->EX0 & TIMER_A_EX0_IDEX_MASK) + 1);
+
+    if(!(regs->CTL & TIMER_A_CTL_MC__CONTINUOUS))
+    {
+        return 0;
+    }
+    return source / divider;//every divider used here divides the clocks exactly
+}
+
+static uint64_t simTimerCount(const simTimer_t *timer, uint64_t ns)//unwrapped count at ns
+{
+    return (uint64_t)(((unsigned __int128)(ns - timer->startNs) * simTimerHz(timer)) / 1000000000u);
+}
+
+static uint64_t simTimerTime(const simTimer_t *timer, uint64_t count)//first ns at which the unwrapped count is reached
+{
+    unsigned __int128 scaled = (unsigned __int128)count * 1000000000u;
+    uint64_t hz = simTimerHz(timer);
+
+    return timer->startNs + (uint64_t)((scaled + hz - 1) / hz);
+}
+
+static void simTimerSync(simTimer_t *timer)//TACLR restarts the count, then TAR follows sim time
+{
+    if(timer->regs->CTL & TIMER_A_CTL_CLR)
+    {
+        timer->regs->CTL &= ~TIMER_A_CTL_CLR;
+        timer->startNs = simNowNs;
+    }
+    timer->regs->R = simTimerHz(timer) ? (uint16_t)simTimerCount(timer, simNowNs) : 0;
+}
+
+static void simSync(void)
+{
+    simTimerSync(&simTA0);
+    simTimerSync(&simTA2);
+}
+
+static bool simNextWrap(const simTimer_t *timer, uint64_t *ns)
+{
+    if(!simTimerHz(timer) || !(timer->regs->CTL & TIMER_A_CTL_IE))
+    {
+        return 0;
+    }
+    *ns = simTimerTime(timer, ((simTimerCount(timer, simNowNs) >> 16) + 1) << 16);
+    return 1;
+}
+
+static bool simNextCompare(const simTimer_t *timer, uint8_t ccr, uint64_t *ns)
+{
+    uint16_t cctl = timer->regs->CCTL[ccr];
+    uint64_t count;
+    uint64_t match;
+
+    if(!simTimerHz(timer) || !(cctl & TIMER_A_CCTLN_CCIE) || (cctl & TIMER_A_CCTLN_CAP))
+    {
+        return 0;
+    }
+    count = simTimerCount(timer, simNowNs);
+    match = (count & ~(uint64_t)0xFFFF) | timer->regs->CCR[ccr];
+    if(match <= count)
+    {
+        match += 0x10000;
+    }
+    *ns = simTimerTime(timer, match);
+    return 1;
+}
+
+void simReset(void)
+{
+    memset(&simTimerA0, 0, sizeof(simTimerA0));
+    memset(&simTimerA2, 0, sizeof(simTimerA2));
+    simTA0.startNs = 0;
+    simTA2.startNs = 0;
+    simNowNs = 0;
+    simP8OUT = 0;
+    simPriorityMask = 0;
+}
+
+uint64_t simNow(void)
+{
+    return simNowNs;
+}
+
+void simAdvance(uint64_t ns)//runs every timer interrupt due up to ns in time order, then moves sim time to ns
+{
+    enum {SIM_NONE, SIM_TA0_WRAP, SIM_TA2_CCR0, SIM_TA2_CCR1} next;
+    uint64_t due;
+    uint64_t at;
+
+    simSync();
+    while(1)
+    {
+        next = SIM_NONE;
+        due = ns;
+        if(simNextWrap(&simTA0, &at) && (at <= due))
+        {
+            next = SIM_TA0_WRAP;
+            due = at;
+        }
+        if(simNextCompare(&simTA2, 0, &at) && (at <= due))
+        {
+            next = SIM_TA2_CCR0;
+            due = at;
+        }
+        if(simNextCompare(&simTA2, 1, &at) && (at <= due))
+        {
+            next = SIM_TA2_CCR1;
+            due = at;
+        }
+        if(next == SIM_NONE)
+        {
+            break;
+        }
+
+        simNowNs = due;
+        simSync();
+        switch(next)
+        {
+        case SIM_TA0_WRAP:
+            simTimerA0.CTL |= TIMER_A_CTL_IFG;
+            simTimerA0.IV = 0x0E;
+            TA0_N_IRQHandler();
+            simTimerA0.CTL &= ~TIMER_A_CTL_IFG;//reading TA0IV clears it on the part
+            simTimerA0.IV = 0;
+            break;
+        case SIM_TA2_CCR0:
+            simTimerA2.CCTL[0] |= TIMER_A_CCTLN_CCIFG;
+            TA2_0_IRQHandler();
+            break;
+        default:
+            simTimerA2.CCTL[1] |= TIMER_A_CCTLN_CCIFG;
+            simTimerA2.IV = 0x02;
+            TA2_N_IRQHandler();
+            simTimerA2.IV = 0;
+            break;
+        }
+        simSync();
+    }
+    simNowNs = ns;
+    simSync();
+}
+
+void simTachEdge(void)//rising tach edge now, latched into CCR0 and handed to the capture ISR
+{
+    simSync();
+    simTimerA0.CCR[0] = simTimerA0.R;
+    simTimerA0.CCTL[0] |= TIMER_A_CCTLN_CCIFG;
+    TA0_0_IRQHandler();
+    simSync();
+}
+
+uint32_t micros(void)
+{
+    return (uint32_t)(simNowNs / 1000);
+}
+
+uint32_t millis(void)
+{
+    return (uint32_t)(simNowNs / 1000000);
+}
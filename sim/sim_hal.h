@@ -0,0 +1,108 @@
+/*
+ * sim_hal.h
+ *
+ * Host stand-ins for the MSP432 registers and driverlib calls used by the shared modules,
+ * pulled in by hal.h when SIM_HOST is defined. Registers are plain memory: the simulation
+ * (bench.c) writes the capture and counter values and calls the ISRs the way the NVIC would.
+ * Bit values match msp432p401r.h so the module code reads them the same way.
+ */
+
+#ifndef SIM_HAL_H_
+#define SIM_HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    volatile uint16_t CTL;
+    volatile uint16_t CCTL[7];
+    volatile uint16_t R;
+    volatile uint16_t CCR[7];
+    volatile uint16_t EX0;
+    volatile uint16_t IV;
+} Timer_A_Type;
+
+typedef struct
+{
+    volatile uint32_t ISER[2];
+} NVIC_Type;
+
+extern Timer_A_Type simTimerA0;
+extern Timer_A_Type simTimerA2;
+extern NVIC_Type simNVIC;
+extern volatile uint8_t simP8OUT;
+extern uint8_t simPriorityMask;
+
+#define TIMER_A0 (&simTimerA0)
+#define TIMER_A2 (&simTimerA2)
+#define NVIC (&simNVIC)
+#define P8OUT simP8OUT
+
+#define TA0_0_IRQn 8
+#define TA0_N_IRQn 9
+#define TA2_0_IRQn 12
+#define TA2_N_IRQn 13
+
+#define BIT0 0x01
+#define BIT1 0x02
+#define BIT2 0x04
+#define BIT3 0x08
+#define BIT4 0x10
+#define BIT5 0x20
+#define BIT6 0x40
+#define BIT7 0x80
+
+#define TIMER_A_CTL_IFG 0x0001
+#define TIMER_A_CTL_IE 0x0002
+#define TIMER_A_CTL_CLR 0x0004
+#define TIMER_A_CTL_MC__STOP 0x0000
+#define TIMER_A_CTL_MC__CONTINUOUS 0x0020
+#define TIMER_A_CTL_ID_MASK 0x00C0
+#define TIMER_A_CTL_ID__1 0x0000
+#define TIMER_A_CTL_ID__2 0x0040
+#define TIMER_A_CTL_ID__4 0x0080
+#define TIMER_A_CTL_ID__8 0x00C0
+#define TIMER_A_CTL_SSEL__ACLK 0x0100
+#define TIMER_A_CTL_SSEL__SMCLK 0x0200
+#define TIMER_A_EX0_IDEX_MASK 0x0007
+#define TIMER_A_EX0_IDEX__1 0x0000
+#define TIMER_A_EX0_IDEX__4 0x0003
+
+#define TIMER_A_CCTLN_CCIFG 0x0001
+#define TIMER_A_CCTLN_COV 0x0002
+#define TIMER_A_CCTLN_CCIE 0x0010
+#define TIMER_A_CCTLN_CAP 0x0100
+#define TIMER_A_CCTLN_SCS 0x0800
+#define TIMER_A_CCTLN_CCIS_0 0x0000
+#define TIMER_A_CCTLN_CM_1 0x4000
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+static inline bool PCM_gotoLPM0(void)
+{
+    return 1;
+}
+
+static inline uint8_t Interrupt_getPriorityMask(void)
+{
+    return simPriorityMask;
+}
+
+static inline void Interrupt_setPriorityMask(uint8_t mask)
+{
+    simPriorityMask = mask;
+}
+
+//rom_map.h names the module code calls, there is no ROM on the host
+#define MAP_PCM_gotoLPM0 PCM_gotoLPM0
+#define MAP_Interrupt_getPriorityMask Interrupt_getPriorityMask
+#define MAP_Interrupt_setPriorityMask Interrupt_setPriorityMask
+
+#endif /* SIM_HAL_H_ */
@@ -0,0 +1,22 @@
+/*
+ * spi_rate.h
+ *
+ * SPI bit rates for the eUSCI SPI masters, derived from the clock tree (clock.h) so a clock
+ * change carries through to every port. The eUSCI bit clock is BRCLK / UCBRx (UCBRx 0 and 1
+ * both pass BRCLK straight through), every port here runs from SMCLK, so the fastest rate is
+ * SMCLK itself and the next ones are SMCLK / 2, / 3 ...
+ * A rate that does not divide SMCLK evenly rounds down to the next rate that does, a rate above
+ * SPI_MAX_HZ gives SPI_MAX_HZ. SPI_BRW_AT() is the same for the idle SMCLK (clock.h).
+ */
+
+#ifndef SPI_RATE_H_
+#define SPI_RATE_H_
+
+#include "clock.h"
+
+#define SPI_MAX_HZ CLOCK_SMCLK_HZ
+#define SPI_BRW_AT(smclk, hz) ((uint16_t)(((smclk) + (hz) - 1) / (hz)))//UCBRx for the fastest rate not above hz
+#define SPI_BRW(hz) SPI_BRW_AT(CLOCK_SMCLK_HZ, (hz))
+#define SPI_ACTUAL_HZ(hz) (CLOCK_SMCLK_HZ / SPI_BRW(hz))
+
+#endif /* SPI_RATE_H_ */
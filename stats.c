@@ -0,0 +1,263 @@
+/*
+ * stats.c
+ *
+ * Incremental session summary, see stats.h.
+ */
+
+#include "stats.h"
+#include "fram.h"
+#include "crc.h"
+#include "shiftpoints.h"
+#include "timebase.h"
+#include "ramfunc.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define STATS_TICKS_PER_MS ((uint32_t)TACH_COUNT_HZ / 1000)
+#define STATS_TICKS_PER_US ((uint32_t)TACH_COUNT_HZ / 1000000)
+#define STATS_LATENCY_BIN_TICKS (STATS_TICKS_PER_MS * STATS_LATENCY_BIN_MS)
+
+typedef struct
+{
+    uint64_t session;               //tach ticks, the sums overflow 32 bits in ~6 minutes
+    uint64_t gear[METER_GEARS];
+    uint64_t aboveShift;
+    uint64_t bin[STATS_BINS];
+} statsTicks_t;
+
+static statsTicks_t statsTicks;//running session times
+static statsRecord_t statsRun;//running session shift counts, times filled in by statsSnapshot()
+static statsRecord_t statsLast;//session before this power up
+static uint8_t statsBlock[FRAM_HEADER_BYTES + sizeof(statsRecord_t)];//record on its way to the FRAM
+static volatile bool statsBlockDone = 1;//statsBlock is free, set by the FRAM driver
+static bool statsDirty = 0;//running session changed since it was last written
+static bool statsLastDirty = 0;//statsLast not copied to its slot yet
+static uint32_t statsLastTime = 0;//tach timestamp of the last sample
+static swTimer_t statsTimer;
+
+static uint32_t statsCrc(const statsRecord_t *record)
+{
+    return crcBlock(record, offsetof(statsRecord_t, crc));
+}
+
+static void statsSnapshot(statsRecord_t *record)//running session in ms
+{
+    uint8_t k;
+
+    memcpy(record, &statsRun, sizeof(statsRecord_t));
+    record->sessionMs = (uint32_t)(statsTicks.session / STATS_TICKS_PER_MS);
+    for(k = 0; k < METER_GEARS; k++)
+    {
+        record->gearMs[k] = (uint32_t)(statsTicks.gear[k] / STATS_TICKS_PER_MS);
+    }
+    record->aboveShiftMs = (uint32_t)(statsTicks.aboveShift / STATS_TICKS_PER_MS);
+    for(k = 0; k < STATS_BINS; k++)
+    {
+        record->binMs[k] = (uint32_t)(statsTicks.bin[k] / STATS_TICKS_PER_MS);
+    }
+    record->spare = 0;
+    record->crc = statsCrc(record);
+}
+
+static bool statsWrite(uint8_t slot, const statsRecord_t *record)//queues record from statsBlock, returns 0 if the FRAM queue is full
+{
+    memcpy(&statsBlock[FRAM_HEADER_BYTES], record, sizeof(statsRecord_t));
+    statsBlockDone = 0;
+    if(framWriteBlock(STATS_BASE + ((uint32_t)slot * STATS_SLOT_BYTES), statsBlock, sizeof(statsRecord_t), &statsBlockDone))
+    {
+        return 1;
+    }
+    statsBlockDone = 1;
+    return 0;
+}
+
+void statsRestore(void)//blocking read, a stored session that ran becomes the last session, call at start up
+{
+    statsRecord_t record;
+
+    framRead(STATS_BASE, (uint8_t *)&record, sizeof(statsRecord_t));
+    if((statsCrc(&record) == record.crc) && record.sessionMs)
+    {
+        memcpy(&statsLast, &record, sizeof(statsRecord_t));
+        statsLastDirty = 1;//the running session overwrites this slot
+        return;
+    }
+    framRead(STATS_BASE + STATS_SLOT_BYTES, (uint8_t *)&record, sizeof(statsRecord_t));
+    if(statsCrc(&record) == record.crc)
+    {
+        memcpy(&statsLast, &record, sizeof(statsRecord_t));
+    }
+}
+
+RAMFUNC void statsAdd(uint32_t timestamp, uint32_t period, uint8_t gear)//filtered tach period (tachFilter()), call for every edge
+{
+    uint32_t elapsed = timestamp - statsLastTime;
+    uint16_t rpm;
+    uint8_t bin;
+
+    statsLastTime = timestamp;
+    if(!period || (elapsed > STATS_GAP_TICKS) || (gear >= METER_GEARS))//first edge after a stall or no estimate
+    {
+        return;
+    }
+    rpm = tachCountToRPM(period);
+    bin = ((rpm / STATS_BIN_RPM) < STATS_BINS) ? (rpm / STATS_BIN_RPM) : (STATS_BINS - 1);
+    statsTicks.session += elapsed;
+    statsTicks.gear[gear] += elapsed;
+    statsTicks.bin[bin] += elapsed;
+    if(rpm >= shiftPointsTable()[gear].shiftRpm)
+    {
+        statsTicks.aboveShift += elapsed;
+    }
+    statsDirty = 1;
+    if(!swTimerActive(&statsTimer))
+    {
+        swTimerStart(&statsTimer, STATS_SAVE_MS, 0, statsService);
+    }
+}
+
+void statsShift(const shiftRecord_t *record)//finished shift from shiftPop()
+{
+    uint32_t us = record->latencyTicks / STATS_TICKS_PER_US;
+    uint32_t bin = record->latencyTicks / STATS_LATENCY_BIN_TICKS;
+    uint8_t dir = (record->dir == SHIFT_UP) ? SHIFT_UP : SHIFT_DOWN;
+
+    if(record->faulted)
+    {
+        statsRun.faults++;
+    }
+    else
+    {
+        if(dir == SHIFT_UP)
+        {
+            statsRun.upshifts++;
+        }
+        else
+        {
+            statsRun.downshifts++;
+        }
+        statsRun.latencySumUs[dir] += us;
+        statsRun.latencyBins[dir][(bin < STATS_LATENCY_BINS) ? bin : (STATS_LATENCY_BINS - 1)]++;
+        if(us > statsRun.worstUs[dir])
+        {
+            statsRun.worstUs[dir] = us;
+            statsRun.worstRpm[dir] = record->rpm;
+            statsRun.worstGear[dir] = record->gear;
+        }
+    }
+    statsDirty = 1;
+    if(!swTimerActive(&statsTimer))
+    {
+        swTimerStart(&statsTimer, STATS_SAVE_MS, 0, statsService);
+    }
+}
+
+void statsService(void)//writes the last session, then the running one, call on EVENT_FRAM_DONE, also run from statsTimer
+{
+    statsRecord_t record;
+
+    if(!statsBlockDone)
+    {
+        return;
+    }
+    if(statsLastDirty)
+    {
+        if(statsWrite(1, &statsLast))
+        {
+            statsLastDirty = 0;
+        }
+        return;//one record on the wire at a time, the next EVENT_FRAM_DONE brings us back
+    }
+    if(!statsDirty || swTimerActive(&statsTimer))
+    {
+        return;
+    }
+    statsSnapshot(&record);
+    if(statsWrite(0, &record))
+    {
+        statsDirty = 0;
+    }
+}
+
+static int statsEnd(char *text, int n, int size)//newline, truncating a line that did not fit
+{
+    if(n > (size - 2))
+    {
+        n = size - 2;
+    }
+    text[n++] = '\n';
+    return n;
+}
+
+int statsFormat(bool last, char *text, int size)//"SESSION <0|1> <ms> <ms in each gear> <ms above shift> <up> <down> <faults> <mean latency us>\n", returns the length
+{
+    statsRecord_t running;
+    const statsRecord_t *record = &statsLast;
+    uint16_t shifts;
+    int n;
+    uint8_t k;
+
+    if(!last)
+    {
+        statsSnapshot(&running);
+        record = &running;
+    }
+    shifts = record->upshifts + record->downshifts;
+    n = snprintf(text, size, "SESSION %u %lu", last, (unsigned long)record->sessionMs);
+    for(k = 0; (k < METER_GEARS) && (n < size); k++)
+    {
+        n += snprintf(&text[n], size - n, " %lu", (unsigned long)record->gearMs[k]);
+    }
+    if(n < size)
+    {
+        n += snprintf(&text[n], size - n, " %lu %u %u %u %lu", (unsigned long)record->aboveShiftMs, record->upshifts,
+                      record->downshifts, record->faults,
+                      shifts ? (unsigned long)((record->latencySumUs[SHIFT_UP] + record->latencySumUs[SHIFT_DOWN]) / shifts) : 0UL);
+    }
+    return statsEnd(text, n, size);
+}
+
+int statsFormatBins(bool last, char *text, int size)//"BINS <0|1> <ms in each STATS_BIN_RPM bin>\n", returns the length
+{
+    statsRecord_t running;
+    const statsRecord_t *record = &statsLast;
+    int n;
+    uint8_t k;
+
+    if(!last)
+    {
+        statsSnapshot(&running);
+        record = &running;
+    }
+    n = snprintf(text, size, "BINS %u", last);
+    for(k = 0; (k < STATS_BINS) && (n < size); k++)
+    {
+        n += snprintf(&text[n], size - n, " %lu", (unsigned long)record->binMs[k]);
+    }
+    return statsEnd(text, n, size);
+}
+
+int statsFormatLatency(bool last, shiftDir_t dir, char *text, int size)//"LATENCY <0|1> <0 up|1 down> <mean us> <worst us> <worst rpm> <worst gear> <shifts in each bin>\n", returns the length
+{
+    statsRecord_t running;
+    const statsRecord_t *record = &statsLast;
+    uint16_t shifts;
+    int n;
+    uint8_t k;
+
+    if(!last)
+    {
+        statsSnapshot(&running);
+        record = &running;
+    }
+    shifts = (dir == SHIFT_UP) ? record->upshifts : record->downshifts;
+    n = snprintf(text, size, "LATENCY %u %u %lu %lu %u %u", last, dir,
+                 shifts ? (unsigned long)(record->latencySumUs[dir] / shifts) : 0UL, (unsigned long)record->worstUs[dir],
+                 record->worstRpm[dir], record->worstGear[dir]);
+    for(k = 0; (k < STATS_LATENCY_BINS) && (n < size); k++)
+    {
+        n += snprintf(&text[n], size - n, " %u", record->latencyBins[dir][k]);
+    }
+    return statsEnd(text, n, size);
+}
@@ -0,0 +1,66 @@
+/*
+ * stats.h
+ *
+ * Per session summary, kept up to date as the samples arrive so it can be read over the download
+ * port ('A' and 'O', download.h) without pulling the telemetry trace. Every filtered tach sample
+ * adds the time since the one before to the session, to its gear, to its RPM histogram bin and,
+ * past the gear's shift point (shiftpoints.h), to the time above the shift point: a few adds and
+ * one divide per sample, whatever the session length. Gaps longer than STATS_GAP_MS (a stall)
+ * are not counted. Finished shifts add to the shift counts and, per direction, to the latency sum,
+ * a STATS_LATENCY_BIN_MS wide latency histogram and the worst latency with its RPM and gear,
+ * all from the edge to edge latency in tach ticks (shift.h).
+ * A session runs from power up. The running session is written to the FRAM every STATS_SAVE_MS
+ * while it changes; at power up a stored session that saw the engine run becomes the last
+ * session and is copied to its own slot before the new one is first saved.
+ * Times are tach ticks in SRAM and ms in the FRAM record and the replies.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "checkpoint.h"
+#include "meter.h"
+#include "shift.h"
+
+//Stats settings
+#define STATS_BYTES 0x200
+#define STATS_BASE (CHECKPOINT_BASE - STATS_BYTES)//top telemetry blocks, below the checkpoints
+#define STATS_SLOT_BYTES 0x100      //running session, then the last session
+#define STATS_BINS 16               //RPM histogram bins, the last one takes everything above
+#define STATS_BIN_RPM 1000
+#define STATS_LATENCY_BINS 16       //shift latency histogram bins per direction, the last one takes everything above
+#define STATS_LATENCY_BIN_MS 10
+#define STATS_GAP_MS 100            //longer sample gaps are not session time
+#define STATS_SAVE_MS 10000         //running session written at most this often
+
+#define STATS_GAP_TICKS ((uint32_t)TACH_COUNT_HZ / 1000 * STATS_GAP_MS)
+
+typedef struct
+{
+    uint32_t sessionMs;             //engine turning
+    uint32_t gearMs[METER_GEARS];   //by gearIndex
+    uint32_t aboveShiftMs;          //at or past the shift point of the gear
+    uint32_t binMs[STATS_BINS];     //STATS_BIN_RPM wide from 0 RPM
+    uint16_t upshifts;              //finished shifts
+    uint16_t downshifts;
+    uint16_t faults;                //shifts that gave up
+    uint16_t spare;
+    uint32_t latencySumUs[2];       //paddle to hall effect over every finished shift, by shiftDir_t
+    uint32_t worstUs[2];            //slowest finished shift
+    uint16_t worstRpm[2];           //RPM and gearIndex at its paddle
+    uint8_t worstGear[2];
+    uint16_t latencyBins[2][STATS_LATENCY_BINS];//finished shifts, STATS_LATENCY_BIN_MS wide from 0
+    uint32_t crc;                   //CRC32 of everything before it
+} statsRecord_t;
+
+void statsRestore(void);
+void statsAdd(uint32_t timestamp, uint32_t period, uint8_t gear);
+void statsShift(const shiftRecord_t *record);
+void statsService(void);
+int statsFormat(bool last, char *text, int size);
+int statsFormatBins(bool last, char *text, int size);
+int statsFormatLatency(bool last, shiftDir_t dir, char *text, int size);
+
+#endif /* STATS_H_ */
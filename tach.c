@@ -0,0 +1,236 @@
+/*
+ * tach.c
+ *
+ * TIMER_A0 period measurement for the tach signal, see tach.h.
+ */
+
+#include "hal.h"
+#include "tach.h"
+#include "events.h"
+#include "profile.h"
+#include "ramfunc.h"
+
+#define TACH_DOWN_COUNT TACH_RPM_TO_COUNT(TACH_RANGE_DOWN_RPM)                      //fast range ticks
+#define TACH_UP_COUNT (TACH_RPM_TO_COUNT(TACH_RANGE_UP_RPM) / TACH_SLOW_RATIO)      //slow range ticks
+#define TACH_STALL_COUNT TACH_RPM_TO_COUNT(TACH_MIN_RPM)                             //fast range ticks
+
+#if TACH_COMP_ENABLE
+#define TACH_CCR 1                  //C0OUT on CCI1B
+#define TACH_CCIS TIMER_A_CCTLN_CCIS_1
+#else
+#define TACH_CCR 0                  //P7.3 on CCI0A
+#define TACH_CCIS TIMER_A_CCTLN_CCIS_0
+#endif
+
+static volatile uint16_t tachOverflows = 0;//TIMER_A0 wraps, upper 16 bits of the extended timer
+static volatile uint32_t tachLastCapture = 0;//extended timer value at the previous edge
+static volatile uint32_t tachEpoch = 0;//TACH_COUNT_HZ timestamp of the last timer restart
+static volatile tachSample_t tachRing[TACH_RING_SIZE];
+static volatile uint8_t tachHead = 0;//only written by TA0_0_IRQHandler
+static volatile uint8_t tachTail = 0;//only written by tachPop()
+static volatile uint16_t tachDropCount = 0;//samples lost to a full ring
+static volatile bool tachSlowFlag = 0;
+static volatile bool tachBaselineFlag = 1;//next edge only starts a new period (after init, a range switch or a stall)
+static volatile bool tachStallFlag = 0;//EVENT_STALL posted, the next edge posts EVENT_TACH even without a period
+static bool tachIdleClock = 0;//SMCLK at CLOCK_IDLE_SMCLK_HZ, the ID dividers are halved
+
+static RAMFUNC void tachSetRange(bool slow)//restarts TIMER_A0 with the fast or slow prescaler
+{
+    TIMER_A0->CTL = TIMER_A_CTL_SSEL__SMCLK |  // Use SMCLK as clock source,
+            (slow ? (tachIdleClock ? TIMER_A_CTL_ID__4 : TIMER_A_CTL_ID__8) : (tachIdleClock ? TIMER_A_CTL_ID__1 : TIMER_A_CTL_ID__2)) |
+            TIMER_A_CTL_MC__STOP;
+    TIMER_A0->EX0 = slow ? TIMER_A_EX0_IDEX__4 : TIMER_A_EX0_IDEX__1;
+    TIMER_A0->CTL |= TIMER_A_CTL_CLR |          // TACLR is required for a divider change to take effect
+            TIMER_A_CTL_IE |                    // Overflow interrupt extends the count to 32 bits
+            TIMER_A_CTL_MC__CONTINUOUS;         // Free-running, never reset by software
+
+    tachOverflows = 0;
+    tachLastCapture = 0;
+    tachSlowFlag = slow;
+    tachBaselineFlag = 1;//old captures are in the old time base
+}
+
+#if TACH_COMP_ENABLE
+static void tachCompInit(void)//COMP_E0 from the tach on TACH_COMP_INPUT against the Vcc ladder, output to TIMER_A0 CCI1B
+{
+    const COMP_E_Config config =
+    {
+        TACH_COMP_INPUT,
+        COMP_E_VREF,                        //ladder on the - terminal
+        TACH_COMP_FILTER,
+        COMP_E_NORMALOUTPUTPOLARITY,        //rising tach, rising C0OUT
+        COMP_E_HIGH_SPEED_MODE              //shortest propagation delay, the capture sees it as a fixed offset
+    };
+
+    MAP_COMP_E_initModule(COMP_E0_BASE, &config);
+    MAP_COMP_E_setReferenceVoltage(COMP_E0_BASE, COMP_E_REFERENCE_AMPLIFIER_DISABLED, TACH_COMP_LOW_32, TACH_COMP_HIGH_32);//Vcc ladder, the output picks the tap
+    MAP_COMP_E_disableInputBuffer(COMP_E0_BASE, TACH_COMP_INPUT);//analog pin
+    MAP_COMP_E_enableModule(COMP_E0_BASE);
+}
+#endif
+
+void tachInit(void)//configures TIMER_A0 to capture rising edges of the tach signal, on P7.3 or through COMP_E0
+{
+#if TACH_COMP_ENABLE
+    tachCompInit();
+#endif
+    TIMER_A0->CCTL[TACH_CCR] = TIMER_A_CCTLN_CM_1 | // Capture rising edge,
+            TACH_CCIS |                     // Use CCI0A (P7.3) or CCI1B (C0OUT),
+            TIMER_A_CCTLN_CCIE |            // Enable capture interrupt
+            TIMER_A_CCTLN_CAP |             // Enable capture mode,
+            TIMER_A_CCTLN_SCS;              // Synchronous capture
+
+    tachSetRange(1);//engine is stopped or cranking at power up
+
+#if !TACH_COMP_ENABLE
+    NVIC->ISER[0] = 1 << ((TA0_0_IRQn) & 31);
+#endif
+    NVIC->ISER[0] = 1 << ((TA0_N_IRQn) & 31);//overflow, and the capture through COMP_E0
+}
+
+bool tachPop(tachSample_t *sample)//takes the oldest edge out of the ring, returns 0 if it is empty
+{
+    uint8_t tail = tachTail;
+
+    if(tail == tachHead)
+    {
+        return 0;
+    }
+    sample->timestamp = tachRing[tail].timestamp;
+    sample->period = tachRing[tail].period;
+    tachTail = (tail + 1) & (TACH_RING_SIZE - 1);//release the slot only after it has been copied
+    return 1;
+}
+
+RAMFUNC uint32_t tachNow(void)//current time in the sample timestamp base, also stamps events and input edges from the ISRs
+{
+    uint32_t epoch;
+    uint16_t overflows;
+    uint16_t count;
+    bool slow;
+    bool wrapped;
+    uint32_t now;
+
+    do{//TA0 ISRs can run between the reads, start over if one did
+        epoch = tachEpoch;
+        overflows = tachOverflows;
+        slow = tachSlowFlag;
+        count = TIMER_A0->R;
+        wrapped = (TIMER_A0->CTL & TIMER_A_CTL_IFG) && (count < 0x8000);//wrapped, TA0_N still pending
+    } while((epoch != tachEpoch) || (slow != tachSlowFlag) || (overflows != tachOverflows));
+
+    now = ((uint32_t)(overflows + wrapped) << 16) | count;
+    return epoch + (slow ? (now * TACH_SLOW_RATIO) : now);
+}
+
+void tachSetClock(uint32_t smclk)//keeps TACH_COUNT_HZ across an SMCLK change, call right after it with interrupts off (power.c)
+{
+    uint32_t now = tachNow();//the few ticks since the switch were counted at the new SMCLK, microseconds off
+
+    tachIdleClock = (smclk != TACH_TIMER_CLOCK_HZ);
+    tachSetRange(tachSlowFlag);
+    tachEpoch = now;
+}
+
+uint16_t tachDropped(void)//number of edges lost because the main loop fell more than TACH_RING_SIZE edges behind
+{
+    return tachDropCount;
+}
+
+static RAMFUNC void tachPush(uint32_t timestamp, uint32_t period)//producer side of the ring, only called from TA0_0_IRQHandler
+{
+    uint8_t head = tachHead;
+    uint8_t next = (head + 1) & (TACH_RING_SIZE - 1);
+
+    if(next == tachTail)//full, keep the older samples so the consumer sees a continuous run
+    {
+        tachDropCount++;
+        return;
+    }
+    tachRing[head].timestamp = timestamp;
+    tachRing[head].period = period;
+    tachHead = next;//publish only after the sample is written
+    eventPost(EVENT_TACH);
+}
+
+static RAMFUNC void tachCapture(void)//tach edge latched in CCR[TACH_CCR], from the capture ISR
+{
+    PROFILE_BEGIN(PROF_TACH_ISR);
+    uint16_t capture = TIMER_A0->CCR[TACH_CCR];
+    uint16_t overflows = tachOverflows;
+    uint32_t now;
+    uint32_t delta;
+    uint32_t timestamp;
+
+    TIMER_A0->CCTL[TACH_CCR] &= ~(TIMER_A_CCTLN_CCIFG | TIMER_A_CCTLN_COV);// Clear the interrupt flag
+
+    if(TIMER_A0->CTL & TIMER_A_CTL_IFG){//timer wrapped but TA0_N has not run yet, count it here
+        TIMER_A0->CTL &= ~TIMER_A_CTL_IFG;
+        tachOverflows++;
+        if(capture < 0x8000){//edge came after the wrap
+            overflows++;
+        }
+    }
+
+    now = ((uint32_t)overflows << 16) | capture;
+    delta = now - tachLastCapture;
+    tachLastCapture = now;
+    timestamp = tachEpoch + (tachSlowFlag ? (now * TACH_SLOW_RATIO) : now);
+
+    if(tachStallFlag){//first edge after a stall, wake the main loop now, not one period later
+        tachStallFlag = 0;
+        eventPost(EVENT_TACH);
+    }
+    if(tachBaselineFlag){//no valid previous edge to measure from
+        tachBaselineFlag = 0;
+        PROFILE_END(PROF_TACH_ISR);
+        return;
+    }
+
+    if(tachSlowFlag){
+        tachPush(timestamp, delta * TACH_SLOW_RATIO);
+        if(delta < TACH_UP_COUNT){//fast enough for the high resolution range
+            tachSetRange(0);
+            tachEpoch = timestamp;//new time base starts at this edge
+        }
+    }
+    else{
+        tachPush(timestamp, delta);
+        if(delta > TACH_DOWN_COUNT){//slow enough that overflows would dominate
+            tachSetRange(1);
+            tachEpoch = timestamp;
+        }
+    }
+    PROFILE_END(PROF_TACH_ISR);
+}
+
+RAMFUNC void TA0_0_IRQHandler(void)//Interrupt based on input from ECU tach signal
+{
+    tachCapture();
+}
+
+RAMFUNC void TA0_N_IRQHandler(void)//TIMER_A0 overflow, extends the capture timer to 32 bits, and the COMP_E0 capture
+{
+    uint32_t idle;
+
+    switch(TIMER_A0->IV){//reading IV clears the flag it returns, another pending one interrupts again
+    case 0x02://CCR1
+#if TACH_COMP_ENABLE
+        tachCapture();
+#endif
+        break;
+    case 0x0E://TAIFG
+        tachOverflows++;
+        idle = ((uint32_t)tachOverflows << 16) - tachLastCapture;//timer ticks since the last edge
+        if(idle > (tachSlowFlag ? (TACH_STALL_COUNT / TACH_SLOW_RATIO) : TACH_STALL_COUNT)){//engine stopped, a period across the stall would be garbage
+            tachBaselineFlag = 1;
+            if(!tachStallFlag){
+                tachStallFlag = 1;
+                eventPost(EVENT_STALL);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
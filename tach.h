@@ -0,0 +1,83 @@
+/*
+ * tach.h
+ *
+ * Tachometer signal from the PE3 ECU on P7.3 (TIMER_A0 CCI0A), or through COMP_E0 (below).
+ * TIMER_A0 free-runs and is extended to 32 bits by its overflow interrupt, the period is the
+ * difference between successive captures so no counts are lost to a software reset.
+ * The prescaler switches between a fast range for resolution at high RPM and a slow range that
+ * keeps overflow interrupts rare while cranking. Periods are always reported in TACH_COUNT_HZ ticks,
+ * also on the idle SMCLK (tachSetClock()).
+ * With TACH_COMP_ENABLE the signal goes through COMP_E0 first: the resistor ladder gives it
+ * TACH_COMP_LOW_32 / TACH_COMP_HIGH_32 hysteresis and the output filter swallows spikes shorter
+ * than its delay, so ignition noise never reaches the timer. C0OUT is internally wired to
+ * TIMER_A0 CCI1B, the capture then moves to CCR1 and its interrupt to TA0_N, the analog input
+ * is a C0 pin instead of P7.3. tachFilter() (tach_filter.h) still rejects what gets through,
+ * glitches longer than the filter delay, either way.
+ * Every edge is pushed into a single producer (capture ISR) / single consumer (main loop) ring
+ * buffer with its timestamp, so no edge is lost between main loop passes and no interrupt
+ * disabling is needed on either side.
+ * The capture stays an interrupt per edge, a DMA copy of the captures cannot be had without a
+ * loss: TIMER_A0 only triggers DMA from CCR0 (channel 0, USB TX) and CCR2 (channel 1, the only
+ * EUSCI_A0 RX channel), the other timers' triggers land on the FRAM, lightstrip, CRC and ECU
+ * channels (dma_table.h), and a capture ring read in batches still has to drop the edges that
+ * straddle a range restart.
+ * Capture count to RPM conversion is done in integer math with every constant folded
+ * at compile time, so a conversion is one hardware divide.
+ */
+
+#ifndef TACH_H_
+#define TACH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "clock.h"
+
+//Tach settings
+#define TACH_PULSES_PER_REV 8       //set in the ECU settings on the PE3 (tach pulses per rev in Engine Setup)
+#define TACH_TIMER_CLOCK_HZ CLOCK_SMCLK_HZ//SMCLK into TIMER_A0
+#define TACH_FAST_DIVIDER 2         //ID /2, EX0 /1, 12 MHz
+#define TACH_SLOW_DIVIDER 32        //ID /8, EX0 /4, 750 kHz
+                                    //both ID halved on the idle SMCLK (clock.h), tachSetClock()
+#define TACH_SLOW_RATIO (TACH_SLOW_DIVIDER / TACH_FAST_DIVIDER)
+#define TACH_COUNT_HZ (TACH_TIMER_CLOCK_HZ / TACH_FAST_DIVIDER)
+
+#define TACH_RANGE_DOWN_RPM 1200    //switch to the slow range below this
+#define TACH_RANGE_UP_RPM 2400      //switch back to the fast range above this
+#define TACH_MIN_RPM 100            //longer periods than this are treated as a stopped engine
+#define TACH_RING_SIZE 32           //samples, power of 2, 20 ms of edges at MAX_RPM
+
+//Comparator front end, 1 takes the tach through COMP_E0 instead of straight into P7.3
+#define TACH_COMP_ENABLE 0
+#define TACH_COMP_INPUT COMP_E_INPUT4//C0.4 on P7.5, the tach has to be wired there instead of P7.3
+#define TACH_COMP_LOW_32 12         //falling threshold, Vcc * 12 / 32 = 1.24 V
+#define TACH_COMP_HIGH_32 20        //rising threshold, Vcc * 20 / 32 = 2.06 V
+#define TACH_COMP_FILTER COMP_E_FILTEROUTPUT_DLYLVL4//longest analog output filter, a few us (datasheet)
+
+//RPM = (timer counts per second * 60 seconds per minute) / (counts per pulse * pulses per revolution)
+#define TACH_RPM_NUMERATOR ((uint32_t)(((uint64_t)TACH_COUNT_HZ * 60) / TACH_PULSES_PER_REV))
+#define TACH_RPM_TO_COUNT(rpm) (TACH_RPM_NUMERATOR / (rpm))
+
+typedef struct
+{
+    uint32_t timestamp;             //TACH_COUNT_HZ ticks, wraps every ~358 s so only use differences
+    uint32_t period;                //TACH_COUNT_HZ ticks since the previous edge
+} tachSample_t;
+
+void tachInit(void);
+bool tachPop(tachSample_t *sample);
+uint32_t tachNow(void);
+uint16_t tachDropped(void);
+void tachSetClock(uint32_t smclk);
+
+static inline uint16_t tachCountToRPM(uint32_t count)//converts timer counts per tach pulse to RPM, 0 for no/invalid count
+{
+    uint32_t rpm;
+
+    if(!count){//Error value would not work in calculation
+        return 0;
+    }
+    rpm = TACH_RPM_NUMERATOR / count;
+    return (rpm > 0xFFFF) ? 0xFFFF : (uint16_t)rpm;
+}
+
+#endif /* TACH_H_ */
@@ -0,0 +1,132 @@
+/*
+ * tach_filter.c
+ *
+ * Median glitch rejection, revolution and IIR filtering of tach periods, see tach_filter.h.
+ */
+
+#include "tach_filter.h"
+#include <stdbool.h>
+
+#if (TACH_MEDIAN_DEPTH < 1) || ((TACH_MEDIAN_DEPTH & 1) == 0)
+#error "TACH_MEDIAN_DEPTH must be odd"
+#endif
+
+#if TACH_MEDIAN_DEPTH > 1
+static uint32_t tfHistory[TACH_MEDIAN_DEPTH];//last N raw periods
+static uint8_t tfIndex = 0;
+static uint8_t tfCount = 0;
+#endif
+#if TACH_REV_PULSES > 1
+static uint32_t tfRev[TACH_REV_PULSES];//last revolution of raw periods, glitches replaced by the median
+static uint32_t tfRevSum = 0;//sum of the tfRevCount stored
+static uint8_t tfRevIndex = 0;
+static uint8_t tfRevCount = 0;
+#endif
+#if TACH_IIR_SHIFT > 0
+static int32_t tfIIR = 0;//filtered period with TACH_IIR_FRAC fraction bits
+#endif
+static uint32_t tfLastTimestamp = 0;
+static bool tfPrimed = 0;
+
+void tachFilterReset(void)//forgets all history, the next sample passes straight through
+{
+#if TACH_MEDIAN_DEPTH > 1
+    tfIndex = 0;
+    tfCount = 0;
+#endif
+#if TACH_REV_PULSES > 1
+    tfRevSum = 0;
+    tfRevIndex = 0;
+    tfRevCount = 0;
+#endif
+    tfPrimed = 0;
+}
+
+#if TACH_MEDIAN_DEPTH > 1
+static uint32_t tachMedian(uint32_t period)//adds period to the history and returns the median of what is stored
+{
+    uint32_t sorted[TACH_MEDIAN_DEPTH];
+    uint32_t value;
+    uint8_t k;
+    uint8_t j;
+
+    tfHistory[tfIndex] = period;
+    tfIndex = (tfIndex + 1) % TACH_MEDIAN_DEPTH;
+    if(tfCount < TACH_MEDIAN_DEPTH)
+    {
+        tfCount++;
+    }
+
+    for(k = 0; k < tfCount; k++)//insertion sort, N is tiny
+    {
+        value = tfHistory[k];
+        for(j = k; (j > 0) && (sorted[j - 1] > value); j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return sorted[tfCount / 2];
+}
+#endif
+
+#if TACH_REV_PULSES > 1
+static uint32_t tachRevolution(uint32_t period)//adds period to the revolution and returns the mean period over what is stored
+{
+    if(tfRevCount < TACH_REV_PULSES)
+    {
+        tfRevCount++;
+    }
+    else
+    {
+        tfRevSum -= tfRev[tfRevIndex];//oldest, the slot it leaves
+    }
+    tfRev[tfRevIndex] = period;
+    tfRevSum += period;
+    tfRevIndex = (tfRevIndex + 1) % TACH_REV_PULSES;
+    return (tfRevCount == TACH_REV_PULSES) ? (tfRevSum / TACH_REV_PULSES) : (tfRevSum / tfRevCount);//constant divide once full
+}
+#endif
+
+uint32_t tachFilter(const tachSample_t *sample)//runs one tach sample through the pipeline and returns the filtered period
+{
+    uint32_t period = sample->period;
+#if TACH_MEDIAN_DEPTH > 1
+    uint32_t median;
+#endif
+
+    //samples are contiguous when the timestamp step equals the period, anything much longer
+    //means a stall or dropped edges and the old history no longer applies
+    if(tfPrimed && ((sample->timestamp - tfLastTimestamp) > (period + (period >> 1))))
+    {
+        tachFilterReset();
+    }
+    tfLastTimestamp = sample->timestamp;
+
+#if TACH_MEDIAN_DEPTH > 1
+    median = tachMedian(period);
+    if(((period > median) ? (period - median) : (median - period)) > (median >> TACH_GLITCH_SHIFT))//missed or doubled pulse
+    {
+        period = median;
+    }
+#endif
+
+#if TACH_REV_PULSES > 1
+    period = tachRevolution(period);
+#endif
+
+#if TACH_IIR_SHIFT > 0
+    if(!tfPrimed)
+    {
+        tfIIR = (int32_t)(period << TACH_IIR_FRAC);
+    }
+    else
+    {
+        tfIIR += ((int32_t)(period << TACH_IIR_FRAC) - tfIIR) >> TACH_IIR_SHIFT;
+    }
+    period = (uint32_t)tfIIR >> TACH_IIR_FRAC;
+#endif
+
+    tfPrimed = 1;
+    return period;
+}
@@ -0,0 +1,36 @@
+/*
+ * tach_filter.h
+ *
+ * Filter pipeline between the tach capture ring and the display. Periods first go through a
+ * median-of-N glitch rejector: a raw period more than 1/2^TACH_GLITCH_SHIFT away from the
+ * median of the last N is replaced by that median, so a single missed or doubled pulse from the
+ * PE3 never reaches the output. Then a rolling sum of the last TACH_REV_PULSES raw periods, one
+ * engine revolution, and then a fixed-point first order IIR for ignition noise jitter.
+ * The revolution stage takes out the trigger wheel tooth spacing and the firing imbalance
+ * between cylinders, which repeat every revolution, at the cost of one add and one subtract per
+ * edge (the ring keeps the sum, the divide is by a constant). The median only gates what goes
+ * into the sum, so a tooth that is always short within the glitch window still adds its true
+ * period and the revolution reads exact once it is full.
+ *
+ * Latency is (TACH_MEDIAN_DEPTH - 1) / 2 periods for the median, (TACH_REV_PULSES - 1) / 2 for
+ * the revolution and (2^TACH_IIR_SHIFT - 1) periods for the IIR, half a revolution with the
+ * defaults.
+ */
+
+#ifndef TACH_FILTER_H_
+#define TACH_FILTER_H_
+
+#include <stdint.h>
+#include "tach.h"
+
+//Filter settings
+#define TACH_MEDIAN_DEPTH 3         //odd, 1 disables the median stage
+#define TACH_GLITCH_SHIFT 2         //a raw period off the median by more than median / 2^shift is a glitch, above any tooth error
+#define TACH_REV_PULSES TACH_PULSES_PER_REV//periods summed by the revolution stage, 1 disables it
+#define TACH_IIR_SHIFT 0            //IIR weight of a new sample is 1/2^shift, 0 disables the IIR stage
+#define TACH_IIR_FRAC 4             //fraction bits kept in the IIR state
+
+void tachFilterReset(void);
+uint32_t tachFilter(const tachSample_t *sample);
+
+#endif /* TACH_FILTER_H_ */
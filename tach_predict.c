@@ -0,0 +1,85 @@
+/*
+ * tach_predict.c
+ *
+ * Linear RPM extrapolation of the filtered tach period, see tach_predict.h.
+ */
+
+#include "tach_predict.h"
+#include "tach_filter.h"
+#include "ramfunc.h"
+#include <stdbool.h>
+
+#if (TACH_PREDICT_SPAN & (TACH_PREDICT_SPAN - 1)) != 0
+#error "TACH_PREDICT_SPAN must be a power of 2"
+#endif
+
+//the filtered period describes the engine this many periods before its edge
+#define TACH_FILTER_LAG (((TACH_MEDIAN_DEPTH - 1) / 2) + ((1 << TACH_IIR_SHIFT) - 1))
+
+typedef struct
+{
+    uint32_t timestamp;
+    uint16_t rpm;
+} tpPoint_t;
+
+static tpPoint_t tpHistory[TACH_PREDICT_SPAN + 1];//newest sample and the one TACH_PREDICT_SPAN before it, as a ring
+static uint8_t tpIndex = 0;//slot of the newest sample
+static uint8_t tpCount = 0;
+static uint32_t tpPeriod = 0;//newest filtered period
+
+void tachPredictReset(void)//forgets the slope, tachPredict() passes the period through until the history refills
+{
+    tpCount = 0;
+}
+
+void tachPredictAdd(uint32_t timestamp, uint32_t period)//newest filtered period and the timestamp of the edge that ended it
+{
+    //same contiguity test as the filter, a stall or dropped edges break the slope
+    if(tpCount && ((timestamp - tpHistory[tpIndex].timestamp) > (period + (period >> 1))))
+    {
+        tachPredictReset();
+    }
+    tpIndex = (tpIndex + 1) % (TACH_PREDICT_SPAN + 1);
+    tpHistory[tpIndex].timestamp = timestamp;
+    tpHistory[tpIndex].rpm = tachCountToRPM(period);
+    if(tpCount <= TACH_PREDICT_SPAN)
+    {
+        tpCount++;
+    }
+    tpPeriod = period;
+}
+
+RAMFUNC uint32_t tachPredict(uint32_t now)//period the engine will be at when a frame started at now (tach timestamp) latches
+{
+    const tpPoint_t *newest = &tpHistory[tpIndex];
+    const tpPoint_t *oldest = &tpHistory[(tpIndex + 1) % (TACH_PREDICT_SPAN + 1)];
+    int32_t delta;
+    uint32_t span;
+    uint32_t horizon;
+    int32_t rpm;
+
+    if(tpCount <= TACH_PREDICT_SPAN)//no slope yet
+    {
+        return tpPeriod;
+    }
+    delta = (int32_t)newest->rpm - oldest->rpm;
+    if((delta > TACH_PREDICT_MAX_DELTA) || (delta < -TACH_PREDICT_MAX_DELTA))
+    {
+        return tpPeriod;
+    }
+    span = newest->timestamp - oldest->timestamp;
+
+    //time from the moment the filtered value describes to the moment the frame latches
+    horizon = (now - newest->timestamp) + (TACH_FILTER_LAG * tpPeriod) + TACH_PREDICT_LATCH_TICKS;
+    if(horizon > TACH_PREDICT_MAX_HORIZON)
+    {
+        horizon = TACH_PREDICT_MAX_HORIZON;
+    }
+
+    rpm = newest->rpm + (delta * (int32_t)horizon) / (int32_t)span;
+    if(rpm < TACH_MIN_RPM)
+    {
+        return 0;//meterLeds() treats 0 as no reading
+    }
+    return TACH_RPM_TO_COUNT((uint32_t)rpm);
+}
@@ -0,0 +1,34 @@
+/*
+ * tach_predict.h
+ *
+ * RPM extrapolation for the lightstrip. A frame is rendered after a tach edge has made it through
+ * the filter (tach_filter.h) and is only latched by the LEDs once it has been shifted out, so the
+ * meter shows the engine as it was one filter lag plus the transmit time ago. The predictor
+ * measures the RPM slope over the last TACH_PREDICT_SPAN filtered samples and extrapolates it to
+ * the moment the frame latches, which puts the shift lights on time on a fast pull.
+ *
+ * All RPM math is 32 bit, the slope and horizon clamps below keep the product in range.
+ * No hardware access, the caller supplies the age of the newest sample (tachNow()).
+ */
+
+#ifndef TACH_PREDICT_H_
+#define TACH_PREDICT_H_
+
+#include <stdint.h>
+#include "tach.h"
+#include "lightstrip.h"
+#include "spi_rate.h"
+
+//Prediction settings
+#define TACH_PREDICT_SPAN 4                                 //samples the slope is measured over, power of 2
+#define TACH_PREDICT_LATCH_US (((LS_FRAME_BYTES * 8 * 1000000UL) / SPI_ACTUAL_HZ(LS_SPI_HZ)) + 20)//whole frame shift out plus DMA start, check with the HIL test (hil.h)
+#define TACH_PREDICT_MAX_DELTA 8000                         //RPM change over the span, more is a glitch and not extrapolated
+#define TACH_PREDICT_MAX_HORIZON (TACH_COUNT_HZ / 50)       //20 ms, never extrapolate further than this
+
+#define TACH_PREDICT_LATCH_TICKS ((uint32_t)(((uint64_t)TACH_COUNT_HZ * TACH_PREDICT_LATCH_US) / 1000000))
+
+void tachPredictReset(void);
+void tachPredictAdd(uint32_t timestamp, uint32_t period);
+uint32_t tachPredict(uint32_t now);
+
+#endif /* TACH_PREDICT_H_ */
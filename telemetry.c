@@ -0,0 +1,218 @@
+/*
+ * telemetry.c
+ *
+ * Block batched, delta encoded RPM trace logging to the FRAM, see telemetry.h.
+ * Everything here runs in the main loop, which is also the only user of the CRC32 module.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "telemetry.h"
+#include "timebase.h"
+#include "wheel.h"
+#include "crc.h"
+#include "logscan.h"
+#include "rtc.h"
+#include "ecu.h"
+
+typedef enum
+{
+    TELEM_FREE,
+    TELEM_FILLING,
+    TELEM_FULL,                     //waiting for the FRAM
+    TELEM_WRITING                   //on the wire, must not be touched
+} telemState_t;
+
+static uint8_t telemBuffer[2][FRAM_HEADER_BYTES + TELEM_BLOCK_BYTES];
+static telemState_t telemState[2] = {TELEM_FILLING, TELEM_FREE};
+static volatile bool telemDone[2] = {0, 0};//set by the FRAM driver when a TELEM_WRITING block is out
+static uint8_t telemFill = 0;//buffer being filled
+static uint16_t telemCount = 0;//samples in the buffer being filled
+static uint16_t telemUsed = 0;//payload bytes used in the buffer being filled
+static uint32_t telemLastTime = 0;//last sample written, for the differences
+static uint16_t telemLastRpm = 0;
+static uint16_t telemIdleCount = 0;//telemCount at the last telemetryTick()
+static uint16_t telemSlot = 0;//next FRAM block to write
+static uint32_t telemSequence = 0;
+static uint32_t telemStored = 0;//valid blocks in the FRAM
+
+static void telemPut16(uint8_t *to, uint16_t value)
+{
+    to[0] = value;
+    to[1] = value >> 8;
+}
+
+static void telemPut32(uint8_t *to, uint32_t value)
+{
+    telemPut16(to, value);
+    telemPut16(to + 2, value >> 16);
+}
+
+static void telemPut64(uint8_t *to, uint64_t value)
+{
+    telemPut32(to, value);
+    telemPut32(to + 4, value >> 32);
+}
+
+static uint32_t telemGet32(const uint8_t *from)
+{
+    return from[0] | ((uint32_t)from[1] << 8) | ((uint32_t)from[2] << 16) | ((uint32_t)from[3] << 24);
+}
+
+static uint16_t telemGet16(const uint8_t *from)
+{
+    return from[0] | (from[1] << 8);
+}
+
+static uint8_t telemVarint(uint8_t *to, uint32_t value)//returns the bytes written
+{
+    uint8_t n = 0;
+
+    while(value > 0x7F)
+    {
+        to[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    to[n++] = value;
+    return n;
+}
+
+static uint32_t telemCRC(const uint8_t *block, uint16_t used)//CRC32 of the header up to the CRC field and the used payload
+{
+    crcBegin();
+    crcFeed(block, 36);
+    crcFeed(&block[TELEM_HEADER_BYTES], used);
+    return crcEnd();
+}
+
+static uint8_t *telemBlock(uint8_t buffer)//start of the block data, after the room left for the FRAM header
+{
+    return &telemBuffer[buffer][FRAM_HEADER_BYTES];
+}
+
+static void telemClose(void)//finishes the block being filled and moves on to the other buffer, drops the block if both are in use
+{
+    uint8_t *block = telemBlock(telemFill);
+    uint8_t other = telemFill ^ 1;
+
+    if(telemState[other] != TELEM_FREE)//FRAM fell behind, reuse this block
+    {
+        telemCount = 0;
+        telemUsed = 0;
+        return;
+    }
+    telemPut32(&block[0], telemSequence);
+    telemPut16(&block[14], telemCount);
+    telemPut16(&block[16], telemUsed);
+    telemPut32(&block[36], telemCRC(block, telemUsed));
+    telemSequence++;
+    if(telemSequence == 0xFFFFFFFF)
+    {
+        telemSequence = 0;
+    }
+    telemState[telemFill] = TELEM_FULL;
+    telemState[other] = TELEM_FILLING;
+    telemFill = other;
+    telemCount = 0;
+    telemUsed = 0;
+    telemIdleCount = 0;
+    telemetryService();
+}
+
+static bool telemScanRead(uint16_t slot, uint32_t *sequence)//logScan() slot reader, borrows the fill buffer before logging starts
+{
+    uint8_t *block = telemBlock(telemFill);
+    uint16_t used;
+
+    framRead(TELEM_BASE + ((uint32_t)slot * TELEM_BLOCK_BYTES), block, TELEM_BLOCK_BYTES);
+    *sequence = telemGet32(&block[0]);
+    used = telemGet16(&block[16]);
+    return (*sequence != 0xFFFFFFFF) && (used <= TELEM_PAYLOAD_BYTES) && (telemGet32(&block[36]) == telemCRC(block, used));
+}
+
+void telemetryInit(void)//finds the newest block, blocks for the FRAM scan so call it before the main loop
+{
+    logScan_t scan;
+
+    logScan(TELEM_BLOCKS, telemScanRead, &scan);
+    telemSlot = scan.next;
+    telemSequence = scan.sequence;
+    telemStored = scan.stored;
+}
+
+void telemetryLog(uint32_t timestamp, uint16_t rpm)//adds one filtered tach sample to the current block
+{
+    uint8_t *block = telemBlock(telemFill);
+    uint32_t time = timestamp >> TELEM_TIME_SHIFT;
+    int32_t change;
+
+    if(telemCount == 0)//keyframe
+    {
+        telemPut32(&block[4], millis());
+        telemPut32(&block[8], time);
+        telemPut16(&block[12], rpm);
+        telemPut16(&block[18], wheelVehicleSpeed());
+        telemPut64(&block[20], rtcStamp(timestamp));
+        telemPut16(&block[28], ecuGet(ECU_TPS));
+        telemPut16(&block[30], ecuGet(ECU_LAMBDA));
+        telemPut16(&block[32], ecuGet(ECU_COOLANT));
+        telemPut16(&block[34], ecuGet(ECU_OIL));
+    }
+    else
+    {
+        change = (int32_t)rpm - telemLastRpm;
+        telemUsed += telemVarint(&block[TELEM_HEADER_BYTES + telemUsed], (time - telemLastTime) & (0xFFFFFFFF >> TELEM_TIME_SHIFT));
+        telemUsed += telemVarint(&block[TELEM_HEADER_BYTES + telemUsed], ((uint32_t)change << 1) ^ (uint32_t)(change >> 31));//zigzag, small changes either way stay small
+    }
+    telemLastTime = time;
+    telemLastRpm = rpm;
+    telemCount++;
+    if(telemUsed > (TELEM_PAYLOAD_BYTES - TELEM_SAMPLE_MAX_BYTES))//next sample might not fit
+    {
+        telemClose();
+    }
+}
+
+void telemetryService(void)//retires the block that was on the wire and starts a full one, call on EVENT_FRAM_DONE
+{
+    uint8_t k;
+
+    for(k = 0; k < 2; k++)
+    {
+        if((telemState[k] == TELEM_WRITING) && telemDone[k])
+        {
+            telemState[k] = TELEM_FREE;
+        }
+    }
+    for(k = 0; k < 2; k++)
+    {
+        if(telemState[k] != TELEM_FULL)
+        {
+            continue;
+        }
+        telemDone[k] = 0;
+        if(framWriteBlock(TELEM_BASE + ((uint32_t)telemSlot * TELEM_BLOCK_BYTES), telemBuffer[k], TELEM_BLOCK_BYTES, &telemDone[k]))
+        {
+            telemState[k] = TELEM_WRITING;
+            telemSlot = (telemSlot + 1) % TELEM_BLOCKS;
+            if(telemStored < TELEM_BLOCKS)
+            {
+                telemStored++;
+            }
+            return;
+        }
+    }
+}
+
+void telemetryTick(void)//software timer callback every TELEM_IDLE_MS, writes out a block that has stopped filling
+{
+    if(telemCount && (telemCount == telemIdleCount))
+    {
+        telemClose();
+    }
+    telemIdleCount = telemCount;
+}
+
+uint32_t telemetryBlocks(void)//blocks stored in the FRAM
+{
+    return telemStored;
+}
@@ -0,0 +1,67 @@
+/*
+ * telemetry.h
+ *
+ * RPM trace logging to the FRAM. Filtered tach samples are collected into fixed size blocks
+ * in SRAM and each full block goes to the FRAM as one write enable and one DMA burst straight
+ * from the block buffer. Two block buffers alternate, one fills while the other is on the wire,
+ * so logging every tach edge (1.6 kHz at 12000 RPM) costs a few stores per sample and one
+ * ~200 us SPI burst per block.
+ *
+ * Samples are delta encoded, every block starts with a keyframe holding the first sample in
+ * full and the rest are varint coded differences from the sample before, so a steady trace
+ * packs into 2-3 bytes a sample instead of 6 and any block can be decoded on its own. Each
+ * block is protected by a CRC32 from the hardware CRC module, fed by DMA (crc.h).
+ *
+ * Blocks carry a sequence number like the shift log, the newest block is found by a binary search
+ * at start up (logscan.h) and the oldest block is overwritten once the region is full. A partly filled block
+ * is written out by telemetryTick() once the engine has stopped so the end of a session is kept.
+ * The vehicle speed, the wall clock time (rtc.h) and the main ECU values (ecu.h) ride along once
+ * per block, in the keyframe.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fram.h"
+#include "stats.h"
+
+//Telemetry settings
+#define TELEM_BASE 0x1000                           //first FRAM byte of the telemetry region
+#define TELEM_BLOCK_BYTES 256
+#define TELEM_BLOCKS ((STATS_BASE - TELEM_BASE) / TELEM_BLOCK_BYTES)
+#define TELEM_HEADER_BYTES 40
+#define TELEM_PAYLOAD_BYTES (TELEM_BLOCK_BYTES - TELEM_HEADER_BYTES)
+#define TELEM_SAMPLE_MAX_BYTES 8                    //5 byte time varint + 3 byte RPM varint
+#define TELEM_TIME_SHIFT 6                          //timestamps kept in 64 tach ticks (5.3 us) units
+#define TELEM_IDLE_MS 1000                          //telemetryTick() period, a block with no new samples for this long is written
+
+/*
+ * Block layout, little endian, packed:
+ *      0   uint32  sequence, 0xFFFFFFFF marks a blank block
+ *      4   uint32  millis() of the keyframe
+ *      8   uint32  keyframe tach timestamp >> TELEM_TIME_SHIFT
+ *      12  uint16  keyframe RPM
+ *      14  uint16  samples in the block, keyframe included
+ *      16  uint16  payload bytes used
+ *      18  uint16  vehicle speed at the keyframe, 0.1 km/h (wheel.h)
+ *      20  uint64  wall clock time of the keyframe sample, 32.32 Unix seconds UTC, 0 if unset (rtc.h)
+ *      28  int16   throttle position, 0.1 %, ECU values -32768 if not heard (ecu.h)
+ *      30  int16   lambda, 0.01
+ *      32  int16   coolant temperature, 0.1 deg
+ *      34  int16   oil pressure sender, mV
+ *      36  uint32  CRC32 of bytes 0-35 and the used payload
+ *      40  payload, per sample after the keyframe:
+ *              varint  timestamp difference (TELEM_TIME_SHIFT units)
+ *              varint  zigzag coded RPM difference
+ * Varints are 7 bits per byte, least significant group first, bit 7 set when more follow.
+ */
+
+void telemetryInit(void);
+void telemetryLog(uint32_t timestamp, uint16_t rpm);
+void telemetryService(void);
+void telemetryTick(void);
+uint32_t telemetryBlocks(void);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,177 @@
+/*
+ * timebase.c
+ *
+ * SysTick millisecond timebase and software timer list, see timebase.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "timebase.h"
+#include "clock.h"
+#include "events.h"
+#include "ramfunc.h"
+
+static volatile uint32_t tbMillis = 0;
+static volatile uint32_t tbTicksPerMs = CLOCK_MCLK_PER_MS;//SysTick clocks per ms, MCLK changes with clockSetIdle()
+static volatile uint32_t tbTicksPerUs = CLOCK_MCLK_HZ / 1000000;
+static volatile uint32_t tbNextExpiry = 0;//earliest expiry of any active timer
+static volatile bool tbArmed = 0;//0 when no timer is active
+static swTimer_t *tbTimers = 0;//active timers, only touched from the main loop
+
+void timebaseInit(void)//starts SysTick as a 1 ms periodic interrupt from MCLK
+{
+    SysTick->CTRL = 0;                              //stop the counter while it is set up
+    SysTick->LOAD = CLOCK_MCLK_PER_MS - 1;          //1 ms period
+    SysTick->VAL = 0;                               //clears the value
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk |    //MCLK
+            SysTick_CTRL_TICKINT_Msk |              //interrupt every period
+            SysTick_CTRL_ENABLE_Msk;
+}
+
+void timebaseSetClock(uint32_t mclk)//new SysTick reload after an MCLK change, call from clockSetIdle(), the tick in progress is cut short
+{
+    tbTicksPerMs = mclk / 1000;
+    tbTicksPerUs = mclk / 1000000;
+    SysTick->LOAD = tbTicksPerMs - 1;
+    SysTick->VAL = 0;                               //reload now, not after up to a whole tick at the old rate
+}
+
+RAMFUNC uint32_t millis(void)//ms since timebaseInit(), wraps after ~49 days
+{
+    return tbMillis;
+}
+
+RAMFUNC uint32_t micros(void)//us since timebaseInit(), wraps after ~71 minutes, also valid in ISRs above PRIORITY_TIMEBASE that run under 1 ms
+{
+    uint32_t ms;
+    uint32_t ticks;
+    uint32_t perMs = tbTicksPerMs;
+    bool pending;
+
+    do{//retry if the ms tick happened between the reads
+        ms = tbMillis;
+        ticks = SysTick->VAL;
+        pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    } while(ms != tbMillis);
+
+    if(pending && (ticks > (perMs / 2)))//counter reloaded but the SysTick ISR is held off by a higher priority ISR
+    {
+        ms++;
+    }
+
+    if(ticks >= perMs)//read across a timebaseSetClock()
+    {
+        ticks = perMs - 1;
+    }
+    return (ms * 1000) + ((perMs - 1 - ticks) / tbTicksPerUs);
+}
+
+void msDelay(uint32_t delay)//busy waits delay ms without touching SysTick, timers and ISRs keep running
+{
+    uint32_t start = tbMillis;
+
+    while((tbMillis - start) < delay);
+}
+
+static void swTimerRearm(void)//finds the earliest expiry of the active timers for the SysTick ISR
+{
+    swTimer_t *timer;
+    uint32_t now = tbMillis;
+    uint32_t soonest = 0xFFFFFFFF;
+
+    tbArmed = 0;//ISR ignores tbNextExpiry while it is being changed
+    for(timer = tbTimers; timer; timer = timer->next)
+    {
+        if((timer->expiry - now) < soonest)
+        {
+            soonest = timer->expiry - now;
+            tbNextExpiry = timer->expiry;
+        }
+    }
+    if(tbTimers)
+    {
+        tbArmed = 1;
+        if((int32_t)(tbMillis - tbNextExpiry) >= 0)//expired while rearming
+        {
+            eventPost(EVENT_TIMER);
+        }
+    }
+}
+
+void swTimerStart(swTimer_t *timer, uint32_t delay, uint32_t period, void (*callback)(void))//(re)starts timer to call callback after delay ms, then every period ms if period is not 0
+{
+    if(!timer->active)
+    {
+        timer->next = tbTimers;
+        tbTimers = timer;
+    }
+    timer->expiry = tbMillis + delay;
+    timer->period = period;
+    timer->callback = callback;
+    timer->active = 1;
+    swTimerRearm();
+}
+
+void swTimerStop(swTimer_t *timer)//cancels timer, nothing happens if it is not running
+{
+    swTimer_t **link;
+
+    for(link = &tbTimers; *link; link = &(*link)->next)
+    {
+        if(*link == timer)
+        {
+            *link = timer->next;
+            break;
+        }
+    }
+    timer->active = 0;
+    swTimerRearm();
+}
+
+bool swTimerActive(const swTimer_t *timer)//1 while a one-shot has not fired yet or a periodic timer is running
+{
+    return timer->active;
+}
+
+void swTimerService(void)//runs callbacks of every expired timer, call from the main loop on EVENT_TIMER
+{
+    swTimer_t **link = &tbTimers;
+    swTimer_t *timer;
+    uint32_t now = tbMillis;
+
+    while(*link)
+    {
+        timer = *link;
+        if((int32_t)(now - timer->expiry) < 0)//not due yet
+        {
+            link = &timer->next;
+            continue;
+        }
+
+        if(timer->period)//periodic, keep the phase even if the service ran late
+        {
+            timer->expiry += timer->period;
+            link = &timer->next;
+        }
+        else//one-shot, unlink before the callback so it may restart itself
+        {
+            *link = timer->next;
+            timer->active = 0;
+        }
+        if(timer->callback)
+        {
+            timer->callback();
+        }
+    }
+    swTimerRearm();
+}
+
+RAMFUNC void SysTick_Handler(void)//1 ms tick
+{
+    tbMillis++;
+    if(tbArmed && ((int32_t)(tbMillis - tbNextExpiry) >= 0))
+    {
+        tbArmed = 0;//once per expiry, swTimerService() rearms
+        eventPost(EVENT_TIMER);
+    }
+}
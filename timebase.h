@@ -0,0 +1,38 @@
+/*
+ * timebase.h
+ *
+ * Free-running 1 ms SysTick timebase and software timers.
+ * SysTick is never reloaded after timebaseInit(), so any number of delays and timers can run
+ * at once. Software timers are owned by the caller and linked into one list; the SysTick ISR
+ * only compares the tick count against the earliest expiry and posts EVENT_TIMER, callbacks
+ * run from swTimerService() in the main loop.
+ * SysTick runs from MCLK, timebaseSetClock() keeps the 1 ms tick when clockSetIdle() changes it.
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct swTimer
+{
+    uint32_t expiry;                //millis() value this timer fires at
+    uint32_t period;                //ms between periodic callbacks, 0 for one-shot
+    void (*callback)(void);
+    bool active;
+    struct swTimer *next;
+} swTimer_t;
+
+void timebaseInit(void);
+void timebaseSetClock(uint32_t mclk);
+uint32_t millis(void);
+uint32_t micros(void);
+void msDelay(uint32_t delay);
+
+void swTimerStart(swTimer_t *timer, uint32_t delay, uint32_t period, void (*callback)(void));
+void swTimerStop(swTimer_t *timer);
+bool swTimerActive(const swTimer_t *timer);
+void swTimerService(void);
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,45 @@
+/*
+ * watchdog.c
+ *
+ * Main loop watchdog and reset cause, see watchdog.h.
+ */
+
+#include "driverlib_files/driverlib.h"
+#include "msp.h"
+#include "watchdog.h"
+
+#define WDOG_RESET_SRC RESET_SRC_1  //soft reset source 1, WDT_A time-out
+
+static uint8_t wdogCheckIns = 0;//only touched from the main loop
+
+bool watchdogWarmBoot(void)//1 if this reset was a watchdog time-out, clears the reset flags, call first in main()
+{
+    bool warm = (MAP_ResetCtl_getSoftResetSource() & WDOG_RESET_SRC) != 0;
+
+    MAP_ResetCtl_clearSoftResetSource(0xFFFF);
+    MAP_ResetCtl_clearHardResetSource(0xFFFF);
+    return warm;
+}
+
+void watchdogInit(void)//starts the WDT from ACLK, call once everything is initialised and just before the main loop
+{
+    MAP_WDT_A_holdTimer();
+    MAP_WDT_A_setTimeoutReset(SYSCTL_SOFT_RESET);
+    MAP_WDT_A_initWatchdogTimer(WDT_A_CLOCKSOURCE_ACLK, WDOG_ITERATIONS);
+    wdogCheckIns = 0;
+    MAP_WDT_A_startTimer();
+}
+
+void watchdogCheckIn(uint8_t task)
+{
+    wdogCheckIns |= task;
+}
+
+void watchdogService(void)//kicks the WDT once every task has checked in, call every main loop pass
+{
+    if((wdogCheckIns & WDOG_TASKS_ALL) == WDOG_TASKS_ALL)
+    {
+        MAP_WDT_A_clearTimer();
+        wdogCheckIns = 0;
+    }
+}
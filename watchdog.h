@@ -0,0 +1,33 @@
+/*
+ * watchdog.h
+ *
+ * WDT_A supervision of the main loop. Every task that has to keep running checks in with
+ * watchdogCheckIn(), and the watchdog is only kicked once all of WDOG_TASKS_ALL have checked in
+ * since the last kick. A stuck polled wait, a callback that never returns or an interrupt storm
+ * that starves the main loop lets the WDT time out.
+ * The timeout is a soft reset, which leaves the clock system and the peripherals running, and
+ * watchdogWarmBoot() tells main() to take the warm restart path (see clockInit(), digitsInit()).
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Watchdog settings
+#define WDOG_ITERATIONS WDT_A_CLOCKITERATIONS_32K//ACLK periods to time out, 1 s, well over the 100 ms status timer
+
+//Tasks that check in
+#define WDOG_TASK_LOOP 0x01         //main loop pass
+#define WDOG_TASK_TIMERS 0x02       //software timers serviced, SysTick and the timebase are alive
+#define WDOG_TASK_DISPLAY 0x04      //4-digit display refresh
+#define WDOG_TASK_STATUS 0x08       //bluetooth status frame
+#define WDOG_TASKS_ALL (WDOG_TASK_LOOP | WDOG_TASK_TIMERS | WDOG_TASK_DISPLAY | WDOG_TASK_STATUS)
+
+bool watchdogWarmBoot(void);
+void watchdogInit(void);
+void watchdogCheckIn(uint8_t task);
+void watchdogService(void);
+
+#endif /* WATCHDOG_H_ */
@@ -0,0 +1,138 @@
+/*
+ * wheel.c
+ *
+ * Wheel speed capture and gear ratio matching, see wheel.h.
+ */
+
+#include "wheel.h"
+#include "meter.h"
+#include "ramfunc.h"
+
+//Overall engine to wheel ratio x100 for gears 1-6, CBR600RR box (2.111 primary) with a 14/40 final drive
+static const uint16_t wheelGearRatios[METER_GEARS - 1] = {1659, 1206, 1005, 871, 787, 729};
+
+#define WHEEL_STAMPS (WHEEL_TEETH + 1)//first and last edge of one revolution
+
+static volatile uint32_t wheelStamps[WHEEL_CHANNELS][WHEEL_STAMPS];//tachNow() of the last WHEEL_STAMPS edges
+static volatile uint8_t wheelEdges[WHEEL_CHANNELS];//edges since the wheel started turning, saturates at WHEEL_STAMPS
+static volatile uint8_t wheelNext[WHEEL_CHANNELS];//wheelStamps slot the next edge goes in, the oldest stamp
+static uint32_t wheelRatioFiltered = 0;//ratio << WHEEL_RATIO_SHIFT
+static uint8_t wheelRatioCount = 0;//ratios in the filter, up to WHEEL_RATIO_SETTLE
+
+RAMFUNC void wheelEdge(uint8_t channel)//falling edge on a wheel input, runs in the PORT6 interrupt
+{
+    uint32_t now = tachNow();
+    uint8_t next = wheelNext[channel];
+    uint8_t last = (next + WHEEL_STAMPS - 1) % WHEEL_STAMPS;
+    uint32_t gap = now - wheelStamps[channel][last];
+
+    if(wheelEdges[channel] && (gap < WHEEL_MIN_TICKS))//noise, keep timing from the real edge
+    {
+        return;
+    }
+    if(gap > WHEEL_TIMEOUT_TICKS)//wheel was stopped, the old stamps are not part of this revolution
+    {
+        wheelEdges[channel] = 0;
+    }
+    wheelStamps[channel][next] = now;
+    wheelNext[channel] = (next + 1) % WHEEL_STAMPS;
+    if(wheelEdges[channel] < WHEEL_STAMPS)
+    {
+        wheelEdges[channel]++;
+    }
+}
+
+uint32_t wheelPeriod(uint8_t channel)//ticks per wheel revolution, 0 if the wheel is stopped or not measured yet
+{
+    uint32_t oldest;
+    uint32_t newest;
+    uint8_t next;
+    uint8_t edges;
+
+    do{//retry if an edge came between the reads
+        next = wheelNext[channel];
+        edges = wheelEdges[channel];
+        oldest = wheelStamps[channel][next];
+        newest = wheelStamps[channel][(next + WHEEL_STAMPS - 1) % WHEEL_STAMPS];
+    } while(next != wheelNext[channel]);
+
+    if((edges < WHEEL_STAMPS) || ((tachNow() - newest) > WHEEL_TIMEOUT_TICKS))//not a whole revolution since it started turning, or stopped
+    {
+        return 0;
+    }
+    return newest - oldest;
+}
+
+uint16_t wheelSpeed(uint8_t channel)//0.1 km/h
+{
+    uint32_t period = wheelPeriod(channel);
+    uint32_t speed;
+
+    if(!period)
+    {
+        return 0;
+    }
+    speed = WHEEL_SPEED_NUMERATOR / period;
+    return (speed > 0xFFFF) ? 0xFFFF : (uint16_t)speed;
+}
+
+uint16_t wheelVehicleSpeed(void)//0.1 km/h, front wheel since it does not spin under power, rear if the front sensor is silent
+{
+    uint16_t speed = wheelSpeed(WHEEL_FRONT);
+
+    return speed ? speed : wheelSpeed(WHEEL_REAR);
+}
+
+uint16_t wheelRatio(uint32_t tachPeriod)//engine to rear wheel revolutions x100 for a filtered tach period, 0 if either is not turning
+{
+    uint32_t period = wheelPeriod(WHEEL_REAR);
+    uint32_t ratio;
+
+    if(!period || !tachPeriod || ((WHEEL_SPEED_NUMERATOR / period) < WHEEL_MIN_SPEED))
+    {
+        return 0;
+    }
+    ratio = (uint32_t)(((uint64_t)period * 100) / ((uint64_t)tachPeriod * TACH_PULSES_PER_REV));
+    return (ratio > 0xFFFF) ? 0xFFFF : (uint16_t)ratio;
+}
+
+uint8_t wheelGear(uint32_t tachPeriod)//gear the smoothed ratio matches, 0 for none (clutch in, neutral, wheelspin, too slow, settling), call at a low fixed rate
+{
+    uint16_t ratio = wheelRatio(tachPeriod);
+    uint32_t error;
+    uint8_t gear;
+
+    if(!ratio)
+    {
+        wheelGearReset();
+        return 0;
+    }
+    if(!wheelRatioCount)
+    {
+        wheelRatioFiltered = (uint32_t)ratio << WHEEL_RATIO_SHIFT;
+    }
+    else
+    {
+        wheelRatioFiltered += ratio - (wheelRatioFiltered >> WHEEL_RATIO_SHIFT);
+    }
+    if(wheelRatioCount < WHEEL_RATIO_SETTLE)
+    {
+        wheelRatioCount++;
+        return 0;
+    }
+    ratio = wheelRatioFiltered >> WHEEL_RATIO_SHIFT;
+    for(gear = 0; gear < (METER_GEARS - 1); gear++)
+    {
+        error = (ratio > wheelGearRatios[gear]) ? (ratio - wheelGearRatios[gear]) : (wheelGearRatios[gear] - ratio);
+        if((error * 100) <= ((uint32_t)wheelGearRatios[gear] * WHEEL_GEAR_TOLERANCE))
+        {
+            return gear + 1;
+        }
+    }
+    return 0;
+}
+
+void wheelGearReset(void)//restarts the ratio filter, call when a shift starts
+{
+    wheelRatioCount = 0;
+}
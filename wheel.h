@@ -0,0 +1,50 @@
+/*
+ * wheel.h
+ *
+ * Wheel speed from the two spare hall effect inputs on P6.2 and P6.6 (falling edge, one per
+ * tooth of the sensor ring). The PORT6 ISR stamps each edge with tachNow(), the TIMER_A0
+ * extended timer the tach is measured on, so the wheel and engine periods share one time base
+ * and the ISR only stores a subtraction. Speed is one integer divide by a folded constant when
+ * it is read, in 0.1 km/h.
+ * Speed is measured over the last WHEEL_TEETH edges, a whole revolution, so uneven spacing of
+ * the sensor ring teeth cancels out.
+ * Gear estimate: the ratio of engine to rear wheel revolutions (x100, filtered RPM from
+ * tachFilter() over the rear wheel revolution period) is smoothed by a 1/2^WHEEL_RATIO_SHIFT IIR at
+ * the caller's low rate and matched against the gearbox table in wheel.c. wheelGearReset()
+ * restarts the filter when a shift changes the ratio.
+ */
+
+#ifndef WHEEL_H_
+#define WHEEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tach.h"
+
+//Wheel settings
+#define WHEEL_FRONT 0               //P6.2
+#define WHEEL_REAR 1                //P6.6, driven wheel, used for the gear estimate
+#define WHEEL_CHANNELS 2
+#define WHEEL_TEETH 4               //edges per wheel revolution
+#define WHEEL_CIRCUMFERENCE_MM 1300 //rolling circumference, 18 x 6.0-10 tyre
+#define WHEEL_MIN_US 1000           //shorter periods are noise, above 300 km/h with 4 teeth
+#define WHEEL_TIMEOUT_MS 500        //no edge for this long reads as stopped, ~2.3 km/h
+#define WHEEL_GEAR_TOLERANCE 3      //percent off a gear ratio that still counts as that gear, under half the 5th to 6th step
+#define WHEEL_MIN_SPEED 50          //0.1 km/h, no gear estimate below this
+#define WHEEL_RATIO_SHIFT 2         //ratio IIR, 1/4 of each new ratio
+#define WHEEL_RATIO_SETTLE 4        //ratios in the filter before it gives an estimate
+
+#define WHEEL_MIN_TICKS ((uint32_t)TACH_COUNT_HZ / 1000000 * WHEEL_MIN_US)
+#define WHEEL_TIMEOUT_TICKS ((uint32_t)TACH_COUNT_HZ / 1000 * WHEEL_TIMEOUT_MS)
+//0.1 km/h = (mm per revolution * ticks per second * 36 / 1000) / revolution period ticks
+#define WHEEL_SPEED_NUMERATOR ((uint32_t)(((uint64_t)WHEEL_CIRCUMFERENCE_MM * TACH_COUNT_HZ * 36) / 1000))
+
+void wheelEdge(uint8_t channel);
+uint32_t wheelPeriod(uint8_t channel);
+uint16_t wheelSpeed(uint8_t channel);
+uint16_t wheelVehicleSpeed(void);
+uint16_t wheelRatio(uint32_t tachPeriod);
+uint8_t wheelGear(uint32_t tachPeriod);
+void wheelGearReset(void);
+
+#endif /* WHEEL_H_ */